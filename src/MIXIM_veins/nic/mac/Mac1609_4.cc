@@ -25,6 +25,7 @@
 #include "AddressingInterface.h"
 #include "MacToNetwControlInfo.h"
 #include "baseAppl/ApplToPhyControlInfo.h"
+#include "global/HotPathCounters.h"
 
 namespace Veins {
 
@@ -167,6 +168,8 @@ void Mac1609_4::finish()
 
 void Mac1609_4::handleSelfMsg(omnetpp::cMessage* msg)
 {
+    HOTPATH_SCOPE("Mac1609_4::handleSelfMsg");
+
     if (msg == nextChannelSwitch)
     {
         ASSERT(useSCH);
@@ -338,6 +341,8 @@ void Mac1609_4::handleUpperMsg(omnetpp::cMessage* msg)
 
 void Mac1609_4::handleLowerMsg(omnetpp::cMessage* msg)
 {
+    HOTPATH_SCOPE("Mac1609_4::handleLowerMsg");
+
     Mac80211Pkt* macPkt = static_cast<Mac80211Pkt*>(msg);
     ASSERT(macPkt);
 
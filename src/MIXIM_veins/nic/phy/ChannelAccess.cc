@@ -33,6 +33,7 @@
 #include "MIXIM_veins/connectionManager/BaseConnectionManager.h"
 #include "msg/AirFrame11p_serial.h"
 #include "MIXIM_veins/nic/mac/MacToPhyControlInfo.h"
+#include "global/HotPathCounters.h"
 
 const simsignalwrap_t ChannelAccess::mobilityStateChangedSignal = simsignalwrap_t(MIXIM_SIGNAL_MOBILITY_CHANGE_NAME);
 
@@ -90,6 +91,8 @@ void ChannelAccess::receiveSignal(omnetpp::cComponent *source, omnetpp::simsigna
 
 void ChannelAccess::sendToChannel(omnetpp::cPacket *msg)
 {
+    HOTPATH_SCOPE("ChannelAccess::sendToChannel");
+
     const NicEntry::GateList& gateList = cc->getGateList(getParentModule()->getId());
     NicEntry::GateList::const_iterator i = gateList.begin();
 
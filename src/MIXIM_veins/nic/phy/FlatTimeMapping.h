@@ -0,0 +1,311 @@
+/*
+ * FlatTimeMapping.h
+ *
+ * Time-only Mapping stored as a flat sorted array of (time, value) points.
+ */
+
+#ifndef FLATTIMEMAPPING_H_
+#define FLATTIMEMAPPING_H_
+
+#include <vector>
+#include <utility>
+
+#include <boost/serialization/vector.hpp>
+
+#include "global/MiXiMDefs.h"
+#include "MappingBase.h"
+
+/**
+ * @brief Sorted std::vector of (time, value) pairs which provides the subset
+ * of the std::map interface the Interpolators of Interpolation.h rely on.
+ *
+ * Appending at the end (the common case when building signals) has constant
+ * complexity, lookups are binary searches on contiguous memory.
+ *
+ * @ingroup mappingDetails
+ */
+template<class V>
+class FlatTimeMap : public std::vector< std::pair<omnetpp::simtime_t, V> >
+{
+public:
+
+    typedef std::vector< std::pair<omnetpp::simtime_t, V> > base_class_type;
+    typedef omnetpp::simtime_t                               key_type;
+    typedef V                                                mapped_type;
+    typedef typename base_class_type::value_type             value_type;
+    typedef typename base_class_type::iterator               iterator;
+    typedef typename base_class_type::const_iterator         const_iterator;
+    typedef PairLess<value_type, key_type>                   comparator_type;
+
+public:
+
+    const_iterator upper_bound(const key_type& pos) const {
+        return std::upper_bound(this->begin(), this->end(), pos, comparator_type());
+    }
+
+    iterator upper_bound(const key_type& pos) {
+        return std::upper_bound(this->begin(), this->end(), pos, comparator_type());
+    }
+
+    /** @brief Returns the index of the first entry whose key is bigger than pos.*/
+    std::size_t upperIndex(const key_type& pos) const {
+        return upper_bound(pos) - this->begin();
+    }
+
+    /** @brief Returns the value stored at pos. Adds a new entry if there is none.*/
+    mapped_type& findOrInsert(const key_type& pos) {
+        if(this->empty() || this->back().first < pos) {
+            this->push_back(value_type(pos, mapped_type()));
+            return this->back().second;
+        }
+
+        iterator it = std::lower_bound(this->begin(), this->end(), pos, comparator_type());
+        if(it == this->end() || pos < it->first)
+            it = this->insert(it, value_type(pos, mapped_type()));
+
+        return it->second;
+    }
+};
+
+
+/**
+ * @brief MappingIterator for FlatTimeMapping.
+ *
+ * Works like TimeMappingIterator but keeps indices instead of container
+ * iterators, so that inserting through "setValue()" does not invalidate it.
+ *
+ * @ingroup mapping
+ */
+template<template <typename> class Interpolator>
+class FlatTimeMappingIterator : public MappingIterator
+{
+protected:
+
+    typedef FlatTimeMap<argument_value_t>  container_type;
+    typedef Interpolator<container_type>   interpolator_type;
+
+    container_type&          entries;
+    const interpolator_type& interpolate;
+
+    /** @brief Index of the first entry with a key bigger than the current position.*/
+    std::size_t              right;
+
+    omnetpp::simtime_t       key;
+
+    Argument                 position;
+    Argument                 nextPosition;
+
+    /** @brief see TimeMappingIterator::isStepMapping */
+    bool                     isStepMapping;
+    bool                     atPreStep;
+
+protected:
+
+    omnetpp::simtime_t nextKey() const {
+        if(hasNext())
+            return entries[right].first;
+        else
+            return key + 1;
+    }
+
+    void updateNextPos() {
+        omnetpp::simtime_t t = nextKey();
+
+        if(isStepMapping && !atPreStep)
+            t.setRaw(t.raw() - 1);
+
+        nextPosition.setTime(t);
+    }
+
+    void moveTo(omnetpp::simtime_t_cref pos) {
+        key = pos;
+        position.setTime(key);
+    }
+
+public:
+
+    FlatTimeMappingIterator(container_type& entries, const interpolator_type& intpl):
+        entries(entries), interpolate(intpl), right(0), key(), isStepMapping(intpl.isStepping()), atPreStep(false) {
+        jumpToBegin();
+    }
+
+    FlatTimeMappingIterator(container_type& entries, const interpolator_type& intpl, omnetpp::simtime_t_cref pos):
+        entries(entries), interpolate(intpl), right(0), key(), isStepMapping(intpl.isStepping()), atPreStep(false) {
+        jumpToBegin();
+        right = entries.upperIndex(pos);
+        moveTo(pos);
+        updateNextPos();
+    }
+
+    virtual void jumpTo(const Argument& pos) {
+        atPreStep = false;
+        right = entries.upperIndex(pos.getTime());
+        moveTo(pos.getTime());
+        nextPosition.setTime(nextKey());
+    }
+
+    virtual void iterateTo(const Argument& pos) {
+        atPreStep = false;
+        while(right < entries.size() && !(pos.getTime() < entries[right].first))
+            ++right;
+        moveTo(pos.getTime());
+        nextPosition.setTime(nextKey());
+    }
+
+    virtual void next() {
+        if(isStepMapping && !atPreStep) {
+            omnetpp::simtime_t t = nextPosition.getTime();
+            while(right < entries.size() && !(t < entries[right].first))
+                ++right;
+            moveTo(t);
+            atPreStep = true;
+        } else {
+            if(hasNext()) {
+                moveTo(entries[right].first);
+                ++right;
+            } else
+                moveTo(key + 1);
+            atPreStep = false;
+        }
+        updateNextPos();
+    }
+
+    virtual bool inRange() const {
+        if(entries.empty())
+            return false;
+
+        return !(key < entries.front().first) && !(entries.back().first < key);
+    }
+
+    virtual const Argument& getPosition() const { return position; }
+
+    virtual const Argument& getNextPosition() const { return nextPosition; }
+
+    virtual argument_value_t getValue() const {
+        return *interpolate(entries.begin(), entries.end(), key, entries.begin() + right);
+    }
+
+    virtual void jumpToBegin() {
+        atPreStep = false;
+        right = 0;
+        if(!entries.empty()) {
+            moveTo(entries[0].first);
+            ++right;
+        } else
+            moveTo(omnetpp::simtime_t());
+        updateNextPos();
+    }
+
+    virtual bool hasNext() const { return right < entries.size(); }
+
+    virtual void setValue(argument_value_cref_t value) {
+        if(right > 0 && entries[right - 1].first == key) {
+            entries[right - 1].second = value;
+        } else {
+            entries.insert(entries.begin() + right, std::make_pair(key, value));
+            ++right;
+        }
+    }
+};
+
+
+/**
+ * @brief Mapping with only time as domain whose key entries are stored in a
+ * flat sorted array instead of a std::map.
+ *
+ * Besides the virtual Mapping interface it provides non-virtual, inlineable
+ * access to its key entries. MappingUtils uses it to combine two time-only
+ * mappings by merging their arrays directly without any Argument or
+ * iterator objects (see MappingUtils::applyElementWiseOperator()).
+ *
+ * MappingUtils::createMapping() returns this type for linear interpolated
+ * time-only mappings.
+ *
+ * @ingroup mapping
+ */
+template<template <typename> class Interpolator>
+class FlatTimeMapping : public Mapping
+{
+public:
+
+    typedef FlatTimeMap<argument_value_t>  container_type;
+    typedef Interpolator<container_type>   interpolator_type;
+
+protected:
+
+    /** @brief Stores the key-entries defining the function.*/
+    container_type    entries;
+
+    interpolator_type interpolate;
+
+    friend class boost::serialization::access;
+
+    template<class Archive>
+    void serialize(Archive & archive, const unsigned int version)
+    {
+        archive & entries;
+    }
+
+public:
+
+    FlatTimeMapping():
+        Mapping(), entries(), interpolate() {}
+
+    FlatTimeMapping(argument_value_cref_t outOfRangeVal):
+        Mapping(), entries(), interpolate(outOfRangeVal) {}
+
+    virtual Mapping* clone() const { return new FlatTimeMapping<Interpolator>(*this); }
+
+    /** @name non-virtual access to the key entries */
+    /*@{*/
+    std::size_t size() const { return entries.size(); }
+
+    bool empty() const { return entries.empty(); }
+
+    void reserve(std::size_t n) { entries.reserve(n); }
+
+    omnetpp::simtime_t_cref timeAt(std::size_t i) const { return entries[i].first; }
+
+    argument_value_cref_t valueAt(std::size_t i) const { return entries[i].second; }
+
+    /** @brief Value at time t. Logarithmic complexity.*/
+    argument_value_t getValueAt(omnetpp::simtime_t_cref t) const {
+        return *interpolate(entries.begin(), entries.end(), t, entries.upper_bound(t));
+    }
+
+    /** @brief Value at time t, where 'upper' is the index of the first entry bigger than t. Constant complexity.*/
+    argument_value_t getValueAt(omnetpp::simtime_t_cref t, std::size_t upper) const {
+        return *interpolate(entries.begin(), entries.end(), t, entries.begin() + upper);
+    }
+
+    /** @brief Appends a key entry. t has to be bigger than the last key entry.*/
+    void append(omnetpp::simtime_t_cref t, argument_value_cref_t value) {
+        assert(entries.empty() || entries.back().first < t);
+        entries.push_back(std::make_pair(t, value));
+    }
+
+    const interpolator_type& getInterpolator() const { return interpolate; }
+    /*@}*/
+
+    virtual argument_value_t getValue(const Argument& pos) const {
+        return getValueAt(pos.getTime());
+    }
+
+    virtual void setValue(const Argument& pos, argument_value_cref_t value) {
+        entries.findOrInsert(pos.getTime()) = value;
+    }
+
+    virtual void appendValue(const Argument& pos, argument_value_cref_t value) {
+        entries.findOrInsert(pos.getTime()) = value;
+    }
+
+    virtual MappingIterator* createIterator() {
+        return new FlatTimeMappingIterator<Interpolator>(entries, interpolate);
+    }
+
+    virtual MappingIterator* createIterator(const Argument& pos) {
+        return new FlatTimeMappingIterator<Interpolator>(entries, interpolate, pos.getTime());
+    }
+};
+
+#endif /* FLATTIMEMAPPING_H_ */
@@ -42,6 +42,8 @@ public:
 		// used by 11p
         CHANNEL_IDLE,
         CHANNEL_BUSY,
+        /** @brief AirFrames due at the same point in time */
+        AIR_FRAME_BATCH,
 	};
 
 public:
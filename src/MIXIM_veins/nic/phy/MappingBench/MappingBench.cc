@@ -0,0 +1,211 @@
+/****************************************************************************/
+/// @file    MappingBench.cc
+/// @author  Mani Amoozadeh <maniam@ucdavis.edu>
+/// @author  second author name
+/// @date    October 2017
+///
+/****************************************************************************/
+// VENTOS, Vehicular Network Open Simulator; see http:?
+// Copyright (C) 2013-2015
+/****************************************************************************/
+//
+// This file is part of VENTOS.
+// VENTOS is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+// Micro-benchmark of MappingUtils::add and MappingUtils::divide on time-only
+// mappings, as used by the deciders for RSSI and SINR.
+//
+// Each operation is run on two linear interpolated mappings with the same
+// key entries, once stored as TimeMapping<Linear> (generic iterator based
+// path) and once as FlatTimeMapping<Linear> (what MappingUtils::createMapping
+// returns). The results of both paths are compared at every key entry.
+//
+// usage: MappingBench [-n key entries,...] [-r repetitions]
+
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <chrono>
+#include <random>
+
+#include "MIXIM_veins/nic/phy/MappingUtils.h"
+
+typedef Mapping* (*mappingOp_t)(const ConstMapping&, const ConstMapping&);
+
+typedef struct benchResult
+{
+    double genericNs;   // ns per operation
+    double flatNs;
+    double maxDiff;     // largest difference between the results of both paths
+} benchResult_t;
+
+
+// key entries of a signal: the times at which the received power changes
+std::vector<omnetpp::simtime_t> makeKeyTimes(int count, std::mt19937 &gen)
+{
+    std::uniform_real_distribution<double> gap(1e-6, 1e-4);
+
+    std::vector<omnetpp::simtime_t> times;
+    double t = 0;
+    for(int i = 0; i < count; i++)
+    {
+        t += gap(gen);
+        times.push_back(t);
+    }
+
+    return times;
+}
+
+
+void fill(Mapping &m, const std::vector<omnetpp::simtime_t> &times, std::mt19937 &gen)
+{
+    std::uniform_real_distribution<double> power(1e-12, 1e-6);
+
+    for(auto &t : times)
+        m.setValue(Argument(t), power(gen));
+}
+
+
+double nsPerOp(mappingOp_t op, const ConstMapping &f1, const ConstMapping &f2, int repetitions)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    for(int r = 0; r < repetitions; r++)
+        delete op(f1, f2);
+
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / repetitions;
+}
+
+
+benchResult_t run(mappingOp_t op, int keyCount, int repetitions, unsigned int seed)
+{
+    std::mt19937 gen(seed);
+
+    // both operands have their own key entries, so the merge sees interleaved times
+    std::vector<omnetpp::simtime_t> times1 = makeKeyTimes(keyCount, gen);
+    std::vector<omnetpp::simtime_t> times2 = makeKeyTimes(keyCount, gen);
+
+    TimeMapping<Linear> generic1, generic2;
+    FlatTimeMapping<Linear> flat1, flat2;
+
+    std::mt19937 values1(seed + 1), values2(seed + 2);
+    fill(generic1, times1, values1);
+    fill(generic2, times2, values2);
+
+    values1.seed(seed + 1);
+    values2.seed(seed + 2);
+    fill(flat1, times1, values1);
+    fill(flat2, times2, values2);
+
+    benchResult_t result;
+    result.genericNs = nsPerOp(op, generic1, generic2, repetitions);
+    result.flatNs = nsPerOp(op, flat1, flat2, repetitions);
+
+    Mapping *genericRes = op(generic1, generic2);
+    Mapping *flatRes = op(flat1, flat2);
+
+    result.maxDiff = 0;
+    for(auto *times : {&times1, &times2})
+    {
+        for(auto &t : *times)
+        {
+            double a = genericRes->getValue(Argument(t));
+            double b = flatRes->getValue(Argument(t));
+            result.maxDiff = std::max(result.maxDiff, std::fabs(a - b));
+        }
+    }
+
+    delete genericRes;
+    delete flatRes;
+
+    return result;
+}
+
+
+int main(int argc, char *argv[])
+{
+    std::string keyCounts = "4,16,64,256";
+    int repetitions = 20000;
+
+    for(int i = 1; i < argc; i++)
+    {
+        std::string opt = argv[i];
+        if(i + 1 >= argc)
+        {
+            fprintf(stderr, "usage: %s [-n key entries,...] [-r repetitions] \n", argv[0]);
+            return 1;
+        }
+
+        if(opt == "-n")
+            keyCounts = argv[++i];
+        else if(opt == "-r")
+            repetitions = atoi(argv[++i]);
+        else
+        {
+            fprintf(stderr, "unknown option '%s' \n", opt.c_str());
+            return 1;
+        }
+    }
+
+    if(repetitions <= 0)
+    {
+        fprintf(stderr, "repetitions should be > 0 \n");
+        return 1;
+    }
+
+    // same precision as the simulation (default simtime-scale of OMNeT++)
+    omnetpp::SimTime::setScaleExp(-12);
+
+    printf("%-10s", "operation");
+    printf("%-8s", "keys");
+    printf("%-14s", "generic(ns)");
+    printf("%-14s", "flat(ns)");
+    printf("%-10s", "speedup");
+    printf("%-12s \n", "maxDiff");
+
+    mappingOp_t add = &MappingUtils::add;
+    mappingOp_t divide = &MappingUtils::divide;
+    std::vector<std::pair<std::string, mappingOp_t>> ops = {{"add", add}, {"divide", divide}};
+
+    for(auto &op : ops)
+    {
+        std::istringstream counts(keyCounts);
+        std::string count;
+        while(std::getline(counts, count, ','))
+        {
+            int keyCount = atoi(count.c_str());
+            if(keyCount <= 0)
+            {
+                fprintf(stderr, "invalid number of key entries '%s' \n", count.c_str());
+                return 1;
+            }
+
+            benchResult_t r = run(op.second, keyCount, repetitions, 1);
+
+            printf("%-10s", op.first.c_str());
+            printf("%-8d", keyCount);
+            printf("%-14.1f", r.genericNs);
+            printf("%-14.1f", r.flatNs);
+            printf("%-10.2f", r.genericNs / r.flatNs);
+            printf("%-12g \n", r.maxDiff);
+        }
+    }
+
+    return 0;
+}
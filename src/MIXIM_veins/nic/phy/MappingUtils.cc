@@ -6,6 +6,7 @@
  */
 
 #include "MappingUtils.h"
+#include "global/HotPathCounters.h"
 
 
 FilledUpMappingIterator::FilledUpMappingIterator(FilledUpMapping& mapping):
@@ -83,7 +84,7 @@ Mapping* MappingUtils::createMapping(const DimensionSet& domain, Mapping::Interp
     if(domain.size() == 1){
         switch(intpl){
         case Mapping::LINEAR:
-            return new TimeMapping<Linear>();
+            return new FlatTimeMapping<Linear>();
             break;
         case Mapping::NEAREST:
             return new TimeMapping<Nearest>();
@@ -115,7 +116,7 @@ Mapping* MappingUtils::createMapping(Mapping::argument_value_cref_t outOfRangeVa
     if(domain.size() == 1){
         switch(intpl){
         case Mapping::LINEAR:
-            return new TimeMapping<Linear>(outOfRangeVal);
+            return new FlatTimeMapping<Linear>(outOfRangeVal);
             break;
         case Mapping::NEAREST:
             return new TimeMapping<Nearest>(outOfRangeVal);
@@ -143,42 +144,50 @@ Mapping* MappingUtils::createMapping(Mapping::argument_value_cref_t outOfRangeVa
 
 Mapping* MappingUtils::multiply(const ConstMapping &f1, const ConstMapping &f2)
 {
+    HOTPATH_SCOPE("MappingUtils::multiply");
     return applyElementWiseOperator(f1, f2, std::multiplies<Mapping::argument_value_t>());
 }
 
 Mapping* MappingUtils::divide(const ConstMapping &f1, const ConstMapping &f2)
 {
+    HOTPATH_SCOPE("MappingUtils::divide");
     return applyElementWiseOperator(f1, f2, std::divides<Mapping::argument_value_t>());
 }
 
 Mapping* MappingUtils::add(const ConstMapping &f1, const ConstMapping &f2)
 {
+    HOTPATH_SCOPE("MappingUtils::add");
     return applyElementWiseOperator(f1, f2, std::plus<Mapping::argument_value_t>());
 }
 
 Mapping* MappingUtils::subtract(const ConstMapping &f1, const ConstMapping &f2)
 {
+    HOTPATH_SCOPE("MappingUtils::subtract");
     return applyElementWiseOperator(f1, f2, std::minus<Mapping::argument_value_t>());
 }
 
 
 Mapping* MappingUtils::multiply(const ConstMapping &f1, const ConstMapping &f2, Mapping::argument_value_cref_t outOfRangeVal)
 {
+    HOTPATH_SCOPE("MappingUtils::multiply");
     return applyElementWiseOperator(f1, f2, std::multiplies<Mapping::argument_value_t>(), outOfRangeVal, false);
 }
 
 Mapping* MappingUtils::divide(const ConstMapping &f1, const ConstMapping &f2, Mapping::argument_value_cref_t outOfRangeVal)
 {
+    HOTPATH_SCOPE("MappingUtils::divide");
     return applyElementWiseOperator(f1, f2, std::divides<Mapping::argument_value_t>(), outOfRangeVal, false);
 }
 
 Mapping* MappingUtils::add(const ConstMapping &f1, const ConstMapping &f2, Mapping::argument_value_cref_t outOfRangeVal)
 {
+    HOTPATH_SCOPE("MappingUtils::add");
     return applyElementWiseOperator(f1, f2, std::plus<Mapping::argument_value_t>(), outOfRangeVal, false);
 }
 
 Mapping* MappingUtils::subtract(const ConstMapping &f1, const ConstMapping &f2, Mapping::argument_value_cref_t outOfRangeVal)
 {
+    HOTPATH_SCOPE("MappingUtils::subtract");
     return applyElementWiseOperator(f1, f2, std::minus<Mapping::argument_value_t>(), outOfRangeVal, false);
 }
 
@@ -10,6 +10,7 @@
 
 #include "global/MiXiMDefs.h"
 #include "MappingBase.h"
+#include "FlatTimeMapping.h"
 
 class FilledUpMapping;
 
@@ -1888,6 +1889,43 @@ private:
 
     static bool iterateToNext(ConstMappingIterator* it1, ConstMappingIterator* it2);
 
+    /**
+     * @brief Element-wise operation on two linear interpolated time-only mappings.
+     *
+     * Merges the key entries of both operands in a single pass over their
+     * flat arrays. The result is the same as the one of the generic
+     * iterator based implementation.
+     */
+    template<class Operator>
+    static Mapping* applyFlatElementWiseOperator(const FlatTimeMapping<Linear>& f1, const FlatTimeMapping<Linear>& f2, Operator op,
+            Mapping::argument_value_cref_t outOfRangeVal,
+            bool                           contOutOfRange) {
+
+        FlatTimeMapping<Linear> *const result = (contOutOfRange) ? new FlatTimeMapping<Linear>() : new FlatTimeMapping<Linear>(outOfRangeVal);
+
+        const std::size_t n1 = f1.size();
+        const std::size_t n2 = f2.size();
+        std::size_t       i1 = 0;
+        std::size_t       i2 = 0;
+
+        result->reserve(n1 + n2);
+
+        while(i1 < n1 || i2 < n2) {
+            // next key entry of either operand
+            const omnetpp::simtime_t t = (i2 == n2 || (i1 < n1 && f1.timeAt(i1) < f2.timeAt(i2))) ? f1.timeAt(i1) : f2.timeAt(i2);
+
+            // move past the entries at t, so that i1/i2 are the upper bounds of t
+            if(i1 < n1 && f1.timeAt(i1) == t)
+                ++i1;
+            if(i2 < n2 && f2.timeAt(i2) == t)
+                ++i2;
+
+            result->append(t, op(f1.getValueAt(t, i1), f2.getValueAt(t, i2)));
+        }
+
+        return result;
+    }
+
 public:
 
     /**
@@ -1925,6 +1963,12 @@ public:
 
         using std::operator<<;
 
+        // fast path if both operands are linear interpolated time-only mappings
+        const FlatTimeMapping<Linear> *const flatF1 = dynamic_cast<const FlatTimeMapping<Linear>*>(&f1);
+        const FlatTimeMapping<Linear> *const flatF2 = dynamic_cast<const FlatTimeMapping<Linear>*>(&f2);
+        if(flatF1 && flatF2)
+            return applyFlatElementWiseOperator(*flatF1, *flatF2, op, outOfRangeVal, contOutOfRange);
+
         const ConstMapping *const f2Comp = createCompatibleMapping(f2, f1);
         const ConstMapping *const f1Comp = createCompatibleMapping(f1, f2);
 
@@ -34,6 +34,7 @@
 #include "MIXIM_veins/nic/mac/MacToPhyControlInfo.h"
 #include "PhyToMacControlInfo.h"
 #include "MIXIM_veins/nic/phy/decider/DeciderResult80211.h"
+#include "global/HotPathCounters.h"
 
 #include "MIXIM_veins/nic/phy/analogueModel/SimplePathlossModel.h"
 #include "MIXIM_veins/nic/phy/analogueModel/BreakpointPathlossModel.h"
@@ -76,6 +77,11 @@ PhyLayer80211p::~PhyLayer80211p()
     if(radioDelayTimer)
         cancelAndDelete(radioDelayTimer);
 
+    // batched AirFrames are still in ChannelInfo and have been deleted above
+    airFrameBatch.clear();
+    if(airFrameBatchTimer)
+        cancelAndDelete(airFrameBatchTimer);
+
     // free thermal noise mapping
     if(thermalNoise)
         delete thermalNoise;
@@ -145,6 +151,7 @@ void PhyLayer80211p::initialize(int stage)
         record_stat = par("record_stat").boolValue();
         record_frameTxRx = par("record_frameTxRx").boolValue();
         emulationActive = par("emulationActive").boolValue();
+        batchAirFrames = par("batchAirFrames").boolValue();
 
         // initialize radio
         radio = initializeRadio();
@@ -159,6 +166,9 @@ void PhyLayer80211p::initialize(int stage)
         radioSwitchingOverTimer = new omnetpp::cMessage("radio switching over", RADIO_SWITCHING_OVER);
         txOverTimer = new omnetpp::cMessage("transmission over", TX_OVER);
         radioDelayTimer = new omnetpp::cMessage("radio delay", RADIO_DELAY);
+        airFrameBatchTimer = new omnetpp::cMessage("AirFrame batch", AIR_FRAME_BATCH);
+        // same priority as the AirFrames it stands for
+        airFrameBatchTimer->setSchedulingPriority(airFramePriority());
 
         myId = getParentModule()->getParentModule()->getFullName();
     }
@@ -261,6 +271,13 @@ void PhyLayer80211p::handleSelfMessage(omnetpp::cMessage* msg)
         handleAirFrame(static_cast<AirFrame*>(msg));
         break;
     }
+    // AirFrames due at the same time
+    case AIR_FRAME_BATCH:
+    {
+        assert(msg == airFrameBatchTimer);
+        handleAirFrameBatch();
+        break;
+    }
     // ChannelSenseRequest
     case CHANNEL_SENSE_REQUEST:
     {
@@ -793,7 +810,8 @@ BaseDecider* PhyLayer80211p::initializeDecider80211p(ParameterMap& params)
             params["centerFrequency"].doubleValue(),
             findHost()->getIndex(),
             par("collectCollisionStatistics").boolValue(),
-            coreDebug);
+            coreDebug,
+            par("validateCCA").boolValue());
 
     dec->setPath(getParentModule()->getFullPath());
     return dec;
@@ -802,6 +820,8 @@ BaseDecider* PhyLayer80211p::initializeDecider80211p(ParameterMap& params)
 
 void PhyLayer80211p::handleAirFrame(AirFrame* frame)
 {
+    HOTPATH_SCOPE("PhyLayer80211p::handleAirFrame");
+
     //TODO: ask jerome to set air frame priority in his UWBIRPhy
     //assert(frame->getSchedulingPriority() == airFramePriority());
 
@@ -864,7 +884,7 @@ void PhyLayer80211p::handleAirFrameStartReceive(AirFrame* frame)
             frame->setState(END_RECEIVE);
 
             omnetpp::simtime_t signalEndTime = frame->getSendingTime() + frame->getSignal().getPropagationDelay() + frame->getDuration();
-            scheduleAt(signalEndTime, frame);
+            scheduleAirFrame(frame, signalEndTime);
         }
     }
     else
@@ -874,7 +894,7 @@ void PhyLayer80211p::handleAirFrameStartReceive(AirFrame* frame)
 
         // schedule the message directly to its end
         omnetpp::simtime_t signalEndTime = frame->getSendingTime() + frame->getSignal().getPropagationDelay() + frame->getDuration();
-        scheduleAt(signalEndTime, frame);
+        scheduleAirFrame(frame, signalEndTime);
 
         return;
     }
@@ -911,7 +931,7 @@ void PhyLayer80211p::handleAirFrameReceiving(AirFrame* frame)
 
     coreEV << "Handed AirFrame with ID " << frame->getId() << " to Decider. Next handling in " << nextHandleTime - omnetpp::simTime() << "s." << std::endl;
 
-    scheduleAt(nextHandleTime, frame);
+    scheduleAirFrame(frame, nextHandleTime);
 }
 
 
@@ -943,6 +963,65 @@ void PhyLayer80211p::handleAirFrameEndReceive(AirFrame* frame)
 }
 
 
+// With batchAirFrames the frames due at t are handled at the queue position
+// of the batch timer, not at the position each frame would have had as its own
+// event. Events scheduled for t in between (e.g. the START_RECEIVE of a new
+// AirFrame or a MAC timer) therefore run after the whole batch.
+void PhyLayer80211p::scheduleAirFrame(AirFrame* frame, omnetpp::simtime_t_cref t)
+{
+    if(!batchAirFrames)
+    {
+        scheduleAt(t, frame);
+        return;
+    }
+
+    airFrameBatch[t].push_back(frame);
+    rescheduleAirFrameBatch();
+}
+
+
+void PhyLayer80211p::handleAirFrameBatch()
+{
+    // a frame can be scheduled again for the current time while
+    // we are handling the batch. It is handled in the same event.
+    while(!airFrameBatch.empty() && airFrameBatch.begin()->first == omnetpp::simTime())
+    {
+        std::vector<AirFrame*> frames;
+        frames.swap(airFrameBatch.begin()->second);
+        airFrameBatch.erase(airFrameBatch.begin());
+
+        for(auto &frame : frames)
+            handleAirFrame(frame);
+    }
+
+    rescheduleAirFrameBatch();
+}
+
+
+void PhyLayer80211p::rescheduleAirFrameBatch()
+{
+    if(airFrameBatch.empty())
+    {
+        if(airFrameBatchTimer->isScheduled())
+            cancelEvent(airFrameBatchTimer);
+
+        return;
+    }
+
+    omnetpp::simtime_t earliest = airFrameBatch.begin()->first;
+
+    if(airFrameBatchTimer->isScheduled())
+    {
+        if(airFrameBatchTimer->getArrivalTime() == earliest)
+            return;
+
+        cancelEvent(airFrameBatchTimer);
+    }
+
+    scheduleAt(earliest, airFrameBatchTimer);
+}
+
+
 void PhyLayer80211p::handleChannelSenseRequest(omnetpp::cMessage* msg)
 {
     MacToPhyCSR* senseReq = static_cast<MacToPhyCSR*>(msg);
@@ -170,6 +170,21 @@ private:
 
     omnetpp::cMessage* radioDelayTimer = NULL;
 
+    /**
+     * @brief handle all AirFrames due at the same time in one event (see batchAirFrames in the NED file).
+     * Changes the order of same-time events, off by default.
+     */
+    bool batchAirFrames = false;
+
+    /**
+     * @brief AirFrames waiting for their next receive step, by the time
+     * they are due. Frames due at the same time keep their scheduling order.
+     */
+    std::map<omnetpp::simtime_t, std::vector<AirFrame*>> airFrameBatch;
+
+    /** @brief Self message scheduled to the earliest time in airFrameBatch.*/
+    omnetpp::cMessage* airFrameBatchTimer = NULL;
+
     /** @brief Stores the length of the phy header in bits. */
     int headerLength = -1;
 
@@ -387,6 +402,22 @@ protected:
      */
     virtual void handleAirFrameEndReceive(AirFrame* msg);
 
+    /**
+     * @brief Schedules the next receive step of an AirFrame at time t,
+     * either directly or as part of the AirFrame batch due at t.
+     */
+    void scheduleAirFrame(AirFrame* frame, omnetpp::simtime_t_cref t);
+
+    /**
+     * @brief Handles all AirFrames in the batch due at the current time.
+     */
+    void handleAirFrameBatch();
+
+    /**
+     * @brief Moves airFrameBatchTimer to the earliest batch.
+     */
+    void rescheduleAirFrameBatch();
+
 private:
 
     /**
@@ -31,6 +31,7 @@
 #include "msg/AirFrame11p_serial.h"
 #include "NistErrorRate.h"
 #include "MIXIM_veins/nic/mac/ConstsPhy.h"
+#include "global/HotPathCounters.h"
 
 namespace Veins {
 
@@ -49,19 +50,20 @@ void Decider80211p::finish()
 omnetpp::simtime_t Decider80211p::processNewSignal(AirFrame* msg)
 {
     EV_STATICCONTEXT
+    HOTPATH_SCOPE("Decider80211p::processNewSignal");
 
     AirFrame11p *frame = omnetpp::check_and_cast<AirFrame11p *>(msg);
 
-    // get the receiving power of the Signal at start-time and center frequency
     Signal& signal = frame->getSignal();
 
-    Argument start(DimensionSet::timeFreqDomain());
-    start.setTime(frame->getSendingTime() + signal.getPropagationDelay());
-    start.setArgValue(Dimension::frequency(), centerFrequency);
-
     signalStates[frame] = EXPECT_END;
 
-    double recvPower = signal.getReceivingPower()->getValue(start);
+    // get the receiving power of the Signal at start-time and center frequency
+    double recvPower = getRecvPower(frame);
+
+    // the frame adds to the channel power until its end
+    airFramePower[frame] = recvPower;
+    totalRecvPower += recvPower;
 
     if (recvPower < sensitivity)
     {
@@ -112,23 +114,32 @@ omnetpp::simtime_t Decider80211p::processNewSignal(AirFrame* msg)
 omnetpp::simtime_t Decider80211p::processSignalEnd(AirFrame* msg)
 {
     EV_STATICCONTEXT
+    HOTPATH_SCOPE("Decider80211p::processSignalEnd");
 
     AirFrame11p *frame = omnetpp::check_and_cast<AirFrame11p *>(msg);
 
-    // here the Signal is finally processed
-    Signal& signal = frame->getSignal();
-
-    Argument start(DimensionSet::timeFreqDomain());
-    start.setTime(frame->getSendingTime() + signal.getPropagationDelay());
-    start.setArgValue(Dimension::frequency(), centerFrequency);
-
-    double recvPower_dBm = 10*log10(signal.getReceivingPower()->getValue(start));
+    double recvPower_dBm = 0;
 
     bool whileSending = false;
 
     // remove this frame from our current signals
     signalStates.erase(frame);
 
+    // and from the channel power
+    auto it = airFramePower.find(frame);
+    if(it != airFramePower.end())
+    {
+        recvPower_dBm = 10*log10(it->second);
+        totalRecvPower -= it->second;
+        airFramePower.erase(it);
+    }
+    else
+        recvPower_dBm = 10*log10(getRecvPower(frame));
+
+    // do not carry rounding errors over to the next busy period
+    if(airFramePower.empty())
+        totalRecvPower = 0;
+
     DeciderResult80211* result;
 
     if (frame->getUnderSensitivity())
@@ -486,6 +497,41 @@ enum Decider80211p::PACKET_OK_RESULT Decider80211p::packetOk(double snirMin, dou
 }
 
 
+double Decider80211p::getRecvPower(AirFrame* frame)
+{
+    Signal& signal = frame->getSignal();
+
+    Argument start(DimensionSet::timeFreqDomain());
+    start.setTime(frame->getSendingTime() + signal.getPropagationDelay());
+    start.setArgValue(Dimension::frequency(), centerFrequency);
+
+    return signal.getReceivingPower()->getValue(start);
+}
+
+
+double Decider80211p::getAggregatePower(omnetpp::simtime_t_cref time, AirFrame* exclude)
+{
+    // the running sum only describes the channel right now
+    if(time != omnetpp::simTime())
+        return calcCCAPowerFromMapping(time, exclude);
+
+    double power = totalRecvPower;
+
+    if(exclude)
+    {
+        auto it = airFramePower.find(exclude);
+        if(it != airFramePower.end())
+            power -= it->second;
+    }
+
+    ConstMapping* thermalNoise = phy->getThermalNoise(time, time);
+    if(thermalNoise)
+        power += thermalNoise->getValue(Argument(time));
+
+    return power;
+}
+
+
 int Decider80211p::getSignalState(AirFrame* frame)
 {
     if (signalStates.find(frame) == signalStates.end())
@@ -497,6 +543,10 @@ int Decider80211p::getSignalState(AirFrame* frame)
 
 double Decider80211p::calcChannelSenseRSSI(omnetpp::simtime_t_cref start, omnetpp::simtime_t_cref end)
 {
+    // sensing the channel right now
+    if(start == end && end == omnetpp::simTime() && !validateCCA)
+        return getAggregatePower(end, NULL);
+
     Mapping* rssiMap = calculateRSSIMapping(start, end);
 
     Argument min(DimensionSet::timeFreqDomain());
@@ -517,7 +567,27 @@ double Decider80211p::calcChannelSenseRSSI(omnetpp::simtime_t_cref start, omnetp
 bool Decider80211p::cca(omnetpp::simtime_t_cref time, AirFrame* exclude)
 {
     EV_STATICCONTEXT
+    HOTPATH_SCOPE("Decider80211p::cca");
+
+    double minPower = getAggregatePower(time, exclude);
+
+    if (validateCCA)
+    {
+        double mappingPower = calcCCAPowerFromMapping(time, exclude);
 
+        if ((minPower < ccaThreshold) != (mappingPower < ccaThreshold))
+            throw omnetpp::cRuntimeError("Decider80211p: CCA mismatch in %s at %.9f. running sum: %e mW, RSSI mapping: %e mW",
+                    myPath.c_str(), SIMTIME_DBL(time), minPower, mappingPower);
+    }
+
+    EV << minPower << " > " << ccaThreshold << " = " << (bool)(minPower > ccaThreshold) << std::endl;
+
+    return minPower < ccaThreshold;
+}
+
+
+double Decider80211p::calcCCAPowerFromMapping(omnetpp::simtime_t_cref time, AirFrame* exclude)
+{
     AirFrameVector airFrames;
 
     // collect all AirFrames that intersect with [start, end]
@@ -576,12 +646,8 @@ bool Decider80211p::cca(omnetpp::simtime_t_cref time, AirFrame* exclude)
 
     double minPower = MappingUtils::findMin(*resultMap, min, min, MappingUtils::cMaxNotFound());
 
-    EV << minPower << " > " << ccaThreshold << " = " << (bool)(minPower > ccaThreshold) << std::endl;
-
-    bool isChannelIdle = minPower < ccaThreshold;
-
     delete resultMap;
-    return isChannelIdle;
+    return minPower;
 }
 
 
@@ -608,6 +674,14 @@ void Decider80211p::setChannelIdleStatus(bool isIdle)
 void Decider80211p::changeFrequency(double freq)
 {
     centerFrequency = freq;
+
+    // receiving powers depend on the frequency we listen to
+    totalRecvPower = 0;
+    for(auto &entry : airFramePower)
+    {
+        entry.second = getRecvPower(entry.first);
+        totalRecvPower += entry.second;
+    }
 }
 
 
@@ -120,6 +120,18 @@ protected:
     /** @brief count the number of collisions */
     unsigned int collisions;
 
+    /** @brief receiving power (at centerFrequency) of every AirFrame currently on the channel
+     *
+     * Updated in processNewSignal/processSignalEnd, so that CCA and the
+     * sensed RSSI are an O(1) read of totalRecvPower instead of summing up
+     * the receiving-power-mappings of all AirFrames.
+     */
+    std::map<AirFrame*, double> airFramePower;
+    double totalRecvPower;
+
+    /** @brief also evaluate CCA with the RSSI mapping and compare both results (for validation only) */
+    bool validateCCA;
+
 protected:
 
     /**
@@ -145,6 +157,15 @@ protected:
      */
     virtual omnetpp::simtime_t processSignalEnd(AirFrame* frame);
 
+    /** @brief receiving power of the frame at its start time and the current center frequency */
+    double getRecvPower(AirFrame* frame);
+
+    /** @brief sum of the receiving power of all AirFrames on the channel (except exclude) plus thermal noise */
+    double getAggregatePower(omnetpp::simtime_t_cref time, AirFrame* exclude);
+
+    /** @brief CCA power computed from the receiving-power-mappings of all AirFrames (old implementation) */
+    double calcCCAPowerFromMapping(omnetpp::simtime_t_cref time, AirFrame* exclude);
+
     /** @brief computes if packet is ok or has errors*/
     enum PACKET_OK_RESULT packetOk(double snirMin, double snrMin, int lengthMPDU, double bitrate);
 
@@ -197,7 +218,8 @@ public:
             double centerFrequency,
             int myIndex = -1,
             bool collectCollisionStatistics = false,
-            bool debug = false):
+            bool debug = false,
+            bool validateCCA = false):
                 BaseDecider(phy, sensitivity, myIndex, debug),
                 ccaThreshold(ccaThreshold),
                 allowTxDuringRx(allowTxDuringRx),
@@ -205,7 +227,9 @@ public:
                 myBusyTime(0),
                 myStartTime(omnetpp::simTime().dbl()),
                 collectCollisionStats(collectCollisionStatistics),
-                collisions(0) {
+                collisions(0),
+                totalRecvPower(0),
+                validateCCA(validateCCA) {
     }
 
     void setPath(std::string myPath)
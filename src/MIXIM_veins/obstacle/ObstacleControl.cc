@@ -22,6 +22,7 @@
 #include <set>
 
 #include "ObstacleControl.h"
+#include "global/HotPathCounters.h"
 
 namespace Veins {
 
@@ -222,6 +223,7 @@ void ObstacleControl::erase(const Obstacle* obstacle)
 double ObstacleControl::calculateAttenuation(const Coord& senderPos, const Coord& receiverPos) const
 {
     Enter_Method_Silent();
+    HOTPATH_SCOPE("ObstacleControl::calculateAttenuation");
 
     if ((perCut.size() == 0) || (perMeter.size() == 0))
         throw omnetpp::cRuntimeError("Unable to use SimpleObstacleShadowing: No obstacle types have been configured");
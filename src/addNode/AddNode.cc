@@ -1056,6 +1056,9 @@ void AddNode::addVehicleFlow()
 
     LOG_DEBUG << boost::format("\n>>> AddNode is adding %1% vehicle flows ... \n") % num << std::flush;
 
+    // vehicleAdd commands of all flows are sent in bulk
+    TraCIBatch batch(TraCI);
+
     // iterate over each flow
     for(auto &entry : allVehicleFlow)
     {
@@ -1464,6 +1467,9 @@ void AddNode::addVehicleMultiFlow()
 
     LOG_DEBUG << boost::format("\n>>> AddNode is adding %1% vehicle multi-flows ... \n") % num << std::flush;
 
+    // vehicleAdd commands of all flows are sent in bulk
+    TraCIBatch batch(TraCI);
+
     // iterate over each flow
     for(auto &entry : allVehicleMultiFlow)
     {
@@ -1817,6 +1823,9 @@ void AddNode::parseVehiclePlatoonChild(rapidxml::xml_node<> *pNode)
 
 void AddNode::addVehiclePlatoon()
 {
+    // vehicleAdd and the follow-up set commands of all platoon members are sent in bulk
+    TraCIBatch batch(TraCI);
+
     for(auto &entry : allVehiclePlatoon)
     {
         if(entry.second.processed)
@@ -0,0 +1,116 @@
+/****************************************************************************/
+/// @file    HotPathCounters.cc
+/// @author  Mani Amoozadeh <maniam@ucdavis.edu>
+/// @author  second author name
+/// @date    October 2017
+///
+/****************************************************************************/
+// VENTOS, Vehicular Network Open Simulator; see http:?
+// Copyright (C) 2013-2015
+/****************************************************************************/
+//
+// This file is part of VENTOS.
+// VENTOS is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#include <stdexcept>
+#include <algorithm>
+
+#include "global/HotPathCounters.h"
+
+namespace VENTOS {
+
+std::mutex HotPathCounters::lock_registry;
+std::vector<std::string> HotPathCounters::names;
+std::vector<HotPathCounters::threadTable_t *> HotPathCounters::tables;
+thread_local HotPathCounters::threadTable_t * HotPathCounters::myTable = NULL;
+thread_local HotPathScope * HotPathScope::current = NULL;
+
+
+int HotPathCounters::registerCounter(const char *name)
+{
+    std::lock_guard<std::mutex> lock(lock_registry);
+
+    // the same name can be registered from more than one call site
+    for(unsigned int i = 0; i < names.size(); i++)
+        if(names[i] == name)
+            return i;
+
+    if(names.size() >= MAX_COUNTERS)
+        throw std::runtime_error("HotPathCounters: too many instrumented functions. Increase MAX_COUNTERS");
+
+    names.push_back(name);
+    return names.size() - 1;
+}
+
+
+HotPathCounters::threadTable_t * HotPathCounters::newThreadTable()
+{
+    std::lock_guard<std::mutex> lock(lock_registry);
+
+    // the table outlives the thread so that its counters
+    // are still available when we aggregate at the end
+    threadTable_t *table = new threadTable_t();
+    tables.push_back(table);
+
+    return table;
+}
+
+
+std::vector<hotPathStat_t> HotPathCounters::aggregate()
+{
+    std::lock_guard<std::mutex> lock(lock_registry);
+
+    std::vector<hotPathStat_t> result;
+
+    for(unsigned int i = 0; i < names.size(); i++)
+    {
+        hotPathStat_t entry = {};
+
+        // module is the class name in 'class::function'
+        entry.function = names[i];
+        size_t pos = names[i].find("::");
+        entry.module = (pos == std::string::npos) ? "" : names[i].substr(0, pos);
+
+        for(auto &table : tables)
+        {
+            const hotPathCounter_t &c = table->counters[i];
+            if(c.calls == 0)
+                continue;
+
+            entry.calls += c.calls;
+            entry.cycles += c.cycles;
+            entry.selfCycles += c.selfCycles;
+            entry.maxCycles = std::max(entry.maxCycles, c.maxCycles);
+            entry.threads++;
+        }
+
+        result.push_back(entry);
+    }
+
+    return result;
+}
+
+
+void HotPathCounters::reset()
+{
+    std::lock_guard<std::mutex> lock(lock_registry);
+
+    for(auto &table : tables)
+        for(int i = 0; i < MAX_COUNTERS; i++)
+            table->counters[i] = hotPathCounter_t();
+}
+
+}
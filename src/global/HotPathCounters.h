@@ -0,0 +1,162 @@
+/****************************************************************************/
+/// @file    HotPathCounters.h
+/// @author  Mani Amoozadeh <maniam@ucdavis.edu>
+/// @author  second author name
+/// @date    October 2017
+///
+/****************************************************************************/
+// VENTOS, Vehicular Network Open Simulator; see http:?
+// Copyright (C) 2013-2015
+/****************************************************************************/
+//
+// This file is part of VENTOS.
+// VENTOS is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#ifndef HOTPATHCOUNTERS_H
+#define HOTPATHCOUNTERS_H
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <stdint.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+// Hot-path instrumentation is compiled in only when VENTOS_HOTPATH_COUNTERS
+// is defined (see src/makefrag). Otherwise HOTPATH_SCOPE expands to nothing
+// and the instrumented functions are left untouched.
+//
+// usage (at the top of the function body):
+//     HOTPATH_SCOPE("Decider80211p::processNewSignal");
+
+namespace VENTOS {
+
+typedef struct hotPathCounter
+{
+    uint64_t calls = 0;
+    uint64_t cycles = 0;        // inclusive: instrumented functions called from this one are counted as well
+    uint64_t selfCycles = 0;    // exclusive: the cycles of nested instrumented scopes are subtracted
+    uint64_t maxCycles = 0;
+} hotPathCounter_t;
+
+typedef struct hotPathStat
+{
+    std::string module;
+    std::string function;
+    uint64_t calls;
+    uint64_t cycles;
+    uint64_t selfCycles;
+    uint64_t maxCycles;
+    uint32_t threads;   // number of threads that executed this function
+} hotPathStat_t;
+
+class HotPathCounters
+{
+public:
+    // maximum number of distinct instrumented functions
+    static const int MAX_COUNTERS = 128;
+
+private:
+    // each thread updates its own table, so no locking is needed in the hot path
+    typedef struct threadTable
+    {
+        hotPathCounter_t counters[MAX_COUNTERS];
+    } threadTable_t;
+
+    static std::mutex lock_registry;
+    static std::vector<std::string> names;         // indexed by counter id
+    static std::vector<threadTable_t *> tables;    // one table per thread (never freed)
+    static thread_local threadTable_t *myTable;
+
+public:
+    static int registerCounter(const char *name);
+    static std::vector<hotPathStat_t> aggregate();
+    // clears the counters of all threads. Called at the start of each run, as
+    // several runs can share one process (e.g. Cmdenv with -r 0..N)
+    static void reset();
+
+    static inline uint64_t now()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+    static inline void record(int id, uint64_t elapsed, uint64_t self)
+    {
+        if(!myTable)
+            myTable = newThreadTable();
+
+        hotPathCounter_t &c = myTable->counters[id];
+        c.calls++;
+        c.cycles += elapsed;
+        c.selfCycles += self;
+        if(elapsed > c.maxCycles)
+            c.maxCycles = elapsed;
+    }
+
+private:
+    static threadTable_t * newThreadTable();
+};
+
+
+// RAII helper that charges the elapsed cycles of the enclosing scope to a counter.
+// Scopes of a thread form a stack, so that a scope can subtract the cycles of
+// the scopes nested in it from its self cycles
+class HotPathScope
+{
+private:
+    int id;
+    uint64_t start;
+    uint64_t nested = 0;
+    HotPathScope *parent;
+
+    static thread_local HotPathScope *current;
+
+public:
+    explicit HotPathScope(int id) : id(id), start(HotPathCounters::now()), parent(current) { current = this; }
+
+    ~HotPathScope()
+    {
+        uint64_t elapsed = HotPathCounters::now() - start;
+        HotPathCounters::record(id, elapsed, elapsed - nested);
+
+        if(parent)
+            parent->nested += elapsed;
+        current = parent;
+    }
+};
+
+}
+
+#define HOTPATH_CONCAT_(a, b) a##b
+#define HOTPATH_CONCAT(a, b) HOTPATH_CONCAT_(a, b)
+
+#ifdef VENTOS_HOTPATH_COUNTERS
+#define HOTPATH_SCOPE(name) \
+        static const int HOTPATH_CONCAT(hotPathId_, __LINE__) = VENTOS::HotPathCounters::registerCounter(name); \
+        VENTOS::HotPathScope HOTPATH_CONCAT(hotPathScope_, __LINE__)(HOTPATH_CONCAT(hotPathId_, __LINE__))
+#else
+#define HOTPATH_SCOPE(name) do {} while(0)
+#endif
+
+#endif
@@ -26,6 +26,7 @@
 //
 
 #include <iomanip>
+#include <algorithm>
 #undef ev
 #include "boost/filesystem.hpp"
 
@@ -114,70 +115,117 @@ void LoopDetectors::checkLoopDetectors()
     if(str.empty())
         LOG_INFO << ">>> WARNING: no loop detectors found in the network. \n" << std::flush;
 
+    // loop detector data is received through subscription at each time step
+    TraCI->LDSubscribe();
+
+    openRecords.assign(str.size(), openRecord_t());
+
     // for each loop detector
     for (auto &it : str)
     {
-        std::string lane = TraCI->LDGetLaneID(it);
-        LDs[it] = lane;
+        int index = TraCI->LDGetIndex(it);
+        if(index == -1)
+            throw omnetpp::cRuntimeError("Loop detector '%s' is not subscribed", it.c_str());
+
+        openRecords[index].open = false;
+        openRecords[index].lastSeen = 0;
+        openRecords[index].data.detectorName = it;
+        openRecords[index].data.lane = TraCI->LDGetLaneID(it);
     }
 
     if(str.size() > 0)
         LOG_INFO << boost::format(">>> %1% loop detectors are present in the network. \n") % str.size() << std::flush;
+
+    partFile.open("loopDetector.txt");
 }
 
 
+// only loop detectors with a vehicle in this time step are visited. The record of a
+// vehicle is closed (and written to file) once it is no longer on its loop detector
 void LoopDetectors::collectLDsData()
 {
-    // for each loop detector
-    for (auto &entry : LDs)
-    {
-        std::string detectorName = entry.first;
-        std::string detectorLane = entry.second;
-
-        auto st = TraCI->LDGetLastStepVehicleData(detectorName);
+    stepCounter++;
 
-        // proceed only if this loop detector detected a vehicle
-        if(st.size() == 0)
-            continue;
+    for (int index : TraCI->LDGetActive())
+    {
+        const LDState_t &state = TraCI->LDGetState(index);
+        openRecord_t &record = openRecords[index];
 
         // get vehicle information
-        std::string vehicleName = st[0].vehID;
-        double entryT = st[0].entryTime;
-        double leaveT = st[0].leaveTime;
-        double speed = TraCI->LDGetLastStepMeanVehicleSpeed(detectorName);  // vehicle speed at current moment
-
-        auto counter = std::find_if(Vec_loopDetectors.begin(), Vec_loopDetectors.end(), [detectorName, vehicleName](LoopDetectorData_t const& n)
-                {return (n.detectorName == detectorName && n.vehicleName == vehicleName);});
+        const vehLD_t &veh = state.vehicles[0];
+        double speed = state.meanSpeed;  // vehicle speed at current moment
 
-        // its a new entry, so we add detectorName
-        if(counter == Vec_loopDetectors.end())
+        // another vehicle is on this loop detector now
+        if(record.open && record.data.vehicleName != veh.vehID)
         {
-            LoopDetectorData_t tmp = {};
-
-            tmp.detectorName = detectorName;
-            tmp.lane = detectorLane;
-            tmp.vehicleName = vehicleName;
-            tmp.entryTime = entryT;
-            tmp.entrySpeed = speed;
-            tmp.leaveTime = leaveT;
-            tmp.leaveSpeed = speed;
-
-            Vec_loopDetectors.push_back(tmp);
+            writeRecord(record.data);
+            record.open = false;
         }
-        // if found, just update leaveTime and leaveSpeed
-        else
+        // its a new entry
+        else if(!record.open)
+            openLDs.push_back(index);
+
+        if(!record.open)
         {
-            counter->leaveTime = leaveT;
-            counter->leaveSpeed = speed;
+            record.open = true;
+            record.data.vehicleName = veh.vehID;
+            record.data.entryTime = veh.entryTime;
+            record.data.entrySpeed = speed;
         }
+
+        // just update leaveTime and leaveSpeed
+        record.data.leaveTime = veh.leaveTime;
+        record.data.leaveSpeed = speed;
+        record.lastSeen = stepCounter;
     }
+
+    // close the records of loop detectors that are empty in this time step
+    auto it = std::remove_if(openLDs.begin(), openLDs.end(), [this](int index) {
+        openRecord_t &record = openRecords[index];
+        if(record.lastSeen == stepCounter)
+            return false;
+
+        writeRecord(record.data);
+        record.open = false;
+        return true;
+    });
+
+    openLDs.erase(it, openLDs.end());
+}
+
+
+void LoopDetectors::writeRecord(const LoopDetectorData_t &y)
+{
+    FILE *partFilePtr = partFile.get();
+
+    fprintf (partFilePtr, "%-20s", y.detectorName.c_str());
+    fprintf (partFilePtr, "%-15s", y.lane.c_str());
+    fprintf (partFilePtr, "%-22s", y.vehicleName.c_str());
+    fprintf (partFilePtr, "%-20.2f", y.entryTime);
+    fprintf (partFilePtr, "%-22.2f", y.entrySpeed);
+    fprintf (partFilePtr, "%-20.2f", y.leaveTime);
+    fprintf (partFilePtr, "%-22.2f\n", y.leaveSpeed);
+
+    recordCount++;
 }
 
 
 void LoopDetectors::saveLDsData()
 {
-    if(Vec_loopDetectors.empty())
+    if(!partFile.isOpen())
+        return;
+
+    // vehicles that are still on a loop detector
+    for(int index : openLDs)
+        writeRecord(openRecords[index].data);
+
+    openLDs.clear();
+
+    if(recordCount == 0)
+    {
+        partFile.discard();
         return;
+    }
 
     int currentRun = omnetpp::getEnvir()->getConfigEx()->getActiveRunNumber();
 
@@ -238,16 +286,7 @@ void LoopDetectors::saveLDsData()
     fprintf (filePtr, "%-22s\n\n","leaveSpeed");
 
     // write body
-    for(auto &y : Vec_loopDetectors)
-    {
-        fprintf (filePtr, "%-20s", y.detectorName.c_str());
-        fprintf (filePtr, "%-15s", y.lane.c_str());
-        fprintf (filePtr, "%-22s", y.vehicleName.c_str());
-        fprintf (filePtr, "%-20.2f", y.entryTime);
-        fprintf (filePtr, "%-22.2f", y.entrySpeed);
-        fprintf (filePtr, "%-20.2f", y.leaveTime);
-        fprintf (filePtr, "%-22.2f\n", y.leaveSpeed);
-    }
+    partFile.appendTo(filePtr);
 
     fclose(filePtr);
 }
@@ -32,6 +32,7 @@
 
 #include "baseAppl/03_BaseApplLayer.h"
 #include "traci/TraCICommands.h"
+#include "global/PartFile.h"
 
 namespace VENTOS {
 
@@ -44,9 +45,6 @@ private:
     omnetpp::simsignal_t Signal_initialize_withTraCI;
     omnetpp::simsignal_t Signal_executeEachTS;
 
-    // loop detector ids with their lanes
-    std::unordered_map<std::string /*id*/, std::string /*lane*/> LDs;
-
     typedef struct LoopDetectorData
     {
         std::string detectorName;
@@ -58,7 +56,23 @@ private:
         double leaveSpeed;
     } LoopDetectorData_t;
 
-    std::vector<LoopDetectorData_t> Vec_loopDetectors;
+    // the record of the vehicle that is currently on each loop detector
+    typedef struct openRecord
+    {
+        bool open;
+        uint64_t lastSeen;  // time step counter of the last update
+        LoopDetectorData_t data;
+    } openRecord_t;
+
+    // indexed by the loop detector index in TraCI
+    std::vector<openRecord_t> openRecords;
+    // loop detectors with an open record
+    std::vector<int> openLDs;
+    uint64_t stepCounter = 0;
+
+    // completed records are written to this file as they are closed
+    PartFile partFile;
+    uint64_t recordCount = 0;
 
 public:
     virtual ~LoopDetectors();
@@ -74,6 +88,7 @@ protected:
 private:
     void checkLoopDetectors();
     void collectLDsData();
+    void writeRecord(const LoopDetectorData_t &);
     void saveLDsData();
 };
 
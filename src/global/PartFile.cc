@@ -0,0 +1,159 @@
+/****************************************************************************/
+/// @file    PartFile.cc
+/// @author  Mani Amoozadeh <maniam@ucdavis.edu>
+/// @author  second author name
+/// @date    October 2017
+///
+/****************************************************************************/
+// VENTOS, Vehicular Network Open Simulator; see http:?
+// Copyright (C) 2013-2015
+/****************************************************************************/
+//
+// This file is part of VENTOS.
+// VENTOS is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#include <sys/file.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sstream>
+#include <boost/format.hpp>
+
+#include <omnetpp.h>
+#include "global/PartFile.h"
+
+namespace VENTOS {
+
+// part files in 'results' are created and removed while this lock is held. Otherwise
+// removeStale of another simulation could remove a part file that is created but not locked yet
+class resultsDirLock
+{
+private:
+    int fd;
+
+public:
+    resultsDirLock()
+    {
+        fd = ::open("results/.partLock", O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if(fd < 0)
+            throw omnetpp::cRuntimeError("Cannot create file 'results/.partLock'");
+
+        flock(fd, LOCK_EX);
+    }
+
+    ~resultsDirLock() { ::close(fd); }
+
+    resultsDirLock(const resultsDirLock&) = delete;
+    resultsDirLock& operator=(const resultsDirLock&) = delete;
+};
+
+
+void PartFile::open(std::string name)
+{
+    discard();
+
+    resultsDirLock dirLock;
+    removeStale(name);
+
+    int currentRun = omnetpp::getEnvir()->getConfigEx()->getActiveRunNumber();
+
+    std::ostringstream fileName;
+    fileName << boost::format("%03d_%s.part") % currentRun % name;
+
+    filePath = "results";
+    filePath /= fileName.str();
+
+    // the file is truncated only after it is locked, so that the part file of
+    // another simulation with the same run number is left untouched
+    int fd = ::open(filePath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0)
+        throw omnetpp::cRuntimeError("Cannot create file '%s'", filePath.c_str());
+
+    if(flock(fd, LOCK_EX | LOCK_NB) != 0)
+    {
+        ::close(fd);
+        throw omnetpp::cRuntimeError("File '%s' is used by another simulation with the same run number", filePath.c_str());
+    }
+
+    // 'w+' as the records are read back at the end
+    if(ftruncate(fd, 0) != 0 || (filePtr = fdopen(fd, "w+")) == NULL)
+    {
+        ::close(fd);
+        throw omnetpp::cRuntimeError("Cannot create file '%s'", filePath.c_str());
+    }
+}
+
+
+void PartFile::appendTo(FILE *dest)
+{
+    if(!filePtr)
+        throw omnetpp::cRuntimeError("PartFile::appendTo is called before open");
+
+    // the records are read through the open file, which still works if the
+    // file has been removed in the meantime
+    fflush(filePtr);
+    rewind(filePtr);
+
+    char buffer[8192];
+    size_t n;
+    while((n = fread(buffer, 1, sizeof(buffer), filePtr)) > 0)
+        fwrite(buffer, 1, n, dest);
+
+    discard();
+}
+
+
+void PartFile::discard()
+{
+    if(!filePtr)
+        return;
+
+    // remove first, so that the file is not left without a lock
+    boost::system::error_code ec;
+    boost::filesystem::remove(filePath, ec);
+
+    fclose(filePtr);
+    filePtr = NULL;
+}
+
+
+// part files of this result that are not locked by a running simulation. Called with resultsDirLock held
+void PartFile::removeStale(std::string name)
+{
+    boost::filesystem::path dir ("results");
+    std::string suffix = "_" + name + ".part";
+
+    boost::system::error_code ec;
+    for(boost::filesystem::directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec))
+    {
+        std::string fileName = it->path().filename().string();
+        if(fileName.size() <= suffix.size() || fileName.compare(fileName.size() - suffix.size(), suffix.size(), suffix) != 0)
+            continue;
+
+        FILE *stalePtr = fopen (it->path().c_str(), "r");
+        if(!stalePtr)
+            continue;
+
+        if(flock(fileno(stalePtr), LOCK_EX | LOCK_NB) == 0)
+        {
+            boost::system::error_code removeEc;
+            boost::filesystem::remove(it->path(), removeEc);
+        }
+
+        fclose(stalePtr);
+    }
+}
+
+}
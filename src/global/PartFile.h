@@ -0,0 +1,78 @@
+/****************************************************************************/
+/// @file    PartFile.h
+/// @author  Mani Amoozadeh <maniam@ucdavis.edu>
+/// @author  second author name
+/// @date    October 2017
+///
+/****************************************************************************/
+// VENTOS, Vehicular Network Open Simulator; see http:?
+// Copyright (C) 2013-2015
+/****************************************************************************/
+//
+// This file is part of VENTOS.
+// VENTOS is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#ifndef PARTFILE_H
+#define PARTFILE_H
+
+#include <stdio.h>
+#include <string>
+
+#undef ev
+#include "boost/filesystem.hpp"
+
+// Records of a result file are streamed to 'results/<run>_<name>.part' while the
+// simulation runs, so they do not pile up in memory. At the end, the module writes
+// the header of 'results/<run>_<name>' and appends the records with appendTo.
+//
+// The part file is locked while it is open. A part file that nobody holds a lock on
+// was left behind by a run that did not finish, and is removed by the next open of
+// the same result (from any run). Parallel runs keep their own part files.
+// Part files are created and locked, or removed as stale, under results/.partLock.
+
+namespace VENTOS {
+
+class PartFile
+{
+private:
+    FILE *filePtr = NULL;
+    boost::filesystem::path filePath;
+
+public:
+    PartFile() {}
+    // a part file that is still open belongs to a run that did not finish
+    ~PartFile() { discard(); }
+
+    PartFile(const PartFile&) = delete;
+    PartFile& operator=(const PartFile&) = delete;
+
+    // creates the part file of result 'name' (e.g. "vehDelay.txt") of the current run
+    void open(std::string name);
+    bool isOpen() const { return filePtr != NULL; }
+    FILE* get() const { return filePtr; }
+
+    // copies the records to the end of 'dest', then closes and removes the part file
+    void appendTo(FILE *dest);
+    // closes and removes the part file without using it
+    void discard();
+
+private:
+    void removeStale(std::string name);
+};
+
+}
+
+#endif
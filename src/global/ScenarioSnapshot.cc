@@ -0,0 +1,175 @@
+/****************************************************************************/
+/// @file    ScenarioSnapshot.cc
+/// @author  Mani Amoozadeh <maniam@ucdavis.edu>
+/// @author  second author name
+/// @date    October 2017
+///
+/****************************************************************************/
+// VENTOS, Vehicular Network Open Simulator; see http:?
+// Copyright (C) 2013-2015
+/****************************************************************************/
+//
+// This file is part of VENTOS.
+// VENTOS is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#include <stdexcept>
+#include <algorithm>
+#include <sstream>
+#include <unistd.h>
+
+#include "global/ScenarioSnapshot.h"
+
+namespace VENTOS {
+
+// bump this if the layout of any section changes
+static const char SNAPSHOT_MAGIC[8] = {'V','S','N','A','P','0','0','1'};
+
+
+void snapshotReader::check(size_t len)
+{
+    if(offset + len > size)
+        throw std::runtime_error("ScenarioSnapshot: section is truncated");
+}
+
+
+ScenarioSnapshot::ScenarioSnapshot(boost::filesystem::path dir, std::string name)
+{
+    filePath = dir / (name + ".bin");
+}
+
+
+ScenarioSnapshot::~ScenarioSnapshot()
+{
+
+}
+
+
+bool ScenarioSnapshot::open(const std::string &key)
+{
+    region.reset();
+    mapping.reset();
+    payload = NULL;
+    payloadSize = 0;
+
+    boost::system::error_code ec;
+    if(!boost::filesystem::is_regular_file(filePath, ec))
+        return false;
+
+    try
+    {
+        mapping.reset(new boost::interprocess::file_mapping(filePath.c_str(), boost::interprocess::read_only));
+        region.reset(new boost::interprocess::mapped_region(*mapping, boost::interprocess::read_only));
+    }
+    catch(boost::interprocess::interprocess_exception &e)
+    {
+        return false;
+    }
+
+    snapshotReader header(static_cast<const char *>(region->get_address()), region->get_size());
+
+    try
+    {
+        for(unsigned int i = 0; i < sizeof(SNAPSHOT_MAGIC); i++)
+            if(header.get<char>() != SNAPSHOT_MAGIC[i])
+                return false;
+
+        if(header.getString() != key)
+            return false;
+
+        uint64_t len = header.get<uint64_t>();
+        size_t headerSize = region->get_size() - len;
+        if(len > region->get_size() || headerSize != sizeof(SNAPSHOT_MAGIC) + sizeof(uint32_t) + key.size() + sizeof(uint64_t))
+            return false;
+
+        payload = static_cast<const char *>(region->get_address()) + headerSize;
+        payloadSize = len;
+    }
+    catch(std::runtime_error &e)
+    {
+        return false;
+    }
+
+    return true;
+}
+
+
+void ScenarioSnapshot::store(const std::string &key, const std::vector<char> &data)
+{
+    boost::filesystem::create_directories(filePath.parent_path());
+
+    snapshotWriter header;
+    for(unsigned int i = 0; i < sizeof(SNAPSHOT_MAGIC); i++)
+        header.put<char>(SNAPSHOT_MAGIC[i]);
+    header.putString(key);
+    header.put<uint64_t>(data.size());
+
+    // several replications might build the same snapshot at the same time.
+    // Each one writes into its own temporary file and then renames it, which
+    // is atomic. Readers either see the old file, or the complete new one.
+    std::ostringstream tmpName;
+    tmpName << filePath.string() << ".tmp." << getpid();
+    boost::filesystem::path tmpPath (tmpName.str());
+
+    FILE *filePtr = fopen (tmpPath.c_str(), "wb");
+    if (!filePtr)
+        throw std::runtime_error("ScenarioSnapshot: cannot create file '" + tmpPath.string() + "'");
+
+    bool ok = fwrite(header.getBuffer().data(), 1, header.getBuffer().size(), filePtr) == header.getBuffer().size();
+    ok = ok && (data.empty() || fwrite(data.data(), 1, data.size(), filePtr) == data.size());
+    ok = (fclose(filePtr) == 0) && ok;
+
+    if(!ok)
+    {
+        boost::filesystem::remove(tmpPath);
+        throw std::runtime_error("ScenarioSnapshot: cannot write file '" + tmpPath.string() + "'");
+    }
+
+    boost::filesystem::rename(tmpPath, filePath);
+}
+
+
+std::string ScenarioSnapshot::scenarioKey(boost::filesystem::path dir)
+{
+    std::vector<std::string> entries;
+
+    for(boost::filesystem::directory_iterator it(dir); it != boost::filesystem::directory_iterator(); ++it)
+    {
+        if(!boost::filesystem::is_regular_file(it->path()))
+            continue;
+
+        std::string ext = it->path().extension().string();
+        if(ext != ".xml" && ext != ".cfg")
+            continue;
+
+        std::ostringstream entry;
+        entry << it->path().filename().string() << ":"
+                << boost::filesystem::file_size(it->path()) << ":"
+                << boost::filesystem::last_write_time(it->path());
+
+        entries.push_back(entry.str());
+    }
+
+    // directory order is not guaranteed
+    std::sort(entries.begin(), entries.end());
+
+    std::string key;
+    for(auto &entry : entries)
+        key += entry + ";";
+
+    return key;
+}
+
+}
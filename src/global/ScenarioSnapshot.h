@@ -0,0 +1,142 @@
+/****************************************************************************/
+/// @file    ScenarioSnapshot.h
+/// @author  Mani Amoozadeh <maniam@ucdavis.edu>
+/// @author  second author name
+/// @date    October 2017
+///
+/****************************************************************************/
+// VENTOS, Vehicular Network Open Simulator; see http:?
+// Copyright (C) 2013-2015
+/****************************************************************************/
+//
+// This file is part of VENTOS.
+// VENTOS is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#ifndef SCENARIOSNAPSHOT_H
+#define SCENARIOSNAPSHOT_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <stdint.h>
+#include <string.h>
+
+#undef ev
+#include "boost/filesystem.hpp"
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+// Immutable scenario data (obstacle polygons, allowed movements, etc.) that is
+// identical in every replication of a scenario is written once into a binary
+// snapshot file next to the SUMO config. Later replications (possibly running
+// in parallel, see scripts/runParallel) memory-map the snapshot read-only
+// instead of re-computing the data. All processes share the same physical
+// pages through the page cache.
+//
+// Each section lives in its own file '<dir>/<name>.bin' and is tagged with a
+// key. A snapshot whose key does not match the expected key is ignored.
+
+namespace VENTOS {
+
+// appends POD values and strings to a byte buffer
+class snapshotWriter
+{
+private:
+    std::vector<char> buffer;
+
+public:
+    template<typename T> void put(const T &val)
+    {
+        const char *p = reinterpret_cast<const char *>(&val);
+        buffer.insert(buffer.end(), p, p + sizeof(T));
+    }
+
+    void putString(const std::string &str)
+    {
+        put<uint32_t>(str.size());
+        buffer.insert(buffer.end(), str.begin(), str.end());
+    }
+
+    const std::vector<char> & getBuffer() const { return buffer; }
+};
+
+
+// reads back what snapshotWriter has written
+class snapshotReader
+{
+private:
+    const char *data;
+    size_t size;
+    size_t offset = 0;
+
+public:
+    snapshotReader(const char *data, size_t size) : data(data), size(size) {}
+
+    template<typename T> T get()
+    {
+        check(sizeof(T));
+        T val;
+        memcpy(&val, data + offset, sizeof(T));
+        offset += sizeof(T);
+        return val;
+    }
+
+    std::string getString()
+    {
+        uint32_t len = get<uint32_t>();
+        check(len);
+        std::string str(data + offset, len);
+        offset += len;
+        return str;
+    }
+
+    bool eof() const { return offset >= size; }
+
+private:
+    void check(size_t len);
+};
+
+
+class ScenarioSnapshot
+{
+private:
+    boost::filesystem::path filePath;
+    std::unique_ptr<boost::interprocess::file_mapping> mapping;
+    std::unique_ptr<boost::interprocess::mapped_region> region;
+
+    const char *payload = NULL;
+    size_t payloadSize = 0;
+
+public:
+    ScenarioSnapshot(boost::filesystem::path dir, std::string name);
+    ~ScenarioSnapshot();
+
+    // maps the snapshot file. Returns false if the file does not exist or its key does not match
+    bool open(const std::string &key);
+    // atomically replaces the snapshot file
+    void store(const std::string &key, const std::vector<char> &data);
+
+    const char * getData() const { return payload; }
+    size_t getSize() const { return payloadSize; }
+    snapshotReader getReader() const { return snapshotReader(payload, payloadSize); }
+
+    // key that changes whenever any SUMO input (*.xml, *.cfg) in the scenario folder changes
+    static std::string scenarioKey(boost::filesystem::path dir);
+};
+
+}
+
+#endif
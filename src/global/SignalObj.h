@@ -90,6 +90,23 @@ public:
 };
 
 
+// is emitted by TraCI_Start when a vehicle enters a new edge (fromEdge is empty for a new vehicle)
+class vehicleEdgeData : public omnetpp::cObject, omnetpp::noncopyable
+{
+public:
+    std::string vehicle;
+    std::string fromEdge;
+    std::string toEdge;
+
+    vehicleEdgeData(std::string v, std::string from, std::string to)
+    {
+        this->vehicle = v;
+        this->fromEdge = from;
+        this->toEdge = to;
+    }
+};
+
+
 // is used to send CRL pieces to an RSU or vehicle
 class CRLPiecesData : public omnetpp::cObject, omnetpp::noncopyable
 {
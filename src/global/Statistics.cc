@@ -36,6 +36,7 @@
 #include <boost/algorithm/string.hpp>
 
 #include "global/Statistics.h"
+#include "global/HotPathCounters.h"
 
 namespace VENTOS {
 
@@ -57,6 +58,9 @@ void Statistics::initialize(int stage)
 
         record_sim_stat = par("record_sim_stat").boolValue();
 
+        // counters of an earlier run in the same process
+        HotPathCounters::reset();
+
         Signal_initialize_withTraCI = registerSignal("initializeWithTraCISignal");
         omnetpp::getSimulation()->getSystemModule()->subscribe("initializeWithTraCISignal", this);
 
@@ -83,6 +87,8 @@ void Statistics::finish()
     save_PHY_stat_toFile();
     save_FrameTxRx_stat_toFile();
 
+    save_hotPath_stat_toFile();
+
     // record simulation data one last time before closing TraCI
     if(!TraCI->TraCIclosedOnError)
         record_Sim_data();
@@ -905,6 +911,102 @@ void Statistics::save_FrameTxRx_stat_toFile()
 }
 
 
+void Statistics::save_hotPath_stat_toFile()
+{
+    // empty when VENTOS is not compiled with VENTOS_HOTPATH_COUNTERS
+    std::vector<hotPathStat_t> hotPath_stat = HotPathCounters::aggregate();
+    if(hotPath_stat.empty())
+        return;
+
+    // most expensive functions first
+    std::sort(hotPath_stat.begin(), hotPath_stat.end(),
+            [](const hotPathStat_t &a, const hotPathStat_t &b) -> bool {
+        return a.selfCycles > b.selfCycles;
+    });
+
+    // self cycles do not overlap, so their shares add up to 100%
+    uint64_t totalCycles = 0;
+    for(auto &y : hotPath_stat)
+        totalCycles += y.selfCycles;
+
+    int currentRun = omnetpp::getEnvir()->getConfigEx()->getActiveRunNumber();
+
+    std::ostringstream fileName;
+    fileName << boost::format("%03d_hotPathStat.txt") % currentRun;
+
+    boost::filesystem::path filePath ("results");
+    filePath /= fileName.str();
+
+    FILE *filePtr = fopen (filePath.c_str(), "w");
+    if (!filePtr)
+        throw omnetpp::cRuntimeError("Cannot create file '%s'", filePath.c_str());
+
+    // write simulation parameters at the beginning of the file
+    {
+        // get the current config name
+        std::string configName = omnetpp::getEnvir()->getConfigEx()->getVariable("configname");
+
+        std::string iniFile = omnetpp::getEnvir()->getConfigEx()->getVariable("inifile");
+
+        // PID of the simulation process
+        std::string processid = omnetpp::getEnvir()->getConfigEx()->getVariable("processid");
+
+        // globally unique identifier for the run, produced by
+        // concatenating the configuration name, run number, date/time, etc.
+        std::string runID = omnetpp::getEnvir()->getConfigEx()->getVariable("runid");
+
+        // get number of total runs in this config
+        int totalRun = omnetpp::getEnvir()->getConfigEx()->getNumRunsInConfig(configName.c_str());
+
+        // get the current run number
+        int currentRun = omnetpp::getEnvir()->getConfigEx()->getActiveRunNumber();
+
+        // get configuration name
+        std::vector<std::string> iterVar = omnetpp::getEnvir()->getConfigEx()->getConfigChain(configName.c_str());
+
+        // write to file
+        fprintf (filePtr, "configName      %s\n", configName.c_str());
+        fprintf (filePtr, "iniFile         %s\n", iniFile.c_str());
+        fprintf (filePtr, "processID       %s\n", processid.c_str());
+        fprintf (filePtr, "runID           %s\n", runID.c_str());
+        fprintf (filePtr, "totalRun        %d\n", totalRun);
+        fprintf (filePtr, "currentRun      %d\n", currentRun);
+        fprintf (filePtr, "currentConfig   %s\n", iterVar[0].c_str());
+        fprintf (filePtr, "sim timeStep    %u ms\n", TraCI->simulationGetDelta());
+        fprintf (filePtr, "startDateTime   %s\n", TraCI->simulationGetStartTime_str().c_str());
+        fprintf (filePtr, "endDateTime     %s\n", TraCI->simulationGetEndTime_str().c_str());
+        fprintf (filePtr, "duration        %s\n\n\n", TraCI->simulationGetDuration_str().c_str());
+    }
+
+    // write header
+    fprintf (filePtr, "%-25s","module");
+    fprintf (filePtr, "%-45s","function");
+    fprintf (filePtr, "%-15s","calls");
+    fprintf (filePtr, "%-20s","inclCycles");
+    fprintf (filePtr, "%-20s","selfCycles");
+    fprintf (filePtr, "%-15s","avgInclCycles");
+    fprintf (filePtr, "%-15s","maxInclCycles");
+    fprintf (filePtr, "%-12s","selfShare%");
+    fprintf (filePtr, "%-10s\n\n","threads");
+
+    // write body
+    for(auto &y : hotPath_stat)
+    {
+        fprintf (filePtr, "%-25s", y.module.c_str());
+        fprintf (filePtr, "%-45s", y.function.c_str());
+        fprintf (filePtr, "%-15lu", (unsigned long)y.calls);
+        fprintf (filePtr, "%-20lu", (unsigned long)y.cycles);
+        fprintf (filePtr, "%-20lu", (unsigned long)y.selfCycles);
+        fprintf (filePtr, "%-15.1f", y.calls ? (double)y.cycles / y.calls : 0.);
+        fprintf (filePtr, "%-15lu", (unsigned long)y.maxCycles);
+        fprintf (filePtr, "%-12.2f", totalCycles ? 100. * y.selfCycles / totalCycles : 0.);
+        fprintf (filePtr, "%-10u\n", y.threads);
+    }
+
+    fclose(filePtr);
+}
+
+
 void Statistics::init_Sim_data()
 {
     if(!record_sim_stat)
@@ -249,6 +249,8 @@ private:
     void save_PHY_stat_toFile();
     void save_FrameTxRx_stat_toFile();
 
+    void save_hotPath_stat_toFile();
+
     void init_Sim_data();
     void record_Sim_data();
     void save_Sim_data_toFile();
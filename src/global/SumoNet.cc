@@ -0,0 +1,470 @@
+/****************************************************************************/
+/// @file    SumoNet.cc
+/// @author  Mani Amoozadeh <maniam@ucdavis.edu>
+/// @author  second author name
+/// @date    October 2017
+///
+/****************************************************************************/
+// VENTOS, Vehicular Network Open Simulator; see http:?
+// Copyright (C) 2013-2015
+/****************************************************************************/
+//
+// This file is part of VENTOS.
+// VENTOS is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#include <stdexcept>
+#include <sstream>
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+
+#include "rapidxml.hpp"
+#include "rapidxml_utils.hpp"
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include "global/SumoNet.h"
+#include "global/ScenarioSnapshot.h"
+
+namespace VENTOS {
+
+// bump this if the layout of the model changes
+static const char *MODEL_VERSION = "netModel2";
+
+std::mutex SumoNet::lock_cache;
+std::map<std::string, std::shared_ptr<const SumoNet>> SumoNet::cache;
+
+
+// value of the attribute 'name' of 'node'. SUMO does not guarantee the order of attributes
+static const char * attribute(rapidxml::xml_node<> *node, const char *name, const char *defaultVal = NULL)
+{
+    rapidxml::xml_attribute<> *attr = node->first_attribute(name);
+    if(attr)
+        return attr->value();
+
+    if(defaultVal)
+        return defaultVal;
+
+    throw std::runtime_error(std::string("SumoNet: <") + node->name() + "> element without '" + name + "' attribute");
+}
+
+
+std::shared_ptr<const SumoNet> SumoNet::load(boost::filesystem::path netFile)
+{
+    if(!boost::filesystem::is_regular_file(netFile))
+        throw std::runtime_error("SumoNet: net file '" + netFile.string() + "' is not found");
+
+    std::lock_guard<std::mutex> lock(lock_cache);
+
+    std::string modelKey = key(netFile);
+    std::string cacheKey = boost::filesystem::absolute(netFile).string() + ";" + modelKey;
+
+    auto it = cache.find(cacheKey);
+    if(it != cache.end())
+        return it->second;
+
+    std::shared_ptr<SumoNet> net = std::make_shared<SumoNet>();
+
+    // 'hello.net.xml' is cached in 'hello.net.model.bin'
+    ScenarioSnapshot sidecar(netFile.parent_path(), netFile.stem().string() + ".model");
+
+    bool fromSidecar = false;
+    if(sidecar.open(modelKey))
+    {
+        try
+        {
+            snapshotReader reader = sidecar.getReader();
+            net->read(reader);
+            fromSidecar = true;
+        }
+        catch(std::runtime_error &e)
+        {
+            // damaged sidecar. Parse the net file again
+            net = std::make_shared<SumoNet>();
+        }
+    }
+
+    if(!fromSidecar)
+    {
+        net->parse(netFile);
+
+        snapshotWriter writer;
+        net->write(writer);
+
+        // the sidecar is only a cache. The scenario folder might be read-only
+        try
+        {
+            sidecar.store(modelKey, writer.getBuffer());
+        }
+        catch(std::exception &e) {}
+    }
+
+    net->buildIndices();
+
+    cache[cacheKey] = net;
+    return net;
+}
+
+
+boost::filesystem::path SumoNet::netFileOf(boost::filesystem::path sumoConfig)
+{
+    rapidxml::file<> xmlFile(sumoConfig.string().c_str());
+    rapidxml::xml_document<> doc;
+    doc.parse<0>(xmlFile.data());
+
+    rapidxml::xml_node<> *root = doc.first_node("configuration");
+    rapidxml::xml_node<> *input = root ? root->first_node("input") : NULL;
+    rapidxml::xml_node<> *netFile = input ? input->first_node("net-file") : NULL;
+    if(!netFile)
+        throw std::runtime_error("SumoNet: no <net-file> in '" + sumoConfig.string() + "'");
+
+    // relative to the config file
+    return sumoConfig.parent_path() / attribute(netFile, "value");
+}
+
+
+// the model depends on the content of the net file only
+std::string SumoNet::key(const boost::filesystem::path &netFile)
+{
+    std::ostringstream str;
+    str << MODEL_VERSION << ":" << boost::filesystem::file_size(netFile) << ":" << boost::filesystem::last_write_time(netFile);
+
+    return str.str();
+}
+
+
+int SumoNet::find(const std::unordered_map<std::string, int> &index, const std::string &id)
+{
+    auto it = index.find(id);
+    return (it == index.end()) ? -1 : it->second;
+}
+
+
+void SumoNet::parse(const boost::filesystem::path &netFile)
+{
+    // rapidxml parses in-situ. The file is mapped copy-on-write, so only the
+    // pages that rapidxml writes to are copied, and the file itself is not modified
+    std::unique_ptr<boost::interprocess::file_mapping> mapping;
+    std::unique_ptr<boost::interprocess::mapped_region> region;
+
+    try
+    {
+        mapping.reset(new boost::interprocess::file_mapping(netFile.c_str(), boost::interprocess::read_only));
+        region.reset(new boost::interprocess::mapped_region(*mapping, boost::interprocess::copy_on_write));
+    }
+    catch(boost::interprocess::interprocess_exception &e)
+    {
+        throw std::runtime_error("SumoNet: cannot map net file '" + netFile.string() + "': " + e.what());
+    }
+
+    char *text = static_cast<char *>(region->get_address());
+    size_t size = region->get_size();
+
+    // rapidxml needs a zero-terminated text. The trailing newline after </net>
+    // is overwritten. Otherwise (no trailing whitespace) we fall back to a copy
+    size_t end = size;
+    while(end > 0 && isspace((unsigned char)text[end - 1]))
+        end--;
+
+    std::vector<char> copy;
+    if(end < size)
+        text[end] = '\0';
+    else
+    {
+        copy.assign(text, text + size);
+        copy.push_back('\0');
+        text = copy.data();
+    }
+
+    rapidxml::xml_document<> doc;
+    try
+    {
+        doc.parse<0>(text);
+    }
+    catch(rapidxml::parse_error &e)
+    {
+        throw std::runtime_error("SumoNet: cannot parse net file '" + netFile.string() + "': " + e.what());
+    }
+
+    rapidxml::xml_node<> *root = doc.first_node("net");
+    if(!root)
+        throw std::runtime_error("SumoNet: '" + netFile.string() + "' has no <net> element");
+
+    // edges refer to junctions that are listed after them
+    std::vector<std::pair<std::string, std::string>> edgeEnds;
+
+    for(rapidxml::xml_node<> *node = root->first_node("edge"); node; node = node->next_sibling("edge"))
+    {
+        netEdge_t edge = {};
+        edge.id = attribute(node, "id");
+        edge.priority = atoi(attribute(node, "priority", "-1"));
+        std::string function = attribute(node, "function", "normal");
+        edge.internal = (function == "internal" || function == "crossing" || function == "walkingarea");
+        edgeEnds.push_back(std::make_pair(attribute(node, "from", ""), attribute(node, "to", "")));
+
+        for(rapidxml::xml_node<> *laneNode = node->first_node("lane"); laneNode; laneNode = laneNode->next_sibling("lane"))
+        {
+            netLane_t lane = {};
+            lane.id = attribute(laneNode, "id");
+            lane.edge = edges.size();
+            lane.index = atoi(attribute(laneNode, "index", "0"));
+            lane.speed = atof(attribute(laneNode, "speed"));
+            lane.length = atof(attribute(laneNode, "length"));
+
+            laneIndex[lane.id] = lanes.size();
+            edge.lanes.push_back(lanes.size());
+            lanes.push_back(lane);
+        }
+
+        std::sort(edge.lanes.begin(), edge.lanes.end(), [this](int a, int b) { return lanes[a].index < lanes[b].index; });
+
+        edgeIndex[edge.id] = edges.size();
+        edges.push_back(edge);
+    }
+
+    for(rapidxml::xml_node<> *node = root->first_node("tlLogic"); node; node = node->next_sibling("tlLogic"))
+    {
+        netTLLogic_t logic = {};
+        logic.id = attribute(node, "id");
+        logic.type = attribute(node, "type", "static");
+        logic.programID = attribute(node, "programID", "0");
+        logic.offset = atof(attribute(node, "offset", "0"));
+
+        for(rapidxml::xml_node<> *phaseNode = node->first_node("phase"); phaseNode; phaseNode = phaseNode->next_sibling("phase"))
+        {
+            netPhase_t phase = {atof(attribute(phaseNode, "duration")), attribute(phaseNode, "state")};
+            logic.phases.push_back(phase);
+        }
+
+        logic.linkCount = logic.phases.empty() ? 0 : logic.phases[0].state.size();
+
+        tlIndex[logic.id] = tlLogics.size();
+        tlLogics.push_back(logic);
+    }
+
+    for(rapidxml::xml_node<> *node = root->first_node("junction"); node; node = node->next_sibling("junction"))
+    {
+        netJunction_t junction = {};
+        junction.id = attribute(node, "id");
+        junction.type = attribute(node, "type", "");
+        junction.x = atof(attribute(node, "x"));
+        junction.y = atof(attribute(node, "y"));
+        junction.tlLogic = find(tlIndex, junction.id);
+
+        std::stringstream ssin(attribute(node, "incLanes", ""));
+        std::string laneId;
+        while(ssin >> laneId)
+        {
+            int lane = find(laneIndex, laneId);
+            if(lane == -1)
+                throw std::runtime_error("SumoNet: junction '" + junction.id + "' refers to unknown lane '" + laneId + "'");
+            junction.incLanes.push_back(lane);
+        }
+
+        for(rapidxml::xml_node<> *request = node->first_node("request"); request; request = request->next_sibling("request"))
+        {
+            unsigned int index = atoi(attribute(request, "index"));
+            if(index >= junction.foes.size())
+                junction.foes.resize(index + 1);
+            junction.foes[index] = attribute(request, "foes");
+        }
+
+        junctionIndex[junction.id] = junctions.size();
+        junctions.push_back(junction);
+    }
+
+    for(unsigned int i = 0; i < edges.size(); i++)
+    {
+        edges[i].from = find(junctionIndex, edgeEnds[i].first);
+        edges[i].to = find(junctionIndex, edgeEnds[i].second);
+
+        if(!edges[i].internal && (edges[i].from == -1 || edges[i].to == -1))
+            throw std::runtime_error("SumoNet: edge '" + edges[i].id + "' refers to an unknown junction");
+    }
+
+    for(rapidxml::xml_node<> *node = root->first_node("connection"); node; node = node->next_sibling("connection"))
+    {
+        netConnection_t conn = {};
+        conn.from = find(edgeIndex, attribute(node, "from"));
+        conn.to = find(edgeIndex, attribute(node, "to"));
+        if(conn.from == -1 || conn.to == -1)
+            throw std::runtime_error(std::string("SumoNet: connection between unknown edges '") + attribute(node, "from") + "' and '" + attribute(node, "to") + "'");
+
+        conn.fromLane = atoi(attribute(node, "fromLane"));
+        conn.toLane = atoi(attribute(node, "toLane"));
+        conn.tl = find(tlIndex, attribute(node, "tl", ""));
+        conn.linkIndex = atoi(attribute(node, "linkIndex", "-1"));
+        conn.dir = attribute(node, "dir", "s")[0];
+        conn.state = attribute(node, "state", "M")[0];
+
+        if(conn.tl != -1)
+            tlLogics[conn.tl].linkCount = std::max(tlLogics[conn.tl].linkCount, conn.linkIndex + 1);
+
+        connections.push_back(conn);
+    }
+}
+
+
+void SumoNet::read(snapshotReader &reader)
+{
+    junctions.resize(reader.get<uint32_t>());
+    for(auto &junction : junctions)
+    {
+        junction.id = reader.getString();
+        junction.type = reader.getString();
+        junction.x = reader.get<double>();
+        junction.y = reader.get<double>();
+        junction.incLanes.resize(reader.get<uint32_t>());
+        for(auto &lane : junction.incLanes)
+            lane = reader.get<int32_t>();
+        junction.tlLogic = reader.get<int32_t>();
+        junction.foes.resize(reader.get<uint32_t>());
+        for(auto &foes : junction.foes)
+            foes = reader.getString();
+    }
+
+    edges.resize(reader.get<uint32_t>());
+    for(auto &edge : edges)
+    {
+        edge.id = reader.getString();
+        edge.from = reader.get<int32_t>();
+        edge.to = reader.get<int32_t>();
+        edge.priority = reader.get<int32_t>();
+        edge.internal = reader.get<uint8_t>();
+        edge.lanes.resize(reader.get<uint32_t>());
+        for(auto &lane : edge.lanes)
+            lane = reader.get<int32_t>();
+    }
+
+    lanes.resize(reader.get<uint32_t>());
+    for(auto &lane : lanes)
+    {
+        lane.id = reader.getString();
+        lane.edge = reader.get<int32_t>();
+        lane.index = reader.get<int32_t>();
+        lane.speed = reader.get<double>();
+        lane.length = reader.get<double>();
+    }
+
+    tlLogics.resize(reader.get<uint32_t>());
+    for(auto &logic : tlLogics)
+    {
+        logic.id = reader.getString();
+        logic.type = reader.getString();
+        logic.programID = reader.getString();
+        logic.offset = reader.get<double>();
+        logic.phases.resize(reader.get<uint32_t>());
+        for(auto &phase : logic.phases)
+        {
+            phase.duration = reader.get<double>();
+            phase.state = reader.getString();
+        }
+        logic.linkCount = reader.get<int32_t>();
+    }
+
+    connections.resize(reader.get<uint32_t>());
+    for(auto &conn : connections)
+        conn = reader.get<netConnection_t>();
+}
+
+
+void SumoNet::write(snapshotWriter &writer) const
+{
+    writer.put<uint32_t>(junctions.size());
+    for(auto &junction : junctions)
+    {
+        writer.putString(junction.id);
+        writer.putString(junction.type);
+        writer.put<double>(junction.x);
+        writer.put<double>(junction.y);
+        writer.put<uint32_t>(junction.incLanes.size());
+        for(int lane : junction.incLanes)
+            writer.put<int32_t>(lane);
+        writer.put<int32_t>(junction.tlLogic);
+        writer.put<uint32_t>(junction.foes.size());
+        for(auto &foes : junction.foes)
+            writer.putString(foes);
+    }
+
+    writer.put<uint32_t>(edges.size());
+    for(auto &edge : edges)
+    {
+        writer.putString(edge.id);
+        writer.put<int32_t>(edge.from);
+        writer.put<int32_t>(edge.to);
+        writer.put<int32_t>(edge.priority);
+        writer.put<uint8_t>(edge.internal);
+        writer.put<uint32_t>(edge.lanes.size());
+        for(int lane : edge.lanes)
+            writer.put<int32_t>(lane);
+    }
+
+    writer.put<uint32_t>(lanes.size());
+    for(auto &lane : lanes)
+    {
+        writer.putString(lane.id);
+        writer.put<int32_t>(lane.edge);
+        writer.put<int32_t>(lane.index);
+        writer.put<double>(lane.speed);
+        writer.put<double>(lane.length);
+    }
+
+    writer.put<uint32_t>(tlLogics.size());
+    for(auto &logic : tlLogics)
+    {
+        writer.putString(logic.id);
+        writer.putString(logic.type);
+        writer.putString(logic.programID);
+        writer.put<double>(logic.offset);
+        writer.put<uint32_t>(logic.phases.size());
+        for(auto &phase : logic.phases)
+        {
+            writer.put<double>(phase.duration);
+            writer.putString(phase.state);
+        }
+        writer.put<int32_t>(logic.linkCount);
+    }
+
+    // netConnection_t is POD
+    writer.put<uint32_t>(connections.size());
+    for(auto &conn : connections)
+        writer.put<netConnection_t>(conn);
+}
+
+
+// the id maps are not part of the sidecar
+void SumoNet::buildIndices()
+{
+    junctionIndex.clear();
+    edgeIndex.clear();
+    laneIndex.clear();
+    tlIndex.clear();
+
+    for(unsigned int i = 0; i < junctions.size(); i++)
+        junctionIndex[junctions[i].id] = i;
+
+    for(unsigned int i = 0; i < edges.size(); i++)
+        edgeIndex[edges[i].id] = i;
+
+    for(unsigned int i = 0; i < lanes.size(); i++)
+        laneIndex[lanes[i].id] = i;
+
+    for(unsigned int i = 0; i < tlLogics.size(); i++)
+        tlIndex[tlLogics[i].id] = i;
+}
+
+}
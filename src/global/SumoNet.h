@@ -0,0 +1,157 @@
+/****************************************************************************/
+/// @file    SumoNet.h
+/// @author  Mani Amoozadeh <maniam@ucdavis.edu>
+/// @author  second author name
+/// @date    October 2017
+///
+/****************************************************************************/
+// VENTOS, Vehicular Network Open Simulator; see http:?
+// Copyright (C) 2013-2015
+/****************************************************************************/
+//
+// This file is part of VENTOS.
+// VENTOS is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#ifndef SUMONET_H
+#define SUMONET_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+
+#undef ev
+#include "boost/filesystem.hpp"
+
+// Read-only model of a SUMO network file (*.net.xml). Every junction, edge,
+// lane, tlLogic and connection gets a dense index, and references between them
+// are stored as indices instead of ids.
+//
+// The net file is memory-mapped and parsed once per process. The model is then
+// shared by all modules that need it (Router, TrafficLightAllowedMoves, ...), and
+// is also cached in a binary sidecar '<net>.model.bin' next to the net file, so
+// that later runs do not have to parse the XML again.
+
+namespace VENTOS {
+
+class snapshotReader;
+class snapshotWriter;
+
+typedef struct netLane
+{
+    std::string id;
+    int edge;           // index into SumoNet::edges
+    int index;          // lane number within its edge
+    double speed;
+    double length;
+} netLane_t;
+
+typedef struct netEdge
+{
+    std::string id;
+    int from;           // index into SumoNet::junctions, -1 for internal edges
+    int to;
+    int priority;
+    bool internal;      // inside a junction (internal, crossing and walkingarea edges)
+    std::vector<int> lanes;     // indices into SumoNet::lanes, ordered by lane number
+} netEdge_t;
+
+typedef struct netPhase
+{
+    double duration;
+    std::string state;
+} netPhase_t;
+
+typedef struct netTLLogic
+{
+    std::string id;
+    std::string type;
+    std::string programID;
+    double offset;
+    std::vector<netPhase_t> phases;
+    int linkCount;      // number of links (signals) this TL controls
+} netTLLogic_t;
+
+typedef struct netJunction
+{
+    std::string id;
+    std::string type;
+    double x;
+    double y;
+    std::vector<int> incLanes;  // indices into SumoNet::lanes
+    int tlLogic;                // index into SumoNet::tlLogics, -1 if there is none with the same id
+    std::vector<std::string> foes;  // 'foes' of each <request>. foes[i][n-1-j] is '1' if links i and j are foes
+} netJunction_t;
+
+typedef struct netConnection
+{
+    int from;           // index into SumoNet::edges
+    int to;
+    int fromLane;       // lane number
+    int toLane;
+    int tl;             // index into SumoNet::tlLogics, -1 if not signalized
+    int linkIndex;
+    char dir;
+    char state;
+} netConnection_t;
+
+
+class SumoNet
+{
+public:
+    std::vector<netJunction_t> junctions;
+    std::vector<netEdge_t> edges;
+    std::vector<netLane_t> lanes;
+    std::vector<netTLLogic_t> tlLogics;
+    std::vector<netConnection_t> connections;
+
+private:
+    std::unordered_map<std::string, int> junctionIndex;
+    std::unordered_map<std::string, int> edgeIndex;
+    std::unordered_map<std::string, int> laneIndex;
+    std::unordered_map<std::string, int> tlIndex;
+
+    // one model per net file in this process
+    static std::mutex lock_cache;
+    static std::map<std::string, std::shared_ptr<const SumoNet>> cache;
+
+public:
+    // returns the (shared) model of this net file
+    static std::shared_ptr<const SumoNet> load(boost::filesystem::path netFile);
+    // full path of the net file that a SUMO config file refers to
+    static boost::filesystem::path netFileOf(boost::filesystem::path sumoConfig);
+
+    // return -1 if the id is unknown
+    int getJunctionIndex(const std::string &id) const { return find(junctionIndex, id); }
+    int getEdgeIndex(const std::string &id) const { return find(edgeIndex, id); }
+    int getLaneIndex(const std::string &id) const { return find(laneIndex, id); }
+    int getTLIndex(const std::string &id) const { return find(tlIndex, id); }
+
+private:
+    void parse(const boost::filesystem::path &netFile);
+    void read(snapshotReader &reader);
+    void write(snapshotWriter &writer) const;
+    void buildIndices();
+
+    static std::string key(const boost::filesystem::path &netFile);
+    static int find(const std::unordered_map<std::string, int> &index, const std::string &id);
+};
+
+}
+
+#endif
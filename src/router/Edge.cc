@@ -48,9 +48,9 @@ Edge::Edge(std::string id, Node* from, Node* to, int priority, std::vector<Lane*
     speed /= numLanes;
     length /= numLanes;
 
-    visited = 0;
-    curCost = 100000000;
-    best = NULL;
+    index = -1;
+    pairIndex = -1;
+
     disabled = false;
 }
 
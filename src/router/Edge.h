@@ -57,6 +57,10 @@ public:
 
     //Node variables
     std::string id;
+    int index;      //Position in Net::edgeList
+    int pairIndex;  //Dense id of the (from, to) node pair, shared by parallel edges
+    int outIndex;   //Position in from->outEdges
+    int moveOffset; //First entry of the movements from this edge in Net::junctionMoves
     Node* from;
     Node* to;
     int priority;
@@ -69,9 +73,6 @@ public:
 
     //Pathing variables
     EdgeCosts travelTimes;
-    bool visited;
-    double curCost;
-    Edge* best;
 
     //Removal algorithm
     bool disabled;
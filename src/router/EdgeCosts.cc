@@ -25,6 +25,8 @@
 // Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 //
 
+#include <algorithm>
+
 #include "router/EdgeCosts.h"
 #include <omnetpp.h>
 
@@ -39,25 +41,8 @@ EdgeCosts::EdgeCosts()
 
     average = 0;
     count = 0;
-}
-
-EdgeCosts::EdgeCosts(std::map<int, int> dataSet)
-{
-    // get a pointer to router module
-    omnetpp::cModule *module = omnetpp::getSimulation()->getSystemModule()->getSubmodule("router");
-    EWMARate = module->par("EWMARate").doubleValue();
-    laneCostsMode = static_cast<LaneCostsMode>(module->par("LaneCostsMode").longValue());
-
-    average = 0;
-    count = 0;
-
-    data = dataSet;
-    for(auto& pair : data)
-    {
-        average += pair.first * pair.second;
-        count += pair.second;
-    }
-    average /= count;
+    total = 0;
+    binsValid = false;
 }
 
 void EdgeCosts::insert(int d)
@@ -65,9 +50,7 @@ void EdgeCosts::insert(int d)
     //If mode is average, add the new data point to the average
     if(laneCostsMode == MODE_RECORD)
     {
-        average = (average * count + d) / (count + 1);
-        ++count;
-        ++data[d];
+        addSamples(d, 1);
     }
 
     //If mode is EWMA, perform that calculation
@@ -77,10 +60,90 @@ void EdgeCosts::insert(int d)
     }
 }
 
-//Returns the % of readings of a certain travel time
-double EdgeCosts::percentAt(int d)
+void EdgeCosts::addSamples(int d, uint32_t n)
+{
+    if(d < 0)
+        d = 0;
+
+    addBucket(bucketOf(d), n, (uint64_t)d * n);
+}
+
+void EdgeCosts::addBucket(int bucket, uint32_t n, uint64_t sum)
 {
-    return double(data[d]) / count;
+    if(bucket < 0 || bucket >= NUM_BUCKETS)
+        throw omnetpp::cRuntimeError("Travel time bucket %d is out of range", bucket);
+
+    if(n == 0)
+        return;
+
+    if(counts.empty())
+    {
+        counts.assign(NUM_BUCKETS, 0);
+        sums.assign(NUM_BUCKETS, 0);
+    }
+
+    counts[bucket] += n;
+    sums[bucket] += sum;
+
+    count += n;
+    total += sum;
+    average = (double)total / count;
+
+    binsValid = false;
+}
+
+const std::vector<travelTimeBin_t>& EdgeCosts::distribution()
+{
+    if(binsValid)
+        return bins;
+
+    bins.clear();
+
+    double cumulative = 0;
+    for(unsigned int b = 0; b < counts.size(); b++)
+    {
+        if(counts[b] == 0)
+            continue;
+
+        travelTimeBin_t bin;
+        bin.travelTime = (int)((sums[b] + counts[b] / 2) / counts[b]);
+        bin.probability = (double)counts[b] / count;
+        cumulative += bin.probability;
+        bin.cumulative = cumulative;
+
+        bins.push_back(bin);
+    }
+
+    binsValid = true;
+    return bins;
+}
+
+//Returns the smallest travel time t with P(travel time <= t) >= q
+int EdgeCosts::quantile(double q)
+{
+    const std::vector<travelTimeBin_t>& dist = distribution();
+    if(dist.empty())
+        return -1;
+
+    auto it = std::lower_bound(dist.begin(), dist.end(), q, [](const travelTimeBin_t &bin, double val) {
+        return bin.cumulative < val;
+    });
+
+    return (it == dist.end()) ? dist.back().travelTime : it->travelTime;
+}
+
+int EdgeCosts::bucketOf(int d)
+{
+    if(d < LINEAR_BUCKETS)
+        return std::max(d, 0);
+
+    // d is in [LINEAR_BUCKETS * 2^octave, LINEAR_BUCKETS * 2^(octave+1))
+    int octave = (31 - __builtin_clz(d)) - (31 - __builtin_clz(LINEAR_BUCKETS));
+    if(octave >= OCTAVES)
+        return NUM_BUCKETS - 1;
+
+    int sub = ((d >> octave) - LINEAR_BUCKETS) * BUCKETS_PER_OCTAVE / LINEAR_BUCKETS;
+    return LINEAR_BUCKETS + octave * BUCKETS_PER_OCTAVE + sub;
 }
 
 }
@@ -29,29 +29,56 @@
 #define HISTOGRAM_H
 
 #include <vector>
-#include <map>
 #include <iostream>
-#include <map>
+#include <stdint.h>
 
 #include "global/GlobalConsts.h"
 
 namespace VENTOS {
 
+// one non-empty bucket of the travel time distribution
+typedef struct travelTimeBin
+{
+    int travelTime;      // mean of the travel times that fell into this bucket
+    double probability;  // share of all travel times
+    double cumulative;   // share of all travel times up to and including this bucket
+} travelTimeBin_t;
+
+// Travel time distribution of an edge in a fixed number of buckets. Travel times
+// below LINEAR_BUCKETS seconds have a bucket of their own, longer ones share
+// BUCKETS_PER_OCTAVE buckets per doubling (at most 12.5% wide). Each bucket keeps
+// the sum of its travel times, so the mean of the distribution stays exact.
 class EdgeCosts
 {
 public:
+    static const int LINEAR_BUCKETS = 16;
+    static const int BUCKETS_PER_OCTAVE = 8;
+    static const int OCTAVES = 12;  // up to LINEAR_BUCKETS * 2^OCTAVES seconds
+    static const int NUM_BUCKETS = LINEAR_BUCKETS + OCTAVES * BUCKETS_PER_OCTAVE;
+
     EdgeCosts();
-    EdgeCosts(std::map<int, int> dataSet);
 
     void insert(int d); //Inserts a new value into the LaneCosts structure.
-    double percentAt(int d);
+    void addSamples(int d, uint32_t n);  // adds n readings of travel time d, regardless of the mode
+    void addBucket(int bucket, uint32_t n, uint64_t sum);
+
+    const std::vector<travelTimeBin_t>& distribution();  // non-empty buckets, in increasing travel time
+    int quantile(double q);
+
+    static int bucketOf(int d);
 
 public:
-    std::map<int, int> data; //Map from each travel time to its number of occurrences
+    std::vector<uint32_t> counts;  // number of readings per bucket, empty until the first reading
+    std::vector<uint64_t> sums;    // sum of the travel times per bucket
     int count;
+    uint64_t total;
     double average;
     double EWMARate;
     LaneCostsMode laneCostsMode;
+
+private:
+    std::vector<travelTimeBin_t> bins;  // rebuilt from the buckets after a change
+    bool binsValid;
 };
 
 }
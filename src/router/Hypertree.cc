@@ -25,13 +25,39 @@
 // Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 //
 
+#include <algorithm>
+
 #include "router/Hypertree.h"
+#include "router/Net.h"
+#include "router/Edge.h"
 
 namespace VENTOS {
 
-Hypertree::Hypertree()
+Hypertree::Hypertree(Net* net, int startTime, int endTime) : net(net), startTime(startTime), endTime(endTime)
 {
+    numTimes = std::max(0, endTime - startTime + 1);
+
+    // every label starts at 'infinity' with no transition
+    labels.assign((size_t)net->numNodePairs * numTimes, 1000000);
+    transitions.assign((size_t)net->numNodePairs * numTimes, TRANSITION_NONE);
+
+    TLVersions.assign(net->TLList.size(), -1);
+}
+
+
+std::string Hypertree::getTransition(Edge* edge, int t) const
+{
+    if(t < startTime || t > endTime)
+        return "";
+
+    int next = transitions[index(edge->pairIndex, t)];
+
+    if(next == TRANSITION_END)
+        return "end";
+    else if(next == TRANSITION_NONE)
+        return "none";
 
+    return net->edgeList[next]->id;
 }
 
 }
@@ -28,18 +28,64 @@
 #ifndef HYPERTREE_H
 #define HYPERTREE_H
 
-#include <map>
+#include <vector>
 #include <string>
 
 namespace VENTOS {
 
+class Net;
+class Edge;
+
+// Labels and transitions are stored in dense [edge slot][time] arrays. Edges that
+// connect the same two nodes share one slot (Edge::pairIndex), as a hypertree is
+// defined over node pairs.
 class Hypertree
 {
 public:
-    std::map<std::string, double> label;
-    std::map<std::string, std::string> transition;
+    static const int TRANSITION_NONE = -1;  // destination is not reachable
+    static const int TRANSITION_END = -2;   // edge ends at the destination
+
+    Hypertree(Net* net, int startTime, int endTime);
+
+    // expected cost to the destination when entering the slot at time t (startTime <= t <= endTime)
+    double& label(int pair, int t) { return labels[index(pair, t)]; }
+    // index of the next edge (Net::edgeList) or one of TRANSITION_*
+    int& transition(int pair, int t) { return transitions[index(pair, t)]; }
+
+    int transitionAt(int pair, int t) const { return transitions[index(pair, t)]; }
+
+    // same as label, but zero outside of [startTime, endTime]
+    double labelAt(int pair, int t) const
+    {
+        if(t < startTime || t > endTime)
+            return 0;
+
+        return labels[index(pair, t)];
+    }
+
+    // SUMO id of the next edge for a vehicle on edge at time t, or "end"/"none".
+    // Empty string if t is outside of [startTime, endTime]
+    std::string getTransition(Edge* edge, int t) const;
+
+    int getStartTime() const { return startTime; }
+    int getEndTime() const { return endTime; }
+
+    // the labels depend on the timeline of this traffic light (Node::tlIndex) in the given version
+    void dependsOnTL(int tl, int version) { TLVersions[tl] = version; }
+    // version of each traffic light timeline the tree was built with, -1 if the tree does not depend on it
+    const std::vector<int>& getTLVersions() const { return TLVersions; }
+
+private:
+    size_t index(int pair, int t) const { return (size_t)pair * numTimes + (t - startTime); }
+
+    Net* net;
+    int startTime;
+    int endTime;
+    int numTimes;
 
-    Hypertree();
+    std::vector<double> labels;
+    std::vector<int> transitions;
+    std::vector<int> TLVersions;
 };
 
 }
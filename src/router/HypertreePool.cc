@@ -0,0 +1,334 @@
+/****************************************************************************/
+/// @file    HypertreePool.cc
+/// @author  Mani Amoozadeh <maniam@ucdavis.edu>
+/// @author  second author name
+/// @date    October 2017
+///
+/****************************************************************************/
+// VENTOS, Vehicular Network Open Simulator; see http:?
+// Copyright (C) 2013-2015
+/****************************************************************************/
+//
+// This file is part of VENTOS.
+// VENTOS is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#include <list>
+#include <algorithm>
+
+#include "router/HypertreePool.h"
+#include "router/Edge.h"
+#include "router/Node.h"
+
+namespace VENTOS {
+
+HypertreePool::HypertreePool(Net* net, int numThreads) : net(net)
+{
+    for(int i = 0; i < numThreads; i++)
+        workers.push_back(std::thread(&HypertreePool::worker, this));
+}
+
+
+HypertreePool::~HypertreePool()
+{
+    {
+        std::lock_guard<std::mutex> lock(lock_pool);
+        stopping = true;
+    }
+
+    jobAdded.notify_all();
+
+    for(auto &thd : workers)
+        thd.join();
+}
+
+
+void HypertreePool::submit(Node* destination, std::shared_ptr<const hypertreeInput_t> input)
+{
+    {
+        std::lock_guard<std::mutex> lock(lock_pool);
+        submitted[destination] = input->generation;
+    }
+
+    if(workers.empty())
+    {
+        store(destination, *input, build(net, destination, *input));
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(lock_pool);
+
+        // a queued build that has not started yet simply uses the newer input
+        if(queuedInput.find(destination) == queuedInput.end())
+            queue.push_back(destination);
+
+        queuedInput[destination] = input;
+    }
+
+    jobAdded.notify_one();
+}
+
+
+std::shared_ptr<Hypertree> HypertreePool::wait(Node* destination)
+{
+    std::unique_lock<std::mutex> lock(lock_pool);
+
+    // a queued build always has the newest input, and builds of the same destination
+    // never overlap. Once nothing is queued or running, the stored tree is the newest
+    while(queuedInput.find(destination) != queuedInput.end() || running.find(destination) != running.end())
+        treeBuilt.wait(lock);
+
+    auto it = trees.find(destination);
+    if(it == trees.end())
+        return NULL;
+
+    return it->second.second;
+}
+
+
+void HypertreePool::worker()
+{
+    while(true)
+    {
+        Node* destination = NULL;
+        std::shared_ptr<const hypertreeInput_t> input;
+
+        {
+            std::unique_lock<std::mutex> lock(lock_pool);
+
+            while(true)
+            {
+                if(stopping)
+                    return;
+
+                // never build the same destination in two workers at the same time
+                auto it = queue.begin();
+                while(it != queue.end() && running.find(*it) != running.end())
+                    ++it;
+
+                if(it != queue.end())
+                {
+                    destination = *it;
+                    queue.erase(it);
+                    break;
+                }
+
+                jobAdded.wait(lock);
+            }
+
+            input = queuedInput[destination];
+            queuedInput.erase(destination);
+            running.insert(destination);
+        }
+
+        Hypertree* ht = build(net, destination, *input);
+
+        store(destination, *input, ht);
+
+        {
+            std::lock_guard<std::mutex> lock(lock_pool);
+            running.erase(destination);
+        }
+
+        // another job for this destination might have been waiting for us
+        jobAdded.notify_all();
+        treeBuilt.notify_all();
+    }
+}
+
+
+void HypertreePool::store(Node* destination, const hypertreeInput_t& input, Hypertree* ht)
+{
+    std::lock_guard<std::mutex> lock(lock_pool);
+
+    // a newer input was submitted while this tree was being built (e.g. an edge was
+    // removed). This tree is stale and the build of the newer input will replace it
+    auto sub = submitted.find(destination);
+    if(sub != submitted.end() && input.generation < sub->second)
+    {
+        delete ht;
+        return;
+    }
+
+    auto it = trees.find(destination);
+    if(it != trees.end() && it->second.first > input.generation)
+    {
+        // a tree from newer data is already there
+        delete ht;
+        return;
+    }
+
+    trees[destination] = std::make_pair(input.generation, std::shared_ptr<Hypertree>(ht));
+}
+
+
+std::shared_ptr<hypertreeInput_t> HypertreePool::snapshot(Net* net, int generation, int startTime, int endTime)
+{
+    std::shared_ptr<hypertreeInput_t> input = std::make_shared<hypertreeInput_t>();
+
+    input->generation = generation;
+    input->startTime = startTime;
+    input->endTime = endTime;
+
+    input->edges.resize(net->edgeList.size());
+    for(Edge* edge : net->edgeList)
+    {
+        hypertreeEdgeCost_t& entry = input->edges[edge->index];
+        EdgeCosts& travelTimes = edge->travelTimes;
+
+        entry.useHistogram = travelTimes.count > 0;
+        if(entry.useHistogram)
+            for(auto &bin : travelTimes.distribution())
+                entry.histogram.push_back(std::make_pair(bin.travelTime, bin.probability));
+
+        entry.cost = edge->getCost();
+        entry.average = travelTimes.average;
+        entry.disabled = edge->disabled;
+    }
+
+    input->TLs = net->getTLTimings();
+
+    return input;
+}
+
+
+Hypertree* HypertreePool::build(Net* net, Node* destination, const hypertreeInput_t& input)
+{
+    int startTime = input.startTime;
+    int timePeriodMax = input.endTime;
+
+    Hypertree* ht = new Hypertree(net, startTime, timePeriodMax);  // Every label is set to infinity with no transition
+    std::vector<bool> visited(net->nodeList.size(), false);        // Indexed by Node::index
+    std::list<Node*> SE;
+
+    Node* D = destination;    // Find the destination, call it D
+    for(int t = startTime; t <= timePeriodMax; t++)           // For every second in the time interval
+    {
+        for(Edge* inEdge : D->inEdges)  // For every predecessor to D
+        {
+            ht->label(inEdge->pairIndex, t) = 0;    // Set the cost from h to D to 0
+            ht->transition(inEdge->pairIndex, t) = Hypertree::TRANSITION_END;  // And the transition to none
+        }
+    }
+
+    SE.push_back(D);    // Add the destination node to the scan-eligible list
+    while(!SE.empty())  // While the list is not empty
+    {
+        Node* j = SE.front();   // Set j to the first node
+        SE.pop_front();         // And remove the first node from the list
+        for(Edge* ijEdge : j->inEdges)  // For each predecessor to j, ijEdge
+        {
+            Node* i = ijEdge->from;     // Set i to be the predecessor node
+            int ij = ijEdge->pairIndex;
+            const hypertreeEdgeCost_t& ijCost = input.edges[ijEdge->index];
+            if(ijCost.disabled)     // (i, j) is blocked and cannot be the next edge
+                continue;
+
+            for(Edge* hiEdge : i->inEdges)  // For each predecessor to i, hiEdge
+            {
+                int hi = hiEdge->pairIndex;
+
+                // the junction cost only depends on time if i is a traffic light
+                bool isTL = (i->tlIndex >= 0);
+                double turnCost = isTL ? 0 : net->junctionCost(startTime, hiEdge, ijEdge, input.TLs);
+
+                bool improved = false;
+                for(int t = startTime; t <= timePeriodMax; t++)   // For every time step of interest
+                {
+                    double TLDelay = isTL ? net->junctionCost(t, hiEdge, ijEdge, input.TLs) : turnCost;  // The tldelay is the time to the next accepting phase between (h, i) and (i, j)
+                    double n = pathCost(*ht, ij, t, TLDelay, ijCost);
+
+                    double& label = ht->label(hi, t);
+                    if (n < label)            // If the newly calculated label is better
+                    {
+                        label = n;            // Record the cost for making this transition at this time
+                        ht->transition(hi, t) = ijEdge->index;
+                        improved = true;
+                    }
+                }   // For each time in the interval
+
+                // only a transition through i that sets a label makes the tree depend on its timeline
+                if(isTL && improved)
+                    ht->dependsOnTL(i->tlIndex, input.TLs[i->tlIndex].version);
+
+                if(startTime <= timePeriodMax && !visited[i->index]) // If i is not in the SE-set
+                {
+                    SE.push_back(i);            // Add it
+                    visited[i->index] = true;   // And mark it as in the set
+                }
+            }   // For each predecessor to i, h
+        }   // For each predecessor to j, i
+    }   // While SE list has elements
+
+    return ht;
+}
+
+
+
+// expected cost to the destination when entering (i, j) at time t after a junction delay of TLDelay
+double HypertreePool::pathCost(const Hypertree& ht, int ij, int t, double TLDelay, const hypertreeEdgeCost_t& ijCost)
+{
+    double n = 0;
+    if(ijCost.useHistogram) // If we have histogram data
+    {
+        for(auto &val : ijCost.histogram)   // For each bucket of the edge travel time distribution
+        {
+            int travelTime = val.first;     // Set travel time
+            double prob = val.second;       // And its probability
+            double endLabel = ht.labelAt(ij, t + TLDelay + travelTime);   // The endlabel is the label after (i, j) after we've gone through the TL and traveled (i,j)
+            n += (TLDelay + travelTime + endLabel) * prob;  // Add this weight multiplied by its probability
+        }
+    }
+    else    // Otherwise, use the default getCost() function
+    {
+        n = TLDelay + ijCost.cost + ht.labelAt(ij, t + TLDelay + ijCost.cost);
+    }
+
+    return n;
+}
+
+
+bool HypertreePool::affectedBy(Net* net, const Hypertree& ht, Edge* edge, const hypertreeInput_t& input, int fromTime)
+{
+    const hypertreeEdgeCost_t& ijCost = input.edges[edge->index];
+    int ij = edge->pairIndex;
+
+    for(Edge* hiEdge : edge->from->inEdges)
+    {
+        int hi = hiEdge->pairIndex;
+
+        for(int t = std::max(fromTime, ht.getStartTime()); t <= ht.getEndTime(); t++)
+        {
+            if(ijCost.disabled)
+            {
+                // the labels of all other slots only depend on edge through these transitions
+                if(ht.transitionAt(hi, t) == edge->index)
+                    return true;
+            }
+            else
+            {
+                // the edge is available again. It matters if it beats the current choice anywhere
+                double TLDelay = net->junctionCost(t, hiEdge, edge, input.TLs);
+                if(pathCost(ht, ij, t, TLDelay, ijCost) < ht.labelAt(hi, t))
+                    return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+}
@@ -0,0 +1,118 @@
+/****************************************************************************/
+/// @file    HypertreePool.h
+/// @author  Mani Amoozadeh <maniam@ucdavis.edu>
+/// @author  second author name
+/// @date    October 2017
+///
+/****************************************************************************/
+// VENTOS, Vehicular Network Open Simulator; see http:?
+// Copyright (C) 2013-2015
+/****************************************************************************/
+//
+// This file is part of VENTOS.
+// VENTOS is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#ifndef HYPERTREEPOOL_H
+#define HYPERTREEPOOL_H
+
+#include <vector>
+#include <deque>
+#include <map>
+#include <set>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "router/Hypertree.h"
+#include "router/Net.h"
+
+namespace VENTOS {
+
+class Node;
+
+// travel time of an edge, copied from Edge::travelTimes
+typedef struct hypertreeEdgeCost
+{
+    bool useHistogram;                               // EdgeCosts::count > 0
+    std::vector< std::pair<int, double> > histogram; // (travel time, probability) of each EdgeCosts bucket
+    double cost;                                     // Edge::getCost()
+    double average;                                  // EdgeCosts::average, to detect drift
+    bool disabled;                                   // Edge::disabled, the edge is not used as next edge
+} hypertreeEdgeCost_t;
+
+// everything a hypertree depends on that can change during the simulation.
+// Workers only read this and the (immutable) structure of the net
+typedef struct hypertreeInput
+{
+    int generation;
+    int startTime;
+    int endTime;
+    std::vector<hypertreeEdgeCost_t> edges;  // indexed by Edge::index
+    std::vector<TLTiming_t> TLs;             // indexed by Node::tlIndex
+} hypertreeInput_t;
+
+
+// Builds hypertrees in a pool of background threads. The simulation
+// thread only blocks if it needs a tree that is not built yet.
+//
+// The simulation stays deterministic: wait() always returns the tree built
+// from the newest input submitted for a destination, no matter how fast the
+// workers are. Threads only change when that tree becomes available.
+class HypertreePool
+{
+private:
+    Net* net;
+
+    std::mutex lock_pool;
+    std::condition_variable jobAdded;
+    std::condition_variable treeBuilt;
+    bool stopping = false;
+
+    std::deque<Node*> queue;  // destinations waiting for a worker
+    std::map<Node*, std::shared_ptr<const hypertreeInput_t>> queuedInput;
+    std::set<Node*> running;  // destinations a worker is building right now
+    std::map<Node*, std::pair<int, std::shared_ptr<Hypertree>>> trees;  // destination --> (generation, tree)
+    std::map<Node*, int> submitted;  // destination --> generation of the newest submitted input
+
+    std::vector<std::thread> workers;
+
+public:
+    // with numThreads = 0 every tree is built in the calling thread
+    HypertreePool(Net* net, int numThreads);
+    ~HypertreePool();
+
+    // (re)builds the hypertree to destination in the background
+    void submit(Node* destination, std::shared_ptr<const hypertreeInput_t> input);
+    // hypertree to destination built from the newest submitted input, or NULL if nothing
+    // was submitted. Waits if that build is queued or running
+    std::shared_ptr<Hypertree> wait(Node* destination);
+
+    static std::shared_ptr<hypertreeInput_t> snapshot(Net* net, int generation, int startTime, int endTime);
+    static Hypertree* build(Net* net, Node* destination, const hypertreeInput_t& input);
+    // whether a tree would change if it was rebuilt from input, where input only differs in
+    // the availability of edge. Only the labels of the in-edges of edge->from have to be checked
+    static bool affectedBy(Net* net, const Hypertree& ht, Edge* edge, const hypertreeInput_t& input, int fromTime);
+
+private:
+    void worker();
+    void store(Node* destination, const hypertreeInput_t& input, Hypertree* ht);
+    static double pathCost(const Hypertree& ht, int ij, int t, double TLDelay, const hypertreeEdgeCost_t& ijCost);
+};
+
+}
+
+#endif
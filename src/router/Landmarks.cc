@@ -0,0 +1,233 @@
+/****************************************************************************/
+/// @file    Landmarks.cc
+/// @author  Mani Amoozadeh <maniam@ucdavis.edu>
+/// @author  second author name
+/// @date    October 2017
+///
+/****************************************************************************/
+// VENTOS, Vehicular Network Open Simulator; see http:?
+// Copyright (C) 2013-2015
+/****************************************************************************/
+//
+// This file is part of VENTOS.
+// VENTOS is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#include <queue>
+#include <limits>
+#include <functional>
+#include <sstream>
+
+#include "router/Landmarks.h"
+#include "router/Edge.h"
+#include "router/Node.h"
+#include "global/ScenarioSnapshot.h"
+
+namespace VENTOS {
+
+// Unreachable nodes get this distance instead of infinity. Clamping keeps the
+// bounds admissible and consistent, and avoids inf - inf
+static const double UNREACHABLE = 1e9;
+
+
+Landmarks::Landmarks(Net* net, int count, boost::filesystem::path netDir) : net(net)
+{
+    numNodes = net->nodeList.size();
+    count = std::min(count, numNodes);
+
+    std::string snapshotKey = key(netDir, count);
+    ScenarioSnapshot snapshot(netDir, "hello.net.alt");
+
+    if(snapshot.open(snapshotKey))
+    {
+        snapshotReader reader = snapshot.getReader();
+
+        landmarks.resize(count);
+        for(int l = 0; l < count; l++)
+            landmarks[l] = reader.get<int32_t>();
+
+        fromLandmark.resize(count * numNodes);
+        toLandmark.resize(count * numNodes);
+        for(auto &d : fromLandmark)
+            d = reader.get<double>();
+        for(auto &d : toLandmark)
+            d = reader.get<double>();
+
+        return;
+    }
+
+    build(count);
+
+    snapshotWriter writer;
+    for(int l : landmarks)
+        writer.put<int32_t>(l);
+    for(double d : fromLandmark)
+        writer.put<double>(d);
+    for(double d : toLandmark)
+        writer.put<double>(d);
+
+    snapshot.store(snapshotKey, writer.getBuffer());
+}
+
+
+// the tables depend on the net file, the landmark count and the order of Net::nodeList
+std::string Landmarks::key(boost::filesystem::path netDir, int count)
+{
+    boost::filesystem::path netFile = netDir / "hello.net.xml";
+
+    std::ostringstream str;
+    str << boost::filesystem::file_size(netFile) << ":" << boost::filesystem::last_write_time(netFile)
+            << ";landmarks:" << count << ";nodes:" << numNodes << ";edges:" << net->edgeList.size();
+
+    return str.str();
+}
+
+
+// 'farthest' selection: each new landmark is the node that is farthest
+// (forward plus backward distance) from the closest landmark chosen so far
+void Landmarks::build(int count)
+{
+    landmarks.clear();
+    fromLandmark.assign(count * numNodes, UNREACHABLE);
+    toLandmark.assign(count * numNodes, UNREACHABLE);
+
+    if(count == 0)
+        return;
+
+    // start with the node that is farthest from node 0
+    std::vector<double> dist(numNodes);
+    dijkstra(0, true, dist.data());
+    int next = 0;
+    for(int v = 0; v < numNodes; v++)
+        if(dist[v] < UNREACHABLE && dist[v] > dist[next])
+            next = v;
+
+    std::vector<double> closest(numNodes, std::numeric_limits<double>::max());
+    for(int l = 0; l < count; l++)
+    {
+        landmarks.push_back(next);
+        double* from = &fromLandmark[l * numNodes];
+        double* to = &toLandmark[l * numNodes];
+        dijkstra(next, true, from);
+        dijkstra(next, false, to);
+
+        // nodes that cannot be reached in one direction only count with the other
+        for(int v = 0; v < numNodes; v++)
+            closest[v] = std::min(closest[v], (from[v] < UNREACHABLE ? from[v] : 0) + (to[v] < UNREACHABLE ? to[v] : 0));
+
+        next = 0;
+        for(int v = 0; v < numNodes; v++)
+            if(closest[v] > closest[next])
+                next = v;
+    }
+}
+
+
+void Landmarks::dijkstra(int source, bool forward, double* dist)
+{
+    std::fill(dist, dist + numNodes, UNREACHABLE);
+
+    typedef std::pair<double, int> entry_t;
+    std::priority_queue<entry_t, std::vector<entry_t>, std::greater<entry_t>> heap;
+
+    dist[source] = 0;
+    heap.push(std::make_pair(0., source));
+
+    while(!heap.empty())
+    {
+        entry_t top = heap.top();
+        heap.pop();
+
+        int v = top.second;
+        if(top.first > dist[v])
+            continue;
+
+        Node* node = net->nodeList[v];
+        for(Edge* e : (forward ? node->outEdges : node->inEdges))
+        {
+            int w = forward ? e->to->index : e->from->index;
+            double d = dist[v] + baseCost(e);
+            if(d < dist[w])
+            {
+                dist[w] = d;
+                heap.push(std::make_pair(d, w));
+            }
+        }
+    }
+}
+
+
+void Landmarks::targetBounds(Node* destination, double* minFrom, double* maxTo) const
+{
+    for(unsigned int l = 0; l < landmarks.size(); l++)
+    {
+        minFrom[l] = UNREACHABLE;
+        maxTo[l] = 0;
+
+        // targets are the start nodes of the edges into the destination
+        for(Edge* e : destination->inEdges)
+        {
+            int u = e->from->index;
+            minFrom[l] = std::min(minFrom[l], fromLandmark[l * numNodes + u]);
+            maxTo[l] = std::max(maxTo[l], toLandmark[l * numNodes + u]);
+        }
+    }
+}
+
+
+double Landmarks::lowerBound(Node* node, const double* minFrom, const double* maxTo) const
+{
+    int v = node->index;
+    double bound = 0;
+
+    for(unsigned int l = 0; l < landmarks.size(); l++)
+    {
+        // d(v, u) >= d(L, u) - d(L, v)  and  d(v, u) >= d(v, L) - d(u, L)
+        bound = std::max(bound, minFrom[l] - fromLandmark[l * numNodes + v]);
+        bound = std::max(bound, toLandmark[l * numNodes + v] - maxTo[l]);
+    }
+
+    return bound;
+}
+
+
+double Landmarks::baseCost(Edge* e)
+{
+    return e->length / e->speed;
+}
+
+
+double Landmarks::getScale(Net* net)
+{
+    double scale = std::numeric_limits<double>::infinity();
+
+    for(Edge* e : net->edgeList)
+    {
+        double base = baseCost(e);
+        if(base <= 0)
+            continue;
+
+        // same as Edge::getCost, without its debug output
+        double cost = (e->travelTimes.average > 0) ? e->travelTimes.average : e->length / e->speed;
+        scale = std::min(scale, cost / base);
+    }
+
+    if(std::isinf(scale) || scale < 0)
+        return 0;
+
+    return scale;
+}
+
+}
@@ -0,0 +1,85 @@
+/****************************************************************************/
+/// @file    Landmarks.h
+/// @author  Mani Amoozadeh <maniam@ucdavis.edu>
+/// @author  second author name
+/// @date    October 2017
+///
+/****************************************************************************/
+// VENTOS, Vehicular Network Open Simulator; see http:?
+// Copyright (C) 2013-2015
+/****************************************************************************/
+//
+// This file is part of VENTOS.
+// VENTOS is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#ifndef LANDMARKS_H
+#define LANDMARKS_H
+
+#include <vector>
+#include <string>
+
+#undef ev
+#include "boost/filesystem.hpp"
+
+#include "router/Net.h"
+
+namespace VENTOS {
+
+class Edge;
+class Node;
+
+// ALT (A*, landmarks, triangle inequality) lower bounds for RouteSearch.
+//
+// Shortest distances from and to a few landmark nodes are computed once on a
+// 'base' metric (free-flow time, length / speed) and stored next to hello.net.xml.
+// Edge costs change during the simulation, but as long as every edge costs at
+// least scale * baseCost (see getScale), scale times a base-metric bound is still
+// a lower bound of the actual cost. So the tables never have to be rebuilt
+// when EdgeCosts is updated.
+class Landmarks
+{
+public:
+    // loads the tables from '<netDir>/hello.net.alt.bin', or builds and stores them
+    Landmarks(Net* net, int count, boost::filesystem::path netDir);
+
+    int size() const { return landmarks.size(); }
+
+    // per-destination part of the bound. minFrom and maxTo need size() entries
+    void targetBounds(Node* destination, double* minFrom, double* maxTo) const;
+    // base-metric lower bound of the cost from node to the start of any in-edge of the destination
+    double lowerBound(Node* node, const double* minFrom, const double* maxTo) const;
+
+    static double baseCost(Edge* e);
+    // largest scale such that scale * baseCost(e) <= cost of e for all edges
+    static double getScale(Net* net);
+
+private:
+    void build(int count);
+    void dijkstra(int source, bool forward, double* dist);
+    std::string key(boost::filesystem::path netDir, int count);
+
+private:
+    Net* net;
+    int numNodes;
+
+    std::vector<int> landmarks;     // Node::index of each landmark
+    std::vector<double> fromLandmark;   // [l * numNodes + v] = d(landmark l, v)
+    std::vector<double> toLandmark;     // [l * numNodes + v] = d(v, landmark l)
+};
+
+}
+
+#endif
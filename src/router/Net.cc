@@ -47,9 +47,6 @@ Net::~Net()
         for(auto &items2: items.second)
             delete items2;
 
-    for(auto &item : transitions)
-        delete item.second;
-
 }
 
 Net::Net(std::string netBase, omnetpp::cModule* router, int ltc, int rtc, int stc, int utc):leftTurnCost(ltc), rightTurnCost(rtc), straightCost(stc), uTurnCost(utc)
@@ -58,25 +55,102 @@ Net::Net(std::string netBase, omnetpp::cModule* router, int ltc, int rtc, int st
 
     routerModule = router;
     LoadHelloNet(netBase);
+    buildIndices();
+    buildJunctionMoves();
+}
+
+//Maps nodes and edges to contiguous integer ids, so that the routing
+//algorithms can keep their per-node/per-edge data in plain arrays
+void Net::buildIndices()
+{
+    nodeList.clear();
+    TLList.clear();
+    for(auto &item : nodes)
+    {
+        item.second->index = nodeList.size();
+        nodeList.push_back(item.second);
+
+        if(item.second->tl != NULL)
+        {
+            item.second->tlIndex = TLList.size();
+            TLList.push_back(item.second->tl);
+        }
+    }
+
+    edgeList.clear();
+    std::map<std::pair<int,int>, int> pairs;
+    for(auto &item : edges)
+    {
+        Edge* e = item.second;
+        e->index = edgeList.size();
+        edgeList.push_back(e);
+
+        auto ret = pairs.insert(std::make_pair(std::make_pair(e->from->index, e->to->index), (int)pairs.size()));
+        e->pairIndex = ret.first->second;
+    }
+
+    numNodePairs = pairs.size();
+}
+
+//Compiles the TL connections into one junctionMove_t per (in edge, out edge)
+//pair, so that the routing algorithms do not need string keys
+void Net::buildJunctionMoves()
+{
+    for(Node* n : nodeList)
+        for(unsigned int i = 0; i < n->outEdges.size(); i++)
+            n->outEdges[i]->outIndex = i;
+
+    junctionMoves.clear();
+    for(Edge* e : edgeList)
+    {
+        e->moveOffset = junctionMoves.size();
+        junctionMoves.resize(junctionMoves.size() + e->to->outEdges.size(), junctionMove_t());
+    }
+
+    for(auto &item : connections)
+    {
+        for(Connection* c : item.second)
+        {
+            Edge* start = edges.at(c->from);
+            Edge* end = edges.at(c->to);
+            if(end->from != start->to)
+                throw omnetpp::cRuntimeError("Connection from %s to %s does not pass through a junction", c->from.c_str(), c->to.c_str());
+
+            TrafficLightRouter* tl = TLs.at(c->TLid);
+            if(tl->phases.size() > 64)
+                throw omnetpp::cRuntimeError("Traffic light %s has more than 64 phases", c->TLid.c_str());
+
+            junctionMove_t& move = junctionMoves[start->moveOffset + end->outIndex];
+            move.turnType = c->dir;
+            for(unsigned int i = 0; i < tl->phases.size(); i++)
+                if(tl->phases[i]->state[c->linkIndex] != 'r')  //if it's not a red light at this time
+                    move.acceptingPhases |= ((uint64_t)1 << i);  //add that we can travel these edges during this phase
+        }
+    }
+}
+
+const junctionMove_t& Net::junctionMoveOf(Edge* start, Edge* end) const
+{
+    return junctionMoves[start->moveOffset + end->outIndex];
 }
 
 //Returns the expected time waiting to make the turn between two given edges
 //For a TL, this is the time until the next phase allowing that motion
 //Otherwise, this is a constant fixed cost
-double Net::junctionCost(double time, Edge* start, Edge* end)
+double Net::junctionCost(double time, Edge* start, Edge* end, const std::vector<TLTiming_t>& timings)
 {
-    if(start->to->type == "traffic_light")
-        return timeToPhase(start->to->tl, time, nextAcceptingPhase(time, start, end));
+    if(start->to->tlIndex >= 0)
+    {
+        const TLTiming_t& timing = timings[start->to->tlIndex];
+        return timeToPhase(timing, time, nextAcceptingPhase(timing, time, start, end));
+    }
     else
         return turnTypeCost(start, end);
 }
 
 double Net::turnTypeCost(Edge* start, Edge* end)
 {
-    std::string key = start->id + end->id;
-    char type = turnTypes[key];
-
-    switch (type)
+    switch (junctionMoveOf(start, end).turnType)
     {
     case 's':
         return straightCost;
@@ -97,62 +171,114 @@ double Net::turnTypeCost(Edge* start, Edge* end)
     return 100000;
 }
 
-std::vector<int>* Net::TLTransitionPhases(Edge* start, Edge* end)
+double Net::timeToPhase(const TLTiming_t& timing, double time, int targetPhase)
 {
-    return transitions[start->id + end->id];
+    double waitTime = 0;
+    int curPhase = phaseAtTime(timing, time, &waitTime);  //Get the current phase, and how long until it ends
+
+    if(curPhase == targetPhase) //If that phase is active now, we're done
+        return 0;
+
+    if(targetPhase < 0) //No phase allows the movement
+        return 100000;
+
+    //Add the durations of all phases between the end of the current one and the target
+    int n = timing.durations.size();
+    int next = (curPhase + 1) % n;
+    double between = timing.phaseStart[targetPhase] - timing.phaseStart[next];
+    if(targetPhase < next)
+        between += timing.phaseStart[n];
+
+    return waitTime + between;
 }
 
-double Net::timeToPhase(TrafficLightRouter* tl, double time, int targetPhase)
+int Net::nextAcceptingPhase(const TLTiming_t& timing, double time, Edge* start, Edge* end)
 {
-    double *waitTime = new double;
-    int curPhase = tl->currentPhaseAtTime(time, waitTime);  //Get the current phase, and how long until it ends
+    int curPhase = phaseAtTime(timing, time);
+    uint64_t accepting = junctionMoveOf(start, end).acceptingPhases;  // Grab the accepting phases for the given turn
 
-    if(curPhase == targetPhase) //If that phase is active now, we're done
+    if(accepting == 0)
+        return -1;
+
+    // the first accepting phase at or after the current one, otherwise the first one in the next cycle
+    uint64_t later = accepting >> curPhase;
+    if(later != 0)
+        return curPhase + __builtin_ctzll(later);
+
+    return __builtin_ctzll(accepting);
+}
+
+//Same as TrafficLightRouter::currentPhaseAtTime, which only adds whole seconds to
+//its (int) switch time. Instead of walking the phases we look up the position in the cycle
+int Net::phaseAtTime(const TLTiming_t& timing, double time, double* timeRemaining)
+{
+    int phase = timing.currentPhase;
+    int curTime = timing.lastSwitchTime + timing.currentDuration; //Start at the next switch
+    int cycle = timing.phaseOfSecond.size();
+
+    if(time >= curTime && cycle > 0)
     {
-        return 0;
+        int n = timing.durations.size();
+        int next = (phase + 1) % n;
+
+        //Time since the start of the cycle that contains the switch to 'next'
+        double elapsed = time - (curTime - timing.switchOffset[next]);
+        int cycles = (int)(elapsed / cycle);
+        double pos = elapsed - (double)cycles * cycle;
+
+        phase = timing.phaseOfSecond[(int)pos];
+        curTime = (curTime - timing.switchOffset[next]) + cycles * cycle + timing.switchOffset[phase + 1];
     }
-    else
+
+    if(timeRemaining != NULL)
+        *timeRemaining = curTime - time;
+
+    return phase;
+}
+
+void Net::compileTiming(TLTiming_t& timing)
+{
+    int n = timing.durations.size();
+
+    timing.phaseStart.assign(n + 1, 0);
+    timing.switchOffset.assign(n + 1, 0);
+    for(int i = 0; i < n; i++)
     {
-        curPhase = (curPhase + 1) % tl->phases.size();
-        if(curPhase == targetPhase)
-        {
-            return *waitTime;
-        }
-        else
-        {
-            while(curPhase != targetPhase)
-            {
-                *waitTime += (double)tl->phases[curPhase]->duration;
-                curPhase = (curPhase + 1) % tl->phases.size();
-            }
-            return *waitTime;
-        }
+        timing.phaseStart[i + 1] = timing.phaseStart[i] + timing.durations[i];
+        timing.switchOffset[i + 1] = timing.switchOffset[i] + (int)timing.durations[i];
     }
 
+    timing.phaseOfSecond.clear();
+    for(int i = 0; i < n; i++)
+        timing.phaseOfSecond.insert(timing.phaseOfSecond.end(), timing.switchOffset[i + 1] - timing.switchOffset[i], i);
 }
 
-int Net::nextAcceptingPhase(double time, Edge* start, Edge* end)
+bool Net::samePlan(const TLTiming_t& a, const TLTiming_t& b)
 {
-    TrafficLightRouter* tl = start->to->tl;           // The traffic-light in question
-    const std::vector<Phase*> phases = tl->phases;   // And its set of phases
+    if(a.durations != b.durations)
+        return false;
 
-    int curPhase = tl->currentPhaseAtTime(time);
-    int phase = curPhase;
-    std::vector<int>* acceptingPhases = TLTransitionPhases(start, end);  // Grab the vector of accepting phases for the given turn
+    int cycle = a.phaseOfSecond.size();
 
-    do
-    {
-        if(find(acceptingPhases->begin(), acceptingPhases->end(), phase) != acceptingPhases->end()) // If the phase is in the accepting phases, return it
-            return phase;
-        else    // Otherwise, check the next phase
-        {
-            phase++;
-            if((unsigned)phase >= phases.size())
-                phase = 0;
-        }
-    }while(phase != curPhase);  // Break when we're back to the first phase (should never reach here)
+    //Start of the cycle that contains the end of the current phase (see phaseAtTime)
+    int startA = (int)(a.lastSwitchTime + a.currentDuration) - a.switchOffset[a.currentPhase + 1];
+    int startB = (int)(b.lastSwitchTime + b.currentDuration) - b.switchOffset[b.currentPhase + 1];
+
+    if(cycle == 0)
+        return startA == startB;
 
-    return -1;
+    return ((startA - startB) % cycle) == 0;
+}
+
+//The timelines are kept up to date by the traffic lights, so this is a plain copy
+std::vector<TLTiming_t> Net::getTLTimings()
+{
+    std::vector<TLTiming_t> timings(TLList.size());
+
+    for(unsigned int i = 0; i < TLList.size(); i++)
+        timings[i] = TLList[i]->getTiming();
+
+    return timings;
 }
 
 
@@ -160,169 +286,84 @@ void Net::LoadHelloNet(std::string netBase)
 {
     omnetpp::cModuleType* moduleType = omnetpp::cModuleType::get("VENTOS.src.trafficLight.TL_Router");    //Get the TL module
 
-    std::string netFile = netBase + "/hello.net.xml";
+    //Parsed once per process and shared with the other modules (see SumoNet)
+    std::shared_ptr<const SumoNet> model = SumoNet::load(boost::filesystem::path(netBase) / "hello.net.xml");
 
-    rapidxml::file <> xmlFile(netFile.c_str());   //Make a new rapidXML document to parse
-    rapidxml::xml_document<> doc;
-    rapidxml::xml_node<> *node;
-    doc.parse<0>(xmlFile.data());
+    std::vector<TrafficLightRouter*> tlByIndex(model->tlLogics.size(), NULL);
 
     //For every node
-    for(node = doc.first_node()->first_node("junction"); node; node = node->next_sibling("junction"))
+    for(auto &junction : model->junctions)
     {
-        //Read all the attributes in
-        rapidxml::xml_attribute<> *attr = node->first_attribute();
-        std::string id = attr->value();
-
-        attr = attr->next_attribute();
-        std::string type = attr->value();
-
-        attr = attr->next_attribute();
-        double x = atof(attr->value());
-
-        attr = attr->next_attribute();
-        double y = atof(attr->value());
-
-        //Break the incoming lanes list into a vector
-        attr = attr->next_attribute();
-        std::string incLanesString = attr->value();
-        std::vector<std::string>* incLanes = new std::vector<std::string>;
-        std::stringstream ssin(incLanesString);
-        while(ssin.good())
-        {
-            std::string temp;
-            ssin >> temp;
-            if(temp.length() > 0)
-                incLanes->push_back(temp);
-        }
-
-        //If we're looking at a traffic light
+        //If we're looking at a traffic light, build it from the tlLogic with the same id
         TrafficLightRouter *tl = NULL;
-        if(type == "traffic_light")
+        if(junction.type == "traffic_light" && junction.tlLogic != -1)
         {
-            //Find the referenced traffic light (based on name, the first attribute)
-            for(rapidxml::xml_node<> *tlNode = doc.first_node()->first_node("tlLogic"); tlNode; tlNode = tlNode->next_sibling("tlLogic"))
-            {
-                if(tlNode->first_attribute()->value() == id)
-                {
-                    //Read its attributes in
-                    rapidxml::xml_attribute<> *tlAttr = tlNode->first_attribute();
-                    std::string tlid = tlAttr->value();
-                    tlAttr = tlAttr->next_attribute();
-                    std::string tltype = tlAttr->value();
-                    tlAttr = tlAttr->next_attribute();
-                    std::string programID = tlAttr->value();
-                    tlAttr = tlAttr->next_attribute();
-                    double tloffset = atof(tlAttr->value());
-
-                    //Read in its set of phases
-                    std::vector<Phase*> phasesVec;
-                    for(rapidxml::xml_node<> *phaseNode = tlNode->first_node("phase"); phaseNode; phaseNode = phaseNode->next_sibling("phase"))
-                    {
-                        double duration = atof(phaseNode->first_attribute()->value());
-                        std::string state = phaseNode->first_attribute()->next_attribute()->value();
-                        Phase *ph = new Phase(duration, state);
-                        phasesVec.push_back(ph);   //Build and link a new phase for each attribute
-                    }
-
-                    omnetpp::cModule *mod = moduleType->create("TrafficLight", routerModule); //Create a TL module with router as its parent
-                    tl = omnetpp::check_and_cast<TrafficLightRouter*>(mod);                   //Cast the new module to a TL
-                    tl->build(tlid, tltype, programID, tloffset, phasesVec, this);   //And build the traffic light with all this info
-                    TLs[tlid] = tl; //Add the TL to the TL set
-                    break;
-                }//if matching traffic light
-            }//for each traffic light
+            const netTLLogic_t &logic = model->tlLogics[junction.tlLogic];
+
+            //Read in its set of phases
+            std::vector<Phase*> phasesVec;
+            for(auto &phase : logic.phases)
+                phasesVec.push_back(new Phase(phase.duration, phase.state));
+
+            omnetpp::cModule *mod = moduleType->create("TrafficLight", routerModule); //Create a TL module with router as its parent
+            tl = omnetpp::check_and_cast<TrafficLightRouter*>(mod);                   //Cast the new module to a TL
+            tl->build(logic.id, logic.type, logic.programID, logic.offset, phasesVec, this);   //And build the traffic light with all this info
+            TLs[logic.id] = tl; //Add the TL to the TL set
+            tlByIndex[junction.tlLogic] = tl;
         }//if traffic light
 
-        Node *n = new Node(id, x, y, type, incLanes, tl); //Finally build the node
-        nodes[id] = n;
+        std::vector<std::string> incLanes;
+        for(int lane : junction.incLanes)
+            incLanes.push_back(model->lanes[lane].id);
+
+        Node *n = new Node(junction.id, junction.x, junction.y, junction.type, incLanes, tl); //Finally build the node
+        nodes[junction.id] = n;
     }
 
-    //For every edge
-    for(node = doc.first_node()->first_node("edge"); node; node = node->next_sibling("edge"))
+    //For every edge. Internal edges (inside junctions) are not part of the routing graph
+    for(auto &edge : model->edges)
     {
-        rapidxml::xml_attribute<> *attr = node->first_attribute();    //Read the basic attributes in
-        std::string id = attr->value();
-        attr = attr->next_attribute();
-        std::string fromVal = attr->value();
-        attr = attr->next_attribute();
-        std::string toVal = attr->value();
-        attr = attr->next_attribute();
-        int priority = atoi(attr->value());
-
-        std::vector<Lane*>* lanesVec = new std::vector<Lane*>;    //For every lane on that edge
-        for(rapidxml::xml_node<> *lane = node->first_node(); lane; lane = lane->next_sibling())
+        if(edge.internal)
+            continue;
+
+        std::vector<Lane*> lanesVec;    //For every lane on that edge
+        for(int lane : edge.lanes)
         {
-            attr = lane->first_attribute(); //Read the lane's attributes in
-            std::string laneid = attr->value();
-            attr = attr->next_attribute()->next_attribute();
-            double speed = atof(attr->value());
-            attr = attr->next_attribute();
-            double length = atof(attr->value());
-            Lane* l = new Lane(laneid, speed, length);  //Build the lane
-            lanesVec->push_back(l); //Add it to a vector of this edge's lanes
+            const netLane_t &l = model->lanes[lane];
+            lanesVec.push_back(new Lane(l.id, l.speed, l.length));
         }
-        Node* from = nodes[fromVal];  //Get a pointer to the start node
-        Node* to = nodes[toVal];      //Get a pointer to the end node
-        edges[id] = new Edge(id, from, to, priority, *lanesVec);
 
-        from->outEdges.push_back(edges.at(id));   //Add the edge to the start node's list
+        Node* from = nodes.at(model->junctions[edge.from].id);  //Get a pointer to the start node
+        Node* to = nodes.at(model->junctions[edge.to].id);      //Get a pointer to the end node
+        edges[edge.id] = new Edge(edge.id, from, to, edge.priority, lanesVec);
+
+        from->outEdges.push_back(edges.at(edge.id));   //Add the edge to the start node's list
     }   //For every edge
 
     for(std::map<std::string, Edge*>::iterator it = edges.begin(); it != edges.end(); ++it)   //For each edge
         (*it).second->to->inEdges.push_back((*it).second);  //Go to the destination fo that edge, and add that edge to its in-edges
 
     //Make a new mapping from std::string to int vector.  strings will be the start and end lanes, and lanes will be the lane numbers from start than connect them.
-    for(node = doc.first_node()->first_node("connection"); node; node = node->next_sibling("connection"))
-    {   //For every connection
-        rapidxml::xml_attribute<> *attr = node->first_attribute();    //Read in the start and end edge ids, and the lane number of this instance.
-        std::string e1 = attr->value();
+    for(auto &conn : model->connections)
+    {
+        //Only connections controlled by one of our traffic lights
+        TrafficLightRouter* tl = (conn.tl == -1) ? NULL : tlByIndex[conn.tl];
+        if(tl == NULL)
+            continue;
 
-        attr = attr->next_attribute();
-        std::string e2 = attr->value();
+        const std::string &e1 = model->edges[conn.from].id;
+        const std::string &e2 = model->edges[conn.to].id;
         std::string key = e1 + e2;       //Key is the concatenation of both IDs.
 
-        attr = attr->next_attribute();
-        int fromLaneNum = atoi(attr->value());
-
-        attr = attr->next_attribute();
-        int toLaneNum = atoi(attr->value());
-
-        attr = attr->next_attribute();
-        if((std::string)attr->name() == "tl")    //Read the tl attributes if necessary
-        {
-            if(transitions.find(key) == transitions.end()) //If this vector doesn't yet exist
-                transitions[key] = new std::vector<int>;  //Create an empty vector in place
-            TrafficLightRouter* tl = TLs[attr->value()];    //Find the associated traffic light
-            std::string TLid = attr->value();
-
-            attr = attr->next_attribute();
-            int linkIndex = atoi(attr->value());
-
-            for(unsigned int i = 0; i < tl->phases.size(); i++)
-            {
-                Phase* phase = tl->phases[i];
-                if(phase->state[linkIndex] != 'r')  //if it's not a red light at this time
-                    transitions[key]->push_back(i);  //add that we can travel these edges during this phase
-            }
-
-            Edge* fromEdge = edges.at(e1);
-            Lane* fromLane = (fromEdge->lanes)[fromLaneNum];
-
-            for(unsigned int i = 0; i < tl->phases.size(); i++)      //These 3 lines took me way too long to develop
-                //if (tl->phases[i]->state[linkIndex] == 'g' || tl->phases[i]->state[linkIndex] == 'G') //Check each of the TL's phases -- if the state's value at the given link index allows movement,
-                if(tl->phases[i]->state[linkIndex] != 'r')
-                    fromLane->greenPhases.push_back(i);     //Push that phase to a list of green phases for that lane
-
-            attr = attr->next_attribute();
-            char dir = attr->value()[0];
-            turnTypes[key] = dir;
+        Edge* fromEdge = edges.at(e1);
+        Lane* fromLane = (fromEdge->lanes)[conn.fromLane];
 
-            attr = attr->next_attribute();
-            char state = attr->value()[0];
+        for(unsigned int i = 0; i < tl->phases.size(); i++)      //These 3 lines took me way too long to develop
+            //if (tl->phases[i]->state[linkIndex] == 'g' || tl->phases[i]->state[linkIndex] == 'G') //Check each of the TL's phases -- if the state's value at the given link index allows movement,
+            if(tl->phases[i]->state[conn.linkIndex] != 'r')
+                fromLane->greenPhases.push_back(i);     //Push that phase to a list of green phases for that lane
 
-            connections[key].push_back(new Connection(e1, e2, fromLaneNum, toLaneNum, TLid, linkIndex, dir, state));
-        }//if it's a tl
+        connections[key].push_back(new Connection(e1, e2, conn.fromLane, conn.toLane, model->tlLogics[conn.tl].id, conn.linkIndex, conn.dir, conn.state));
     }//for each connection
 }
 
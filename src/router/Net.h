@@ -33,6 +33,7 @@
 #include <iostream>
 #include <sstream>
 #include <algorithm> // For sort
+#include <stdint.h>
 
 #include "rapidxml.hpp"
 #include "rapidxml_utils.hpp"
@@ -40,6 +41,7 @@
 #include "router/Router.h"
 #include "router/Vehicle.h"
 #include "router/EdgeCosts.h"
+#include "global/SumoNet.h"
 
 namespace VENTOS {
 
@@ -65,20 +67,54 @@ public:
 };
 
 
+//Cyclic timeline of a traffic light (see TrafficLightRouter::updateTiming). Copies
+//of it can be used outside of the simulation thread
+typedef struct TLTiming
+{
+    int currentPhase;
+    double lastSwitchTime;
+    double currentDuration;         //duration of the current phase, which can differ from its planned duration
+    std::vector<double> durations;  //duration of each phase
+    int version = 0;                //changes whenever the timeline predicts other phases than before
+
+    //Filled by Net::compileTiming
+    std::vector<double> phaseStart;     //phaseStart[i] = sum of durations[0..i-1], one more entry than durations
+    std::vector<int> switchOffset;      //same as phaseStart, but with whole-second durations like currentPhaseAtTime
+    std::vector<int> phaseOfSecond;     //phase that is active in each second of the (whole-second) cycle
+} TLTiming_t;
+
+
+//Movement from one edge to one of the out edges of its end node
+typedef struct junctionMove
+{
+    char turnType;              //'s', 'r', 'l', 't' or 0 if there is no TL connection
+    uint64_t acceptingPhases;   //bit i is set if phase i of the traffic light allows the movement
+} junctionMove_t;
+
+
 class Net
 {
 public:
     Net(std::string netBase, omnetpp::cModule* router, int ltc, int rtc, int stc, int utc);
     ~Net();
 
-    double junctionCost(double time, Edge* start, Edge* end);       //If it's a TL, returns the time spent waiting.  If not, returns turnTypeCost
+    //Traffic lights are taken from a snapshot (indexed by Node::tlIndex) instead of the live
+    //TrafficLightRouter modules. Only reads the net, so they can be called from several threads
+    double junctionCost(double time, Edge* start, Edge* end, const std::vector<TLTiming_t>& timings);  //If it's a TL, returns the time spent waiting.  If not, returns turnTypeCost
     double turnTypeCost(Edge* start, Edge* end);                    //Returns the turn penalty on an intersection
-    double timeToPhase(TrafficLightRouter* tl, double time, int phase);   //Returns how long we must wait for a given phase at the given time
-    int nextAcceptingPhase(double time, Edge* start, Edge* end);    //Returns the next phase allowing movement from start to end at the given time
-    std::vector<int>* TLTransitionPhases(Edge* start, Edge* end);        //Returns a vector of phases allowing movement from start to end
+    double timeToPhase(const TLTiming_t& timing, double time, int phase);   //Returns how long we must wait for a given phase at the given time
+    int nextAcceptingPhase(const TLTiming_t& timing, double time, Edge* start, Edge* end);    //Returns the next phase allowing movement from start to end at the given time
+    static int phaseAtTime(const TLTiming_t& timing, double time, double* timeRemaining = NULL);
+    std::vector<TLTiming_t> getTLTimings();                              //Snapshot of all traffic lights, indexed by Node::tlIndex
+    static void compileTiming(TLTiming_t& timing);
+    static bool samePlan(const TLTiming_t& a, const TLTiming_t& b);        //True if both timings predict the same phase at any time
+
+    const junctionMove_t& junctionMoveOf(Edge* start, Edge* end) const;     //start->to must be end->from
 
 private:
     void LoadHelloNet(std::string netBase);
+    void buildIndices();
+    void buildJunctionMoves();
 
 public:
     double leftTurnCost, rightTurnCost, straightCost, uTurnCost;
@@ -90,8 +126,13 @@ public:
     std::map<std::string, Node*> nodes;
     std::map<std::string, Vehicle*> vehicles;
     std::map<std::string, std::vector<Connection*> > connections;
-    std::map<std::string, std::vector<int>* > transitions;  //Given a pair of edge IDs concatenated, returns a vector of TL phases that allow movement between them
-    std::map<std::string, char> turnTypes;           //Given a pair of edge IDs concatenated, returns the turn type between those two
+
+    //Dense integer ids, assigned once the net is loaded
+    std::vector<Node*> nodeList;    //Node::index --> Node
+    std::vector<Edge*> edgeList;    //Edge::index --> Edge
+    std::vector<TrafficLightRouter*> TLList;  //Node::tlIndex --> traffic light
+    int numNodePairs = 0;           //Number of distinct Edge::pairIndex values
+    std::vector<junctionMove_t> junctionMoves;  //Every (in edge, out edge) pair of every node, see junctionMoveOf
 };
 
 }
@@ -35,8 +35,8 @@ bool Node::operator==(const Node& rhs)
     return this->id == rhs.id;
 }*/
 
-Node::Node(std::string id, double x, double y, std::string type, std::vector<std::string>* incLanes, TrafficLightRouter* tl): // Build a node
-                  id(id), x(x), y(y), type(type), incLanes(incLanes), tl(tl){}
+Node::Node(std::string id, double x, double y, std::string type, std::vector<std::string> incLanes, TrafficLightRouter* tl): // Build a node
+                  id(id), index(-1), x(x), y(y), type(type), incLanes(incLanes), tl(tl), tlIndex(-1){}
 
 std::ostream& operator<<(std::ostream& os, Node &rhs) // Print a node
 {
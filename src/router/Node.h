@@ -44,14 +44,16 @@ public:
     std::vector<Edge*> outEdges;
     std::vector<Edge*> inEdges;
     std::string id;
+    int index;  //Position in Net::nodeList
     double x;
     double y;
     std::string type;
-    std::vector<std::string>* incLanes;
+    std::vector<std::string> incLanes;
     TrafficLightRouter* tl;
+    int tlIndex;    //Position of tl in Net::TLList, or -1
 
     //bool operator==(const Node& rhs);
-    Node(std::string idVal, double xVal, double yVal, std::string typeVal, std::vector<std::string>* incLanesVal, TrafficLightRouter* tlVal);
+    Node(std::string idVal, double xVal, double yVal, std::string typeVal, std::vector<std::string> incLanesVal, TrafficLightRouter* tlVal);
 };
 
 std::ostream& operator<<(std::ostream& os, Node &rhs);
@@ -0,0 +1,291 @@
+/****************************************************************************/
+/// @file    RouteSearch.cc
+/// @author  Mani Amoozadeh <maniam@ucdavis.edu>
+/// @author  second author name
+/// @date    October 2017
+///
+/****************************************************************************/
+// VENTOS, Vehicular Network Open Simulator; see http:?
+// Copyright (C) 2013-2015
+/****************************************************************************/
+//
+// This file is part of VENTOS.
+// VENTOS is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+#include "router/RouteSearch.h"
+#include "router/Landmarks.h"
+#include "router/Edge.h"
+#include "router/Node.h"
+
+namespace VENTOS {
+
+thread_local RouteSearch::workspace_t RouteSearch::ws;
+
+
+static inline double distance(Node* a, Node* b)
+{
+    return std::hypot(a->x - b->x, a->y - b->y);
+}
+
+
+std::vector<Edge*> RouteSearch::search(Net* net, const routeQuery_t& query, double* cost)
+{
+    prepare(net->edgeList.size(), net->nodeList.size());
+
+    Node* D = query.destination;
+
+    // straight-line distance from D to the farthest start of an edge that ends at D.
+    // Subtracting it keeps the heuristic zero on all destination edges
+    double radius = 0;
+    for(Edge* e : D->inEdges)
+        radius = std::max(radius, distance(e->from, D));
+
+    if(query.landmarks)
+    {
+        ws.minFrom.resize(query.landmarks->size());
+        ws.maxTo.resize(query.landmarks->size());
+        query.landmarks->targetBounds(D, ws.minFrom.data(), ws.maxTo.data());
+    }
+
+    int o = query.origin->index;
+    ws.reached[o] = ws.epoch;
+    ws.cost[o] = 0;    // Set the origin's start cost to 0
+    ws.key[o] = 0;
+    ws.best[o] = -1;
+    ws.heapPos[o] = -1;
+    push(o);
+
+    while(!ws.heap.empty())    // While there are unexplored edges (always, if graph is fully connected)
+    {
+        int p = pop();                      // Set parent to the closest unexplored edge
+        Edge* parent = net->edgeList[p];
+        ws.closed[p] = ws.epoch;
+
+        if(parent->disabled)
+            continue;
+
+        if(parent->to == D)     // If we found the destination!
+        {
+            std::vector<Edge*> route;   // Start backtracking to generate the route
+            for(int e = p; e != -1; e = ws.best[e])
+                route.push_back(net->edgeList[e]);
+            std::reverse(route.begin(), route.end());
+            if(cost)
+                *cost = ws.cost[p];
+            return route;
+        }
+
+        // Vehicles may not necessarily start at the beginning of a lane
+        double curLaneCost = (parent == query.origin ? query.originFraction : 1) * parent->getCost();
+        double parentCost = ws.cost[p];
+
+        for(Edge* child : parent->to->outEdges)   // Go through every edge was can get to from the parent
+        {
+            int c = child->index;
+            if(ws.closed[c] == ws.epoch)    // If we have finished the edge
+                continue;
+
+            double newCost = parentCost + curLaneCost;  // Time to get to the junction is the time we get to the edge plus the edge cost
+            if(newCost < query.TLLookahead)
+                newCost += net->junctionCost(newCost + query.startTime, parent, child, *query.TLTimings); // The cost at the junction is calculated from when we'd arrive there
+
+            if(ws.reached[c] != ws.epoch)
+            {
+                ws.reached[c] = ws.epoch;
+                ws.heapPos[c] = -1;
+            }
+            else if(newCost >= ws.cost[c])
+                continue;
+
+            double h = heuristic(child->from, query, radius);
+
+            ws.cost[c] = newCost;   // Cost to the child is newCost
+            ws.key[c] = newCost + h;
+            ws.best[c] = p;         // Best path to the child is through the parent
+
+            if(ws.heapPos[c] == -1)
+                push(c);
+            else
+                decreaseKey(c);
+        }
+    }
+
+    return std::vector<Edge*>();
+}
+
+
+// lower bound of the cost from the node to the start of an in-edge of the destination.
+// Each bound is consistent, and so is their maximum
+double RouteSearch::heuristic(Node* node, const routeQuery_t& query, double radius)
+{
+    int n = node->index;
+    if(ws.hStamp[n] == ws.epoch)
+        return ws.hNode[n];
+
+    double h = 0;
+    if(query.heuristicScale > 0)
+        h = query.heuristicScale * std::max(0.0, distance(node, query.destination) - radius);
+
+    if(query.landmarks && query.landmarkScale > 0)
+        h = std::max(h, query.landmarkScale * query.landmarks->lowerBound(node, ws.minFrom.data(), ws.maxTo.data()));
+
+    ws.hStamp[n] = ws.epoch;
+    ws.hNode[n] = h;
+
+    return h;
+}
+
+
+double RouteSearch::heuristicScale(Net* net)
+{
+    double scale = std::numeric_limits<double>::infinity();
+
+    for(Edge* e : net->edgeList)
+    {
+        double dist = distance(e->from, e->to);
+        if(dist <= 1e-6)
+            continue;
+
+        // same as Edge::getCost, without its debug output
+        double cost = (e->travelTimes.average > 0) ? e->travelTimes.average : e->length / e->speed;
+        scale = std::min(scale, cost / dist);
+    }
+
+    if(std::isinf(scale) || scale < 0)
+        return 0;
+
+    return scale;
+}
+
+
+void RouteSearch::prepare(size_t numEdges, size_t numNodes)
+{
+    if(ws.reached.size() != numEdges || ws.hStamp.size() != numNodes)
+    {
+        ws.reached.assign(numEdges, 0);
+        ws.closed.assign(numEdges, 0);
+        ws.cost.resize(numEdges);
+        ws.key.resize(numEdges);
+        ws.best.resize(numEdges);
+        ws.heapPos.resize(numEdges);
+        ws.hStamp.assign(numNodes, 0);
+        ws.hNode.resize(numNodes);
+        ws.epoch = 0;
+    }
+
+    // after 2^32 queries the stamps wrap around and have to be cleared once
+    if(++ws.epoch == 0)
+    {
+        std::fill(ws.reached.begin(), ws.reached.end(), 0);
+        std::fill(ws.closed.begin(), ws.closed.end(), 0);
+        std::fill(ws.hStamp.begin(), ws.hStamp.end(), 0);
+        ws.epoch = 1;
+    }
+
+    ws.heap.clear();
+}
+
+
+void RouteSearch::push(int edge)
+{
+    ws.heapPos[edge] = ws.heap.size();
+    ws.heap.push_back(edge);
+    siftUp(ws.heap.size() - 1);
+}
+
+
+void RouteSearch::decreaseKey(int edge)
+{
+    siftUp(ws.heapPos[edge]);
+}
+
+
+int RouteSearch::pop()
+{
+    int top = ws.heap[0];
+    ws.heapPos[top] = -1;
+
+    int last = ws.heap.back();
+    ws.heap.pop_back();
+    if(!ws.heap.empty())
+    {
+        ws.heap[0] = last;
+        ws.heapPos[last] = 0;
+        siftDown(0);
+    }
+
+    return top;
+}
+
+
+void RouteSearch::siftUp(int pos)
+{
+    int edge = ws.heap[pos];
+    double key = ws.key[edge];
+
+    while(pos > 0)
+    {
+        int parent = (pos - 1) / ARITY;
+        int parentEdge = ws.heap[parent];
+        if(ws.key[parentEdge] <= key)
+            break;
+
+        ws.heap[pos] = parentEdge;
+        ws.heapPos[parentEdge] = pos;
+        pos = parent;
+    }
+
+    ws.heap[pos] = edge;
+    ws.heapPos[edge] = pos;
+}
+
+
+void RouteSearch::siftDown(int pos)
+{
+    int size = ws.heap.size();
+    int edge = ws.heap[pos];
+    double key = ws.key[edge];
+
+    while(true)
+    {
+        int first = pos * ARITY + 1;
+        if(first >= size)
+            break;
+
+        // smallest of the (up to ARITY) children
+        int smallest = first;
+        int last = std::min(first + ARITY, size);
+        for(int c = first + 1; c < last; c++)
+            if(ws.key[ws.heap[c]] < ws.key[ws.heap[smallest]])
+                smallest = c;
+
+        if(ws.key[ws.heap[smallest]] >= key)
+            break;
+
+        ws.heap[pos] = ws.heap[smallest];
+        ws.heapPos[ws.heap[pos]] = pos;
+        pos = smallest;
+    }
+
+    ws.heap[pos] = edge;
+    ws.heapPos[edge] = pos;
+}
+
+}
@@ -0,0 +1,108 @@
+/****************************************************************************/
+/// @file    RouteSearch.h
+/// @author  Mani Amoozadeh <maniam@ucdavis.edu>
+/// @author  second author name
+/// @date    October 2017
+///
+/****************************************************************************/
+// VENTOS, Vehicular Network Open Simulator; see http:?
+// Copyright (C) 2013-2015
+/****************************************************************************/
+//
+// This file is part of VENTOS.
+// VENTOS is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#ifndef ROUTESEARCH_H
+#define ROUTESEARCH_H
+
+#include <vector>
+#include <stdint.h>
+
+#include "router/Net.h"
+
+namespace VENTOS {
+
+class Edge;
+class Node;
+class Landmarks;
+
+// parameters of one point-to-point query
+typedef struct routeQuery
+{
+    Edge* origin;
+    Node* destination;
+    double originFraction;  // part of the origin edge that is still ahead of the vehicle
+    double startTime;       // simulation time of the query
+    double TLLookahead;     // junction costs are only added while the cost so far is below this
+    const std::vector<TLTiming_t>* TLTimings;  // only needed if TLLookahead > 0
+    double heuristicScale;  // lower bound of cost per meter of straight-line distance. 0 = plain Dijkstra
+    const Landmarks* landmarks;  // optional ALT bounds (NULL = none)
+    double landmarkScale;        // see Landmarks::getScale
+} routeQuery_t;
+
+
+// Dijkstra/A* over the edges of the net. Edges are the vertices of the search
+// graph, so that junction (turn) costs can be charged between two edges.
+//
+// All per-edge search state lives in a per-thread workspace indexed by Edge::index.
+// A query only touches the edges it reaches: the workspace is invalidated by
+// bumping an epoch counter instead of clearing it.
+class RouteSearch
+{
+private:
+    typedef struct workspace
+    {
+        uint32_t epoch = 0;
+        std::vector<uint32_t> reached;  // == epoch if cost/best/heapPos are valid in this query
+        std::vector<uint32_t> closed;   // == epoch once the edge is settled
+        std::vector<double> cost;       // cost to reach the start of the edge
+        std::vector<double> key;        // cost + heuristic
+        std::vector<int> best;          // predecessor edge, or -1
+        std::vector<int> heapPos;       // position in heap, or -1
+
+        std::vector<int> heap;          // 4-ary min-heap of edge indices, ordered by key
+
+        std::vector<uint32_t> hStamp;   // == epoch if hNode is valid in this query
+        std::vector<double> hNode;      // heuristic of each node (Node::index)
+        std::vector<double> minFrom;    // see Landmarks::targetBounds
+        std::vector<double> maxTo;
+    } workspace_t;
+
+    static const int ARITY = 4;
+    static thread_local workspace_t ws;
+
+public:
+    // edges from origin to an in-edge of destination. Empty if there is no route.
+    // cost (optional) is set to the cost to the start of the last edge
+    static std::vector<Edge*> search(Net* net, const routeQuery_t& query, double* cost = NULL);
+
+    // largest scale such that scale * (straight-line distance between the end nodes)
+    // never exceeds the cost of an edge. Makes the A* heuristic admissible and consistent
+    static double heuristicScale(Net* net);
+
+private:
+    static void prepare(size_t numEdges, size_t numNodes);
+    static double heuristic(Node* node, const routeQuery_t& query, double radius);
+    static void push(int edge);
+    static void decreaseKey(int edge);
+    static int pop();
+    static void siftUp(int pos);
+    static void siftDown(int pos);
+};
+
+}
+
+#endif
@@ -26,10 +26,17 @@
 //
 
 #include <stdlib.h>
+#include <cmath>
 #include <queue>
+#include <thread>
+#include <unordered_set>
 
 #include "global/SignalObj.h"
 #include "router/Router.h"
+#include "router/RouteSearch.h"
+#include "router/Landmarks.h"
+#include "global/ScenarioSnapshot.h"
+#include "global/SumoNet.h"
 
 namespace VENTOS {
 
@@ -52,11 +59,6 @@ std::set<std::string>* randomUniqueVehiclesInRange(int numInts, int rangeMin, in
     return randInts;
 }
 
-std::string key(Node* n1, Node* n2, int time)
-{
-    return n1->id + "#" + n2->id + "#" + std::to_string(time);
-}
-
 struct EdgeRemoval
 {
     std::string edge;
@@ -69,19 +71,14 @@ struct EdgeRemoval
 };
 
 
-class routerCompare // Comparator object for getRoute weighting
-{
-public:
-    bool operator()(const Edge* n1, const Edge* n2)
-    {
-        return n1->curCost > n2->curCost;
-    }
-};
-
-
 Router::~Router()
 {
     delete nonReroutingVehicles;
+
+    // joins the worker threads
+    delete hypertreePool;
+
+    delete landmarks;
 }
 
 
@@ -115,6 +112,12 @@ void Router::initialize(int stage)
         AccidentCheckInterval = par("AccidentCheckInterval").longValue();
         collectVehicleTimeData = par("collectVehicleTimeData").boolValue();
         dijkstraOutdateTime = par("dijkstraOutdateTime").longValue();
+        UseAStar = par("UseAStar").boolValue();
+        ALTLandmarks = par("ALTLandmarks").longValue();
+
+        hypertreeThreads = par("hypertreeThreads").longValue();
+        hypertreeDriftThreshold = par("hypertreeDriftThreshold").doubleValue();
+        hypertreeRefreshInterval = par("hypertreeRefreshInterval").doubleValue();
 
         // register and subscribe to signals
         Signal_system = registerSignal("system");
@@ -126,6 +129,11 @@ void Router::initialize(int stage)
         Signal_executeEachTS = registerSignal("executeEachTimeStepSignal");
         omnetpp::getSimulation()->getSystemModule()->subscribe("executeEachTimeStepSignal", this);
 
+        // edge transitions of vehicles come from the vehicle subscriptions in TraCI_Start
+        Signal_edge_changed = registerSignal("vehicleEdgeChangedSignal");
+        if(laneCostsMode == MODE_EWMA || laneCostsMode == MODE_RECORD || UseHysteresis)
+            omnetpp::getSimulation()->getSystemModule()->subscribe("vehicleEdgeChangedSignal", this);
+
         // get the location of SUMO config files
         SUMOConfigDirectory = TraCI->getFullPath_SUMOConfig().parent_path().string();
         if( !boost::filesystem::exists( SUMOConfigDirectory ) )
@@ -168,6 +176,16 @@ void Router::initialize(int stage)
         int stc = par("straightCost").doubleValue();
         int utc = par("uTurnCost").doubleValue();
         net = new Net(SUMOConfigDirectory.string(), this->getParentModule(), ltc, rtc, stc, utc);
+
+        int numThreads = hypertreeThreads;
+        if(numThreads == 0)
+            numThreads = std::max(1u, std::thread::hardware_concurrency());
+        else if(numThreads < 0)
+            numThreads = 0;
+        hypertreePool = new HypertreePool(net, numThreads);
+
+        if(ALTLandmarks > 0)
+            landmarks = new Landmarks(net, ALTLandmarks, SUMOConfigDirectory);
     }
     else if (stage == 1)
     {
@@ -239,8 +257,25 @@ void Router::finish()
     if(laneCostsMode == MODE_RECORD)
         LaneCostsToFile();
 
+    if(UseAccidents)
+    {
+        recordScalar("dijkstraRoutesKept", dijkstraRoutesKept);
+        recordScalar("dijkstraRoutesInvalidated", dijkstraRoutesInvalidated);
+        recordScalar("hypertreesKept", hypertreesKept);
+        recordScalar("hypertreesRebuilt", hypertreesRebuilt);
+
+        if(omnetpp::cSimulation::getActiveEnvir()->isGUI() && debugLevel > 0)
+        {
+            std::cout << "Edge removals: kept " << dijkstraRoutesKept << " of " << dijkstraRoutesKept + dijkstraRoutesInvalidated << " cached routes and "
+                    << hypertreesKept << " of " << hypertreesKept + hypertreesRebuilt << " hypertrees" << std::endl;
+            std::cout.flush();
+        }
+    }
+
     // unsubscribe
     omnetpp::getSimulation()->getSystemModule()->unsubscribe("executeEachTimeStepSignal", this);
+    if(omnetpp::getSimulation()->getSystemModule()->isSubscribed("vehicleEdgeChangedSignal", this))
+        omnetpp::getSimulation()->getSystemModule()->unsubscribe("vehicleEdgeChangedSignal", this);
 }
 
 
@@ -261,17 +296,45 @@ void Router::receiveSignal(omnetpp::cComponent *source, omnetpp::simsignal_t sig
     if(signalID == Signal_executeEachTS)
     {
         if(laneCostsMode == MODE_EWMA || laneCostsMode == MODE_RECORD || UseHysteresis)
+        {
             laneCostsData();
+            heuristicScaleTime = -1;    // edge costs have changed
+        }
+
+        checkHypertreeDrift();
     }
     else if(signalID == Signal_initialize_withTraCI)
     {
         addVehs();
+
+        // start building the hypertrees of all known destinations in the background
+        if(hypertreeThreads >= 0)
+        {
+            for(auto &item : net->vehicles)
+            {
+                auto it = net->nodes.find(item.second->destination);
+                if(it != net->nodes.end())
+                    hypertreeDestinations.insert(it->second);
+            }
+
+            submitHypertrees();
+        }
     }
 }
 
 
 void Router::receiveSignal(cComponent *source, omnetpp::simsignal_t signalID, cObject *obj, cObject* details)
 {
+    // edge transitions are collected here and processed by laneCostsData once all
+    // subscription results of this time step are in.
+    // The signal object belongs to the emitter
+    if(signalID == Signal_edge_changed)
+    {
+        vehicleEdgeData *data = static_cast<vehicleEdgeData*>(obj);
+        edgeTransitions.push_back({data->vehicle, data->fromEdge, data->toEdge});
+        return;
+    }
+
     if(signalID != Signal_system)
     {
         delete obj;
@@ -312,24 +375,20 @@ void Router::receiveSignal(cComponent *source, omnetpp::simsignal_t signalID, cO
 std::vector<std::string> getEdgeNames(std::string netName) {
     std::vector<std::string> edgeNames;
 
-    rapidxml::file <> xmlFile(netName.c_str());
-    rapidxml::xml_document<> doc;
-    rapidxml::xml_node<> *node;
-    doc.parse<0>(xmlFile.data());
-    for(node = doc.first_node()->first_node("edge"); node; node = node->next_sibling("edge"))
-        edgeNames.push_back(node->first_attribute()->value());
+    std::shared_ptr<const SumoNet> model = SumoNet::load(netName);
+    for(auto &edge : model->edges)
+        if(!edge.internal)
+            edgeNames.push_back(edge.id);
 
     return edgeNames;
 }
 
 std::vector<std::string> getNodeNames(std::string netName) {
     std::vector<std::string> nodeNames;
-    rapidxml::file <> xmlFile(netName.c_str());
-    rapidxml::xml_document<> doc;
-    rapidxml::xml_node<> *node;
-    doc.parse<0>(xmlFile.data());
-    for(node = doc.first_node()->first_node("junction"); node; node = node->next_sibling("junction"))
-        nodeNames.push_back(node->first_attribute()->value());
+
+    std::shared_ptr<const SumoNet> model = SumoNet::load(netName);
+    for(auto &junction : model->junctions)
+        nodeNames.push_back(junction.id);
 
     return nodeNames;
 }
@@ -376,6 +435,13 @@ void Router::addVehs()
     doc.parse<0>(xmlFile.data());                             // Fill it with data from our file
     rapidxml::xml_node<> *node = doc.first_node("vehicles");  // Parse up to the "nodes" declaration
 
+    // routes that already exist in SUMO. Fetched once, and kept up to date locally
+    auto routeList = TraCI->routeGetIDList();
+    std::unordered_set<std::string> knownRoutes(routeList.begin(), routeList.end());
+
+    // routeAdd, vehicleAdd and vehicleSetColor are sent in bulk
+    TraCIBatch batch(TraCI);
+
     std::string id, type, origin, destination;
     double depart;
     for(node = node->first_node("vehicle"); node; node = node->next_sibling()) // For each vehicle
@@ -409,8 +475,7 @@ void Router::addVehs()
 
         net->vehicles[id] = new Vehicle(id, type, origin, destination, depart);
 
-        auto routeList = TraCI->routeGetIDList();   //Get all the routes so far
-        if(std::find(routeList.begin(), routeList.end(), origin) == routeList.end())
+        if(knownRoutes.insert(origin).second)
         {
             std::vector<std::string> startRoute = {origin}; //With just the starting edge
             TraCI->routeAdd(origin /*route ID*/, startRoute);   //And add it to the simulation
@@ -421,7 +486,7 @@ void Router::addVehs()
 
         //Change color of non-rerouting vehicle to green.
         std::string veh = id.substr(1,-1);
-        if(find(nonReroutingVehicles->begin(), nonReroutingVehicles->end(), veh) != nonReroutingVehicles->end())
+        if(nonReroutingVehicles->find(veh) != nonReroutingVehicles->end())
         {
             RGB newColor = Color::colorNameToRGB("green");
             TraCI->vehicleSetColor(id, newColor);
@@ -437,7 +502,7 @@ void Router::receiveDijkstraRequest(Edge* origin, Node* destination, std::string
     if(dijkstraTimes.find(key) == dijkstraTimes.end() || (omnetpp::simTime().dbl() - dijkstraTimes[key]) > dijkstraOutdateTime)
     {
         dijkstraTimes[key] = omnetpp::simTime().dbl();
-        dijkstraRoutes[key] = getRoute(origin, destination, sender);
+        dijkstraRoutes[key] = getRoute(origin, destination, sender, &dijkstraInfo[key]);
 
         if(omnetpp::cSimulation::getActiveEnvir()->isGUI() && debugLevel > 2)
         {
@@ -465,10 +530,23 @@ void Router::receiveHypertreeRequest(Edge* origin, Node* destination, std::strin
     info.push_back(origin->id);
 
     // Return memoization only if the vehicle has traveled less than X intersections, otherwise recalculate a new one
-    if(hypertreeMemo.find(destination->id) == hypertreeMemo.end() /*&&  if old hyperpath is less than 60 second old*/)
-        hypertreeMemo[destination->id] = buildHypertree(omnetpp::simTime().dbl(), destination);
+    if(hypertreeDestinations.find(destination) == hypertreeDestinations.end() /*&&  if old hyperpath is less than 60 second old*/)
+    {
+        if(omnetpp::cSimulation::getActiveEnvir()->isGUI() && debugLevel > 2)
+        {
+            std::cout << "Generating a hypertree for " << destination->id << std::endl;
+            std::cout.flush();
+        }
+
+        hypertreeDestinations.insert(destination);
+        hypertreePool->submit(destination, HypertreePool::snapshot(net, hypertreeInput ? hypertreeInput->generation : 0, omnetpp::simTime().dbl(), timePeriodMax));
+    }
 
-    std::string nextEdge = hypertreeMemo[destination->id]->transition[key(origin->from, origin->to, omnetpp::simTime().dbl())];
+    // always the tree of the newest submitted input (waits if it is still being built),
+    // so the route does not depend on how fast the worker threads are
+    std::shared_ptr<Hypertree> ht = hypertreePool->wait(destination);
+
+    std::string nextEdge = ht->getTransition(origin, omnetpp::simTime().dbl());
     if(nextEdge != "end")
         info.push_back(nextEdge);
 
@@ -550,16 +628,29 @@ void Router::checkEdgeRemovals()
 {
     int curTime = omnetpp::simTime().dbl();
 
+    // an edge is disabled while any of its removals is active
+    std::set<Edge*> removed;
+    for(EdgeRemoval& er : EdgeRemovals)
+        if(er.start <= curTime && er.end > curTime)
+            removed.insert(net->edges.at(er.edge));
+
+    for(EdgeRemoval& er : EdgeRemovals)
+    {
+        Edge* edge = net->edges.at(er.edge);
+        bool disabled = (removed.find(edge) != removed.end());
+        if(edge->disabled != disabled)
+        {
+            edge->disabled = disabled;
+            edgeAvailabilityChanged(edge);
+        }
+    }
+
     for(EdgeRemoval& er : EdgeRemovals)
     {
         if(er.start <= curTime && er.end > curTime) //If edge is currently removed
         {
             if(!er.blocked)  //if the lane is not blocked
             {
-                // New implementation
-                Edge& edge = *net->edges[er.edge];
-                edge.disabled = true;   //mark it as disabled
-
                 // Find the closest vehicle behind the accident location
                 std::string laneID = er.edge + "_" + std::to_string(er.laneIndex); // Construct the accident lane ID
                 auto vehicleIDs = TraCI->laneGetLastStepVehicleIDs(laneID); // Get the vehicles on that lane
@@ -610,6 +701,46 @@ void Router::checkEdgeRemovals()
 
 
 void Router::parseLaneCostsFile()
+{
+    ScenarioSnapshot snapshot(SUMOConfigDirectory, "edgeWeights");
+    if(!snapshot.open(laneCostsKey()))
+    {
+        parseLaneCostsTextFile();
+        return;
+    }
+
+    snapshotReader reader = snapshot.getReader();
+
+    uint32_t numEdges = reader.get<uint32_t>();
+    for(uint32_t i = 0; i < numEdges; i++)
+    {
+        std::string edgeName = reader.getString();
+
+        auto it = net->edges.find(edgeName);
+        if(it == net->edges.end())
+            throw omnetpp::cRuntimeError("Edge '%s' in edgeWeights.bin is not in the network", edgeName.c_str());
+
+        EdgeCosts& ec = it->second->travelTimes;
+
+        uint32_t numBuckets = reader.get<uint32_t>();
+        for(uint32_t j = 0; j < numBuckets; j++)
+        {
+            uint32_t bucket = reader.get<uint32_t>();
+            uint32_t count = reader.get<uint32_t>();
+            uint64_t sum = reader.get<uint64_t>();
+            ec.addBucket(bucket, count, sum);
+        }
+
+        if(omnetpp::cSimulation::getActiveEnvir()->isGUI() && debugLevel > 1)
+        {
+            std::cout << "Loaded costs for " << edgeName << ": " << ec.average << " (median " << ec.quantile(0.5) << ")" << std::endl;
+            std::cout.flush();
+        }
+    }
+}
+
+// edgeWeights.txt of older versions: edge id, number of readings and then (travel time, number of occurrences) pairs
+void Router::parseLaneCostsTextFile()
 {
     std::ifstream inFile;
     std::string fileName = SUMOConfigDirectory.string() + "/edgeWeights.txt";
@@ -623,19 +754,18 @@ void Router::parseLaneCostsFile()
         int max;
         inFile >> max;
         int readCount = 0;
-        std::map<int, int> m;
         int value, valueCount;
+        EdgeCosts& ec = net->edges.at(edgeName)->travelTimes;
         while(readCount < max)
         {
             inFile >> value >> valueCount;
-            m[value] = valueCount;
+            ec.addSamples(value, valueCount);
             readCount += valueCount;
         }
 
-        net->edges.at(edgeName)->travelTimes = EdgeCosts(m);
         if(omnetpp::cSimulation::getActiveEnvir()->isGUI() && debugLevel > 1)
         {
-            std::cout << "Loaded costs for " << edgeName << ": " << net->edges.at(edgeName)->travelTimes.average << std::endl;
+            std::cout << "Loaded costs for " << edgeName << ": " << ec.average << std::endl;
             std::cout.flush();
         }
     }
@@ -646,74 +776,88 @@ void Router::parseLaneCostsFile()
 // is called at the end of simulation
 void Router::LaneCostsToFile()
 {
-    std::ofstream outFile;
-    std::string fileName = SUMOConfigDirectory.string() + "/edgeWeights.txt";
-    outFile.open(fileName.c_str()); //Open the edgeWeights file
+    snapshotWriter writer;
+
+    std::vector<Edge*> recorded;
+    for(Edge* edge : net->edgeList)
+        if(edge->travelTimes.count > 0)
+            recorded.push_back(edge);
 
-    for(auto& pair : net->edges)
+    writer.put<uint32_t>(recorded.size());
+    for(Edge* edge : recorded)
     {
-        std::string name = pair.first;
-        if(name != "") //If it has a name (empty-ID histograms occur when vehicles update in an intersection)
+        EdgeCosts& ec = edge->travelTimes;
+        writer.putString(edge->id);
+
+        uint32_t numBuckets = 0;
+        for(uint32_t count : ec.counts)
+            if(count > 0)
+                numBuckets++;
+
+        // only the non-empty buckets are written
+        writer.put<uint32_t>(numBuckets);
+        for(unsigned int b = 0; b < ec.counts.size(); b++)
         {
-            EdgeCosts& ec = pair.second->travelTimes;
-            outFile << name << " " << ec.count << std::endl; //Write the edge ID and its number of data points
-            for(auto& pair2 : ec.data)
-                //for(map<int, int>::iterator it2 = hist->data.begin(); it2 != hist->data.end(); it2++)
-            {
-                int time = pair2.first;
-                int count = pair2.second;
-                outFile << time << " " << count << "  ";    //And then write each data point followed by the number of occurrences
-            }
-            outFile << std::endl;
+            if(ec.counts[b] == 0)
+                continue;
+
+            writer.put<uint32_t>(b);
+            writer.put<uint32_t>(ec.counts[b]);
+            writer.put<uint64_t>(ec.sums[b]);
         }
     }
+
+    ScenarioSnapshot snapshot(SUMOConfigDirectory, "edgeWeights");
+    snapshot.store(laneCostsKey(), writer.getBuffer());
+}
+
+// the file is only valid for the bucket layout it was written with
+std::string Router::laneCostsKey()
+{
+    std::ostringstream key;
+    key << "edgeWeights:" << EdgeCosts::LINEAR_BUCKETS << ":" << EdgeCosts::BUCKETS_PER_OCTAVE << ":" << EdgeCosts::NUM_BUCKETS;
+    return key.str();
 }
 
 void Router::laneCostsData()
 {
-    auto vList = TraCI->vehicleGetIDList();
+    double now = omnetpp::simTime().dbl();
 
-    for(auto &vehicle : vList)
+    for(auto &transition : edgeTransitions)
     {
-        std::string curEdge = TraCI->vehicleGetEdgeID(vehicle);
-        if(curEdge != "")
+        const std::string &vehicle = transition.vehicle;
+
+        if(transition.fromEdge == "")
         {
-            if(vehicleEdges.find(vehicle) != vehicleEdges.end())
-            {
-                if(vehicleEdges[vehicle] != curEdge)
-                {
-                    if(omnetpp::cSimulation::getActiveEnvir()->isGUI() && debugLevel > 2)
-                    {
-                        std::cout << vehicle << " changes lanes to " << curEdge << " at t=" << omnetpp::simTime().dbl() << "(" << vehicleLaneChangeCount[vehicle] << ")" << std::endl;
-                        std::cout.flush();
-                    }
+            vehicleTimes[vehicle] = now;
+            vehicleLaneChangeCount[vehicle] = 0;
+            continue;
+        }
 
-                    double time = omnetpp::simTime().dbl() - vehicleTimes[vehicle];
-                    net->edges.at(vehicleEdges[vehicle])->travelTimes.insert(time);
-                    vehicleEdges[vehicle] = curEdge;
-                    vehicleTimes[vehicle] = omnetpp::simTime().dbl();
-                    ++vehicleLaneChangeCount[vehicle];
-                    if(UseHysteresis && vehicleLaneChangeCount[vehicle] == HysteresisCount)
-                    {
-                        vehicleLaneChangeCount[vehicle] = 0;
-
-                        sendRerouteSignal(vehicle);
-                        if(omnetpp::cSimulation::getActiveEnvir()->isGUI() && debugLevel > 1)
-                        {
-                            std::cout << "Hystereis rerouting " << vehicle << " at t=" << omnetpp::simTime().dbl() << std::endl;
-                            std::cout.flush();
-                        }
-                    }
-                }
-            }
-            else
+        if(omnetpp::cSimulation::getActiveEnvir()->isGUI() && debugLevel > 2)
+        {
+            std::cout << vehicle << " changes lanes to " << transition.toEdge << " at t=" << now << "(" << vehicleLaneChangeCount[vehicle] << ")" << std::endl;
+            std::cout.flush();
+        }
+
+        double time = now - vehicleTimes[vehicle];
+        net->edges.at(transition.fromEdge)->travelTimes.insert(time);
+        vehicleTimes[vehicle] = now;
+        ++vehicleLaneChangeCount[vehicle];
+        if(UseHysteresis && vehicleLaneChangeCount[vehicle] == HysteresisCount)
+        {
+            vehicleLaneChangeCount[vehicle] = 0;
+
+            sendRerouteSignal(vehicle);
+            if(omnetpp::cSimulation::getActiveEnvir()->isGUI() && debugLevel > 1)
             {
-                vehicleEdges[vehicle] = curEdge;
-                vehicleTimes[vehicle] = omnetpp::simTime().dbl();
-                vehicleLaneChangeCount[vehicle] = 0;
+                std::cout << "Hystereis rerouting " << vehicle << " at t=" << now << std::endl;
+                std::cout.flush();
             }
         }
     }
+
+    edgeTransitions.clear();
 }
 
 void Router::sendRerouteSignal(std::string vehID)
@@ -724,159 +868,236 @@ void Router::sendRerouteSignal(std::string vehID)
 }
 
 
-Hypertree* Router::buildHypertree(int startTime, Node* destination)
+void Router::submitHypertrees()
+{
+    int generation = hypertreeInput ? hypertreeInput->generation + 1 : 0;
+
+    // the simulation keeps changing edge costs and TL state, so the
+    // workers build from a copy taken here in the simulation thread
+    hypertreeInput = HypertreePool::snapshot(net, generation, omnetpp::simTime().dbl(), timePeriodMax);
+    lastHypertreeRefresh = omnetpp::simTime().dbl();
+
+    for(Node* destination : hypertreeDestinations)
+        hypertreePool->submit(destination, hypertreeInput);
+}
+
+
+void Router::checkHypertreeDrift()
 {
-    Hypertree* ht = new Hypertree();
-    std::map<std::string, bool> visited;
-    std::list<Node*> SE;
+    if(hypertreeThreads < 0 || !hypertreeInput || hypertreeDestinations.empty())
+        return;
 
-    for(std::map<std::string, Node*>::iterator node = net->nodes.begin(); node != net->nodes.end(); node++)    // Reset the temporary pathing data
+    double now = omnetpp::simTime().dbl();
+    if(now - lastHypertreeRefresh < hypertreeRefreshInterval || now > timePeriodMax)
+        return;
+
+    // rebuild if the average travel time of any edge has drifted too far from the snapshot
+    for(Edge* edge : net->edgeList)
     {
-        Node* i = (*node).second;                            // i is the destination node
-        visited[i->id] = 0;                   // Set each node as not visited
-        for(int t = startTime; t <= timePeriodMax; t++)   // For every second in the time interval
+        double oldAverage = hypertreeInput->edges[edge->index].average;
+        double newAverage = edge->travelTimes.average;
+
+        if(fabs(newAverage - oldAverage) > hypertreeDriftThreshold * std::max(oldAverage, 1.0))
         {
-            for(std::vector<Edge*>::iterator inEdge = i->inEdges.begin(); inEdge != i->inEdges.end(); inEdge++)  // For every predecessor to i
+            if(omnetpp::cSimulation::getActiveEnvir()->isGUI() && debugLevel > 2)
             {
-                Node* h = (*inEdge)->from;              // Call each predecessor h
-                ht->label[key(h, i, t)] = 1000000;      // Set the cost from h to i at time t to infinity
-                ht->transition[key(h, i, t)] = "none";  // And the transition target to none
+                std::cout << "Travel time of edge " << edge->id << " has changed from " << oldAverage << " to " << newAverage << ". Rebuilding " << hypertreeDestinations.size() << " hypertrees at t=" << now << std::endl;
+                std::cout.flush();
             }
+
+            submitHypertrees();
+            return;
         }
     }
 
-    if(omnetpp::cSimulation::getActiveEnvir()->isGUI() && debugLevel > 2)
+    // rebuild the trees that depend on a traffic light whose timeline has changed
+    std::vector<Node*> stale;
+    for(Node* destination : hypertreeDestinations)
     {
-        std::cout << "Generating a hypertree for " << destination->id << std::endl;
-        std::cout.flush();
-    }
+        std::shared_ptr<Hypertree> ht = hypertreePool->wait(destination);
+        if(!ht)
+            continue;
 
-    Node* D = destination;    // Find the destination, call it D
-    for(int t = startTime; t <= timePeriodMax; t++)           // For every second in the time interval
-    {
-        for(std::vector<Edge*>::iterator inEdge = D->inEdges.begin(); inEdge != D->inEdges.end(); inEdge++)  // For every predecessor to D
+        const std::vector<int>& versions = ht->getTLVersions();
+        for(unsigned int tl = 0; tl < versions.size(); tl++)
         {
-            Node* h = (*inEdge)->from;  // Call each predecessor h
-            ht->label[key(h, D, t)] = 0;    // Set the cost from h to D to 0
-            ht->transition[key(h, D, t)] = "end";  // And the transition to none
+            if(versions[tl] >= 0 && versions[tl] != net->TLList[tl]->getTiming().version)
+            {
+                stale.push_back(destination);
+                break;
+            }
         }
     }
 
-    SE.push_back(D);    // Add the destination node to the scan-eligible list
-    while(!SE.empty())  // While the list is not empty
-    {
-        Node* j = SE.front();   // Set j to the first node
-        SE.pop_front();         // And remove the first node from the list
-        for(std::vector<Edge*>::iterator ijEdge = j->inEdges.begin(); ijEdge != j->inEdges.end(); ijEdge++)  // For each predecessor to j, ijEdge
-        {
-            Node* i = (*ijEdge)->from;                                  // Set i to be the predecessor node
-            for(std::vector<Edge*>::iterator hiEdge = i->inEdges.begin(); hiEdge != i->inEdges.end(); hiEdge++)  // For each predecessor to i, hiEdge
-            {
-                EdgeCosts& travelTimes = (*ijEdge)->travelTimes;
-                Node* h = (*hiEdge)->from;  // Set h to be the predecessor node
-                for(int t = startTime; t <= timePeriodMax; t++)   // For every time step of interest
-                {
-                    double TLDelay = net->junctionCost(t, *hiEdge, *ijEdge);// The tldelay is the time to the next accepting phase between (h, i) and (i, j)
-                    double n = 0;
-                    if(travelTimes.count > 0) // If we have histogram data
-                    {
-                        for(std::map<int, int>::iterator val = travelTimes.data.begin(); val != travelTimes.data.end(); val++)   // For each unique entry in the history of edge travel times
-                        {
-                            int travelTime = val->first;                // Set travel time
-                            double prob = travelTimes.percentAt(travelTime);  // And calculate its probability
-                            double endLabel = ht->label[key(i, j, t + TLDelay + travelTime)];   // The endlabel is the label after (i, j) after we've gone through the TL and traveled (i,j)
-                            n += (TLDelay + travelTime + endLabel) * prob;  // Add this weight multiplied by its probability
-                        }
-                    }
-                    else    // Otherwise, use the default getCost() function
-                    {
-                        n = TLDelay + (*ijEdge)->getCost() + ht->label[key(i, j, t + TLDelay + (*ijEdge)->getCost())];
-                    }
+    if(stale.empty())
+        return;
 
-                    if (n < ht->label[key(h, i, t)])            // If the newly calculated label is better
-                    {
-                        ht->label[key(h, i, t)] = n;            // Record the cost for making this transition at this time
-                        ht->transition[key(h, i, t)] = (*ijEdge)->id;
-                    }
+    if(omnetpp::cSimulation::getActiveEnvir()->isGUI() && debugLevel > 2)
+    {
+        std::cout << "Traffic light timelines have changed. Rebuilding " << stale.size() << " of " << hypertreeDestinations.size() << " hypertrees at t=" << now << std::endl;
+        std::cout.flush();
+    }
 
-                    if(visited[i->id] == 0) // If i is not in the SE-set
-                    {
-                        SE.push_back(i);    // Add it
-                        visited[i->id] = 1; // And mark it as in the set
-                    }
-                }   // For each time in the interval
-            }   // For each predecessor to i, h
-        }   // For each predecessor to j, i
-    }   // While SE list has elements
+    hypertreeInput = HypertreePool::snapshot(net, hypertreeInput->generation + 1, now, timePeriodMax);
+    lastHypertreeRefresh = now;
 
-    return ht;
+    for(Node* destination : stale)
+        hypertreePool->submit(destination, hypertreeInput);
 }
 
 
-std::list<std::string> Router::getRoute(Edge* origin, Node* destination, std::string vName)
+void Router::edgeAvailabilityChanged(Edge* edge)
 {
-    for(auto& pair : net->edges)
+    if(omnetpp::cSimulation::getActiveEnvir()->isGUI() && debugLevel > 1)
     {
-        Edge* e = pair.second;
-        e->curCost = 1000000;
-        e->best = NULL;
-        e->visited = 0;
+        std::cout << "Edge " << edge->id << (edge->disabled ? " is disabled" : " is available again") << " at t=" << omnetpp::simTime().dbl() << std::endl;
+        std::cout.flush();
     }
 
-    // Build a priority queue of edge pointers, based on a vector of edge pointers, sorted via routerCompare funciton
-    std::priority_queue<Edge*, std::vector<Edge*>, routerCompare> heap;
+    repairDijkstraRoutes(edge);
+    repairHypertrees(edge);
+}
+
+
+static inline double distance(Node* a, Node* b)
+{
+    return std::hypot(a->x - b->x, a->y - b->y);
+}
 
-    origin->curCost = 0;    // Set the origin's start cost to 0
-    heap.push(origin);      // Add the origin to the heap
 
-    std::vector<std::string> destinationEdges;
-    for(std::vector<Edge*>::iterator it = destination->inEdges.begin(); it != destination->inEdges.end(); it++)
-        destinationEdges.push_back((*it)->id);
+// Drops the cached routes that may no longer be the best. The next request for
+// such a route runs a new search, all other routes are kept.
+void Router::repairDijkstraRoutes(Edge* edge)
+{
+    // straight-line lower bound of the cost between two nodes (see RouteSearch::heuristicScale)
+    double scale = RouteSearch::heuristicScale(net);
 
-    while(!heap.empty())    // While there are unexplored edges (always, if graph is fully connected)
+    for(auto it = dijkstraInfo.begin(); it != dijkstraInfo.end();)
     {
-        Edge* parent = heap.top();          // Set parent to the closest unexplored edge
-        heap.pop();                         // Remove parent from the heap
-        if(parent->visited || parent->disabled)                 // If it was visited already, ignore it
-            continue;
-        parent->visited = 1;                // If not, we're about to
+        const std::string& key = it->first;
+        const dijkstraRouteInfo_t& info = it->second;
 
-        double distanceAlongLane = 1;
-        if(parent->id == origin->id)    // Vehicles may not necessarily start at the beginning of a lane. Check for that
+        bool stale = false;
+        if(edge->disabled)
         {
-            double lanePos = TraCI->vehicleGetLanePosition(vName);
-            std::string lane = TraCI->vehicleGetLaneID(vName);
-            double laneLength = TraCI->laneGetLength(lane);
-            distanceAlongLane = 1 - (lanePos / laneLength); //And modify distanceAlongLane
+            // removing an edge only changes the routes that use it
+            const std::list<std::string>& route = dijkstraRoutes[key];
+            stale = std::find(route.begin(), route.end(), edge->id) != route.end();
         }
-        double curLaneCost = distanceAlongLane * parent->getCost();
-        if(find(destinationEdges.begin(), destinationEdges.end(), parent->id) == destinationEdges.end())   // If we're not at a destination edge
+        else if(info.cost < 0)
         {
-            for(std::vector<Edge*>::iterator child = parent->to->outEdges.begin(); child != parent->to->outEdges.end(); child++)   // Go through every edge was can get to from the parent
-            {
-                double newCost = parent->curCost + curLaneCost;                     // Time to get to the junction is the time we get to the edge plus the edge cost
-                if(newCost < TLLookahead)
-                    newCost += net->junctionCost(newCost + omnetpp::simTime().dbl(), parent, *child); // The cost at the junction is calculated from when we'd arrive there
-                if(!(*child)->visited && newCost < (*child)->curCost)               // If we haven't finished the edge and out new cost is lower
-                {
-                    (*child)->curCost = newCost;    // Cost to the child is newCost
-                    (*child)->best = parent;        // Best path to the child is through the parent
-                    heap.push(*child);              // Add the child to the heap
-                }
-            }
+            // the destination might be reachable again
+            stale = true;
+        }
+        else
+        {
+            // a route through the edge costs at least this much. Its own cost only
+            // counts if it is not the last edge, as the cost is measured to the start of the last edge
+            Node* D = info.destination;
+            double radius = 0;
+            for(Edge* e : D->inEdges)
+                radius = std::max(radius, distance(e->from, D));
+
+            double bound = scale * distance(info.origin->to, edge->from);
+            if(edge->to != D)
+                bound += edge->getCost() + scale * std::max(0.0, distance(edge->to, D) - radius);
+
+            stale = (edge == info.origin) || (bound < info.cost);
         }
-        else // If we found the destination!
+
+        if(stale)
         {
-            std::list<std::string> routeIDs;          // Start backtracking to generate the route
-            routeIDs.push_back(parent->id); // Add the end edge
-            while(parent->best != NULL)     // While there are more edges
-            {
-                routeIDs.insert(routeIDs.begin(),parent->best->id); // Add the edge
-                parent = parent->best;                              // And go to its parent
-            }
-            return routeIDs;    // Return the final list
+            dijkstraTimes.erase(key);
+            dijkstraRoutes.erase(key);
+            it = dijkstraInfo.erase(it);
+            dijkstraRoutesInvalidated++;
+        }
+        else
+        {
+            ++it;
+            dijkstraRoutesKept++;
+        }
+    }
+}
+
+
+// Rebuilds only the hypertrees whose labels depend on the edge
+void Router::repairHypertrees(Edge* edge)
+{
+    if(hypertreeThreads < 0 || !hypertreeInput || hypertreeDestinations.empty())
+        return;
+
+    int now = omnetpp::simTime().dbl();
+
+    // the kept trees are as good as if they were built from this input. The
+    // drift of the edge costs is measured against it from now on
+    hypertreeInput = HypertreePool::snapshot(net, hypertreeInput->generation + 1, now, timePeriodMax);
+
+    for(Node* destination : hypertreeDestinations)
+    {
+        // a build that is queued or running uses the old state of the edge. We wait for
+        // it and check its tree like any other. If it has to be rebuilt, the pool drops
+        // a stale result that arrives after the new submission (see HypertreePool::store)
+        std::shared_ptr<Hypertree> ht = hypertreePool->wait(destination);
+
+        if(!ht || HypertreePool::affectedBy(net, *ht, edge, *hypertreeInput, now))
+        {
+            hypertreePool->submit(destination, hypertreeInput);
+            hypertreesRebuilt++;
         }
-    }// While heap isn't empty
+        else
+            hypertreesKept++;
+    }
+}
+
+
+std::list<std::string> Router::getRoute(Edge* origin, Node* destination, std::string vName, dijkstraRouteInfo_t* info)
+{
+    // Vehicles may not necessarily start at the beginning of a lane. Check for that
+    double lanePos = TraCI->vehicleGetLanePosition(vName);
+    std::string lane = TraCI->vehicleGetLaneID(vName);
+    double laneLength = TraCI->laneGetLength(lane);
+
+    // the lower bounds of the A* heuristics only change with the edge costs
+    if((UseAStar || landmarks) && heuristicScaleTime != omnetpp::simTime())
+    {
+        heuristicScale = UseAStar ? RouteSearch::heuristicScale(net) : 0;
+        landmarkScale = landmarks ? Landmarks::getScale(net) : 0;
+        heuristicScaleTime = omnetpp::simTime();
+    }
+
+    std::vector<TLTiming_t> TLTimings;
+    if(TLLookahead > 0)
+        TLTimings = net->getTLTimings();   // TL state does not change while we search
+
+    routeQuery_t query;
+    query.origin = origin;
+    query.destination = destination;
+    query.originFraction = 1 - (lanePos / laneLength);
+    query.startTime = omnetpp::simTime().dbl();
+    query.TLLookahead = TLLookahead;
+    query.TLTimings = &TLTimings;
+    query.heuristicScale = UseAStar ? heuristicScale : 0;
+    query.landmarks = landmarks;
+    query.landmarkScale = landmarkScale;
+
+    double cost = -1;
+    std::vector<Edge*> route = RouteSearch::search(net, query, &cost);
+
+    if(info)
+    {
+        info->origin = origin;
+        info->destination = destination;
+        info->cost = route.empty() ? -1 : cost;
+    }
+
+    if(!route.empty())
+    {
+        std::list<std::string> routeIDs;
+        for(Edge* e : route)
+            routeIDs.push_back(e->id);
+        return routeIDs;
+    }
 
     if(omnetpp::cSimulation::getActiveEnvir()->isGUI() && debugLevel > 0)
     {
@@ -41,6 +41,7 @@
 #include "router/Edge.h"
 #include "router/Net.h"
 #include "router/Hypertree.h"
+#include "router/HypertreePool.h"
 #include "trafficLight/TSC/09_Router.h"
 
 namespace VENTOS {
@@ -50,9 +51,23 @@ class Edge;
 class TrafficLightRouter;
 class Net;
 class Hypertree;
+class Landmarks;
 struct EdgeRemoval;
 
-std::string key(Node* n1, Node* n2, int time);
+typedef struct edgeTransition
+{
+    std::string vehicle;
+    std::string fromEdge;
+    std::string toEdge;
+} edgeTransition_t;
+
+// what a cached Dijkstra route was computed for
+typedef struct dijkstraRouteInfo
+{
+    Edge* origin;
+    Node* destination;
+    double cost;    // cost to the start of the last edge, -1 if there was no route
+} dijkstraRouteInfo_t;
 
 class Router : public BaseApplLayer    //Responsible for routing cars in our system.  Should only be one of these.
 {
@@ -90,7 +105,15 @@ protected:
     int AccidentCheckInterval; //Time between running checkEdgeRemovals()
     bool UseAccidents; //If true, uses the above variables to simulate an accident
 
-    std::map<std::string, Hypertree*> hypertreeMemo; //Map from a destination to its respective hypertree
+    HypertreePool* hypertreePool = NULL; //Builds the hypertrees, possibly in background threads
+    std::shared_ptr<hypertreeInput_t> hypertreeInput; //Edge costs and TL timings the current hypertrees are built from
+    std::set<Node*> hypertreeDestinations; //Destinations that have a hypertree (or one is being built)
+    int hypertreeThreads; //-1: build on demand in the simulation thread, 0: one thread per core
+    double hypertreeDriftThreshold; //Relative change of an edge's average travel time that triggers a rebuild
+    double hypertreeRefreshInterval; //Minimum time between two rebuilds
+    double lastHypertreeRefresh = 0;
+    void submitHypertrees(); //Snapshots the current costs and rebuilds the hypertrees of all destinations
+    void checkHypertreeDrift();
 
     //Vehicle stuff
     bool collectVehicleTimeData; //If true, records travel time data to a file
@@ -102,8 +125,7 @@ protected:
     int TLLookahead;
 
     int timePeriodMax;     //Max time for hypertrees
-    Hypertree* buildHypertree(int startTime, Node* destination);    //Builds a hypertree to the destination, bounded between the start time and timePeriodMax;
-    std::list<std::string> getRoute(Edge* origin, Node* destination, std::string vName);       //Returns a list of edges between origin and destination, using dijskstra's
+    std::list<std::string> getRoute(Edge* origin, Node* destination, std::string vName, dijkstraRouteInfo_t* info = NULL);       //Returns a list of edges between origin and destination, using dijskstra's
     //or an empty list if they're not connected
     void receiveDijkstraRequest(Edge* origin, Node* destination, std::string sender);
     void receiveHypertreeRequest(Edge* origin, Node* destination, std::string sender);
@@ -111,8 +133,24 @@ protected:
     void receiveStartedRequest(std::string sender);
 
     int dijkstraOutdateTime;
+    bool UseAStar; //If true, getRoute uses a straight-line lower bound to direct the search
+    double heuristicScale = 0;
+    int ALTLandmarks; //Number of ALT landmarks, 0 = no ALT
+    Landmarks* landmarks = NULL;
+    double landmarkScale = 0;
+    omnetpp::simtime_t heuristicScaleTime = -1;
     std::map<std::string, std::list<std::string> > dijkstraRoutes;
     std::map<std::string, int> dijkstraTimes;
+    std::map<std::string, dijkstraRouteInfo_t> dijkstraInfo;
+
+    //Repair of the cached routes and hypertrees when an edge is disabled or enabled
+    void edgeAvailabilityChanged(Edge* edge);
+    void repairDijkstraRoutes(Edge* edge);
+    void repairHypertrees(Edge* edge);
+    long dijkstraRoutesKept = 0;
+    long dijkstraRoutesInvalidated = 0;
+    long hypertreesKept = 0;
+    long hypertreesRebuilt = 0;
 
     // Message passing
     TraCI_Commands* TraCI = NULL;
@@ -123,8 +161,9 @@ protected:
     int debugLevel;
 
     // Edge weight-gathering
-    std::map<std::string, std::string> vehicleEdges;
-    std::map<std::string, double> vehicleTimes;
+    omnetpp::simsignal_t Signal_edge_changed;
+    std::vector<edgeTransition_t> edgeTransitions;  // edge changes reported by TraCI_Start in this time step
+    std::map<std::string, double> vehicleTimes;     // time each vehicle entered its current edge
 
     //Hysteresis implementation
     std::map<std::string, int> vehicleLaneChangeCount; //Map from vehicle ID to how many times it's changed lanes
@@ -135,6 +174,8 @@ protected:
 
     void LaneCostsToFile();
     void parseLaneCostsFile();
+    void parseLaneCostsTextFile();
+    std::string laneCostsKey();
     void laneCostsData();
 };
 
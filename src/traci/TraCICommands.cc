@@ -102,6 +102,27 @@ TraCI_Commands * TraCI_Commands::getTraCI()
 }
 
 
+// set commands issued between beginBatch() and endBatch() are sent to SUMO
+// in one TraCI message (see TraCIConnection::set)
+void TraCI_Commands::beginBatch()
+{
+    connection->beginBatch();
+}
+
+
+void TraCI_Commands::endBatch()
+{
+    connection->endBatch();
+}
+
+
+void TraCI_Commands::abortBatch()
+{
+    connection->abortBatch();
+    queuedTraCIcommands.clear();
+}
+
+
 // ################################################################
 //                            subscription
 // ################################################################
@@ -160,6 +181,42 @@ TraCIBuffer TraCI_Commands::subscribePerson(uint32_t beginTime, uint32_t endTime
 }
 
 
+// CMD_SUBSCRIBE_LANE_VARIABLE
+TraCIBuffer TraCI_Commands::subscribeLane(uint32_t beginTime, uint32_t endTime, std::string objectId, std::vector<uint8_t> variables)
+{
+    record_TraCI_activity_func(commandStart, CMD_SUBSCRIBE_LANE_VARIABLE, 0xff, "subscribeLane");
+
+    TraCIBuffer p;
+    p << beginTime << endTime << objectId << (uint8_t)variables.size();
+    for(uint8_t i : variables)
+        p << i;
+
+    TraCIBuffer buf = connection->query(CMD_SUBSCRIBE_LANE_VARIABLE, p);
+
+    record_TraCI_activity_func(commandComplete, CMD_SUBSCRIBE_LANE_VARIABLE, 0xff, "subscribeLane");
+
+    return buf;
+}
+
+
+// CMD_SUBSCRIBE_INDUCTIONLOOP_VARIABLE
+TraCIBuffer TraCI_Commands::subscribeInductionLoop(uint32_t beginTime, uint32_t endTime, std::string objectId, std::vector<uint8_t> variables)
+{
+    record_TraCI_activity_func(commandStart, CMD_SUBSCRIBE_INDUCTIONLOOP_VARIABLE, 0xff, "subscribeInductionLoop");
+
+    TraCIBuffer p;
+    p << beginTime << endTime << objectId << (uint8_t)variables.size();
+    for(uint8_t i : variables)
+        p << i;
+
+    TraCIBuffer buf = connection->query(CMD_SUBSCRIBE_INDUCTIONLOOP_VARIABLE, p);
+
+    record_TraCI_activity_func(commandComplete, CMD_SUBSCRIBE_INDUCTIONLOOP_VARIABLE, 0xff, "subscribeInductionLoop");
+
+    return buf;
+}
+
+
 // ################################################################
 //                            simulation
 // ################################################################
@@ -1470,11 +1527,9 @@ void TraCI_Commands::vehicleSetSpeed(std::string nodeId, double speed)
 
     uint8_t variableId = VAR_SPEED;
     uint8_t variableType = TYPE_DOUBLE;
-    TraCIBuffer buf = connection->query(CMD_SET_VEHICLE_VARIABLE, TraCIBuffer() << variableId << nodeId << variableType << speed);
+    bool sent = connection->set(CMD_SET_VEHICLE_VARIABLE, TraCIBuffer() << variableId << nodeId << variableType << speed);
 
-    ASSERT(buf.eof());
-
-    record_TraCI_activity_func(commandComplete, CMD_SET_VEHICLE_VARIABLE, VAR_SPEED, "vehicleSetSpeed");
+    record_TraCI_activity_func(sent ? commandComplete : commandQueued, CMD_SET_VEHICLE_VARIABLE, VAR_SPEED, "vehicleSetSpeed");
 }
 
 
@@ -1513,10 +1568,9 @@ void TraCI_Commands::vehicleSetLaneChangeMode(std::string nodeId, int32_t bitset
 
     uint8_t variableId = 0xb6;
     uint8_t variableType = TYPE_INTEGER;
-    TraCIBuffer buf = connection->query(CMD_SET_VEHICLE_VARIABLE, TraCIBuffer() << variableId << nodeId << variableType << bitset);
-    ASSERT(buf.eof());
+    bool sent = connection->set(CMD_SET_VEHICLE_VARIABLE, TraCIBuffer() << variableId << nodeId << variableType << bitset);
 
-    record_TraCI_activity_func(commandComplete, CMD_SET_VEHICLE_VARIABLE, VAR_LANECHANGE_MODE, "vehicleSetLaneChangeMode");
+    record_TraCI_activity_func(sent ? commandComplete : commandQueued, CMD_SET_VEHICLE_VARIABLE, VAR_LANECHANGE_MODE, "vehicleSetLaneChangeMode");
 }
 
 
@@ -1622,11 +1676,9 @@ void TraCI_Commands::vehicleSetColor(std::string nodeId, const colorVal_t color)
     p << static_cast<uint8_t>(VAR_COLOR);
     p << nodeId;
     p << static_cast<uint8_t>(TYPE_COLOR) << (uint8_t)color.red << (uint8_t)color.green << (uint8_t)color.blue << (uint8_t)color.alpha;
-    TraCIBuffer buf = connection->query(CMD_SET_VEHICLE_VARIABLE, p);
-
-    ASSERT(buf.eof());
+    bool sent = connection->set(CMD_SET_VEHICLE_VARIABLE, p);
 
-    record_TraCI_activity_func(commandComplete, CMD_SET_VEHICLE_VARIABLE, VAR_COLOR, "vehicleSetColor");
+    record_TraCI_activity_func(sent ? commandComplete : commandQueued, CMD_SET_VEHICLE_VARIABLE, VAR_COLOR, "vehicleSetColor");
 }
 
 
@@ -1747,11 +1799,9 @@ void TraCI_Commands::vehicleSetMaxAccel(std::string nodeId, double value)
     uint8_t variableId = VAR_ACCEL;
     uint8_t variableType = TYPE_DOUBLE;
 
-    TraCIBuffer buf = connection->query(CMD_SET_VEHICLE_VARIABLE, TraCIBuffer() << variableId << nodeId << variableType << value);
+    bool sent = connection->set(CMD_SET_VEHICLE_VARIABLE, TraCIBuffer() << variableId << nodeId << variableType << value);
 
-    ASSERT(buf.eof());
-
-    record_TraCI_activity_func(commandComplete, CMD_SET_VEHICLE_VARIABLE, VAR_ACCEL, "vehicleSetMaxAccel");
+    record_TraCI_activity_func(sent ? commandComplete : commandQueued, CMD_SET_VEHICLE_VARIABLE, VAR_ACCEL, "vehicleSetMaxAccel");
 }
 
 
@@ -1797,7 +1847,7 @@ void TraCI_Commands::vehicleAdd(std::string vehicleId, std::string vehicleTypeId
     uint8_t variableTypeD = TYPE_DOUBLE;
     uint8_t variableTypeB = TYPE_BYTE;
 
-    TraCIBuffer buf = connection->query(CMD_SET_VEHICLE_VARIABLE, TraCIBuffer() << variableId << vehicleId
+    bool sent = connection->set(CMD_SET_VEHICLE_VARIABLE, TraCIBuffer() << variableId << vehicleId
             << variableType << (int32_t) 6
             << variableTypeS
             << vehicleTypeId
@@ -1812,9 +1862,7 @@ void TraCI_Commands::vehicleAdd(std::string vehicleId, std::string vehicleTypeId
             << variableTypeB
             << lane);        // departure lane
 
-    ASSERT(buf.eof());
-
-    record_TraCI_activity_func(commandComplete, CMD_SET_VEHICLE_VARIABLE, ADD, "vehicleAdd");
+    record_TraCI_activity_func(sent ? commandComplete : commandQueued, CMD_SET_VEHICLE_VARIABLE, ADD, "vehicleAdd");
 }
 
 
@@ -2126,10 +2174,9 @@ void TraCI_Commands::routeAdd(std::string name, std::vector<std::string> route)
             buffer << (int8_t)str[i];
     }
 
-    TraCIBuffer buf = connection->query(CMD_SET_ROUTE_VARIABLE, buffer);
-    ASSERT(buf.eof());
+    bool sent = connection->set(CMD_SET_ROUTE_VARIABLE, buffer);
 
-    record_TraCI_activity_func(commandComplete, CMD_SET_ROUTE_VARIABLE, ADD, "routeAdd");
+    record_TraCI_activity_func(sent ? commandComplete : commandQueued, CMD_SET_ROUTE_VARIABLE, ADD, "routeAdd");
 }
 
 
@@ -2579,6 +2626,82 @@ void TraCI_Commands::laneSetMaxSpeed(std::string laneId, double value)
 }
 
 
+std::vector<int> TraCI_Commands::laneSubscribe(const std::vector<std::string> &lanes)
+{
+    std::vector<int> indices;
+    indices.reserve(lanes.size());
+
+    for(auto &laneId : lanes)
+    {
+        auto it = laneStateIndex.find(laneId);
+        if(it != laneStateIndex.end())
+        {
+            indices.push_back(it->second);
+            continue;
+        }
+
+        int index = laneStates.size();
+        laneStateIndex[laneId] = index;
+        laneStates.push_back({laneId, {}});
+        indices.push_back(index);
+
+        std::vector<uint8_t> variables {LAST_STEP_VEHICLE_ID_LIST};
+        TraCIBuffer buf = subscribeLane(0, 0x7FFFFFFF, laneId, variables);
+
+        // the subscription response holds the state of the current time step
+        uint8_t cmdLength_resp; buf >> cmdLength_resp;
+        uint32_t cmdLengthExt_resp; buf >> cmdLengthExt_resp;
+        uint8_t commandId_resp; buf >> commandId_resp;
+        ASSERT(commandId_resp == RESPONSE_SUBSCRIBE_LANE_VARIABLE);
+        std::string objectId_resp; buf >> objectId_resp;
+
+        processLaneSubscription(objectId_resp, buf);
+        ASSERT(buf.eof());
+    }
+
+    return indices;
+}
+
+
+// the subscription results of all lanes arrive at the beginning of each time step
+void TraCI_Commands::processLaneSubscription(std::string objectId, TraCIBuffer& buf)
+{
+    auto it = laneStateIndex.find(objectId);
+    if(it == laneStateIndex.end())
+        throw omnetpp::cRuntimeError("Received subscription result for unknown lane '%s'", objectId.c_str());
+
+    laneState_t &state = laneStates[it->second];
+
+    uint8_t variableNumber_resp; buf >> variableNumber_resp;
+    for (uint8_t j = 0; j < variableNumber_resp; ++j)
+    {
+        uint8_t variable_resp; buf >> variable_resp;
+        uint8_t isokay; buf >> isokay;
+
+        if (isokay != RTYPE_OK)
+        {
+            uint8_t varType; buf >> varType;
+            ASSERT(varType == TYPE_STRING);
+            std::string errormsg; buf >> errormsg;
+
+            throw omnetpp::cRuntimeError("TraCI server reported error subscribing to lane variable 0x%2x (\"%s\").", variable_resp, errormsg.c_str());
+        }
+        else if (variable_resp == LAST_STEP_VEHICLE_ID_LIST)
+        {
+            uint8_t varType; buf >> varType;
+            ASSERT(varType == TYPE_STRINGLIST);
+
+            uint32_t count; buf >> count;
+            state.vehicles.resize(count);
+            for (uint32_t i = 0; i < count; i++)
+                buf >> state.vehicles[i];
+        }
+        else
+            throw omnetpp::cRuntimeError("Received unhandled lane subscription result; type: 0x%2x", variable_resp);
+    }
+}
+
+
 
 // ################################################################
 //                 loop detector (E1-Detectors)
@@ -2708,6 +2831,31 @@ std::vector<vehLD_t> TraCI_Commands::LDGetLastStepVehicleData(std::string loopId
 
     uint8_t resType_r; buf >> resType_r;
     ASSERT(resType_r == resultTypeId);
+    std::vector<vehLD_t> res = readLDVehicleData(buf);
+
+    ASSERT(buf.eof());
+
+    record_TraCI_activity_func(commandComplete, CMD_GET_INDUCTIONLOOP_VARIABLE, LAST_STEP_VEHICLE_DATA, "LDGetLastStepVehicleData");
+
+    return res;
+}
+
+
+double TraCI_Commands::LDGetLastStepOccupancy(std::string loopId)
+{
+    record_TraCI_activity_func(commandStart, CMD_GET_INDUCTIONLOOP_VARIABLE, LAST_STEP_OCCUPANCY, "LDGetLastStepOccupancy");
+
+    double result = genericGetDouble(CMD_GET_INDUCTIONLOOP_VARIABLE, loopId, 0x13, RESPONSE_GET_INDUCTIONLOOP_VARIABLE);
+
+    record_TraCI_activity_func(commandComplete, CMD_GET_INDUCTIONLOOP_VARIABLE, LAST_STEP_OCCUPANCY, "LDGetLastStepOccupancy");
+
+    return result;
+}
+
+
+// reads the value of LAST_STEP_VEHICLE_DATA (after its type)
+std::vector<vehLD_t> TraCI_Commands::readLDVehicleData(TraCIBuffer& buf)
+{
     uint32_t count; buf >> count;
 
     // now we start getting real data that we are looking for
@@ -2749,23 +2897,101 @@ std::vector<vehLD_t> TraCI_Commands::LDGetLastStepVehicleData(std::string loopId
         res.push_back(entry);
     }
 
-    ASSERT(buf.eof());
+    return res;
+}
 
-    record_TraCI_activity_func(commandComplete, CMD_GET_INDUCTIONLOOP_VARIABLE, LAST_STEP_VEHICLE_DATA, "LDGetLastStepVehicleData");
 
-    return res;
+void TraCI_Commands::LDSubscribe()
+{
+    if(LDSubscribed)
+        return;
+
+    LDSubscribed = true;
+
+    for(auto &loopId : LDGetIDList())
+    {
+        LDStateIndex[loopId] = LDStates.size();
+        LDStates.push_back({loopId, -1, 0, {}});
+
+        std::vector<uint8_t> variables {LAST_STEP_MEAN_SPEED, LAST_STEP_TIME_SINCE_DETECTION, LAST_STEP_VEHICLE_DATA};
+        TraCIBuffer buf = subscribeInductionLoop(0, 0x7FFFFFFF, loopId, variables);
+
+        uint8_t cmdLength_resp; buf >> cmdLength_resp;
+        uint32_t cmdLengthExt_resp; buf >> cmdLengthExt_resp;
+        uint8_t commandId_resp; buf >> commandId_resp;
+        ASSERT(commandId_resp == RESPONSE_SUBSCRIBE_INDUCTIONLOOP_VARIABLE);
+        std::string objectId_resp; buf >> objectId_resp;
+
+        processLDSubscription(objectId_resp, buf);
+        ASSERT(buf.eof());
+    }
+
+    // the subscription response holds the state of the current time step
+    LDActive.clear();
+    for(unsigned int i = 0; i < LDStates.size(); i++)
+        if(!LDStates[i].vehicles.empty())
+            LDActive.push_back(i);
 }
 
 
-double TraCI_Commands::LDGetLastStepOccupancy(std::string loopId)
+int TraCI_Commands::LDGetIndex(std::string loopId)
 {
-    record_TraCI_activity_func(commandStart, CMD_GET_INDUCTIONLOOP_VARIABLE, LAST_STEP_OCCUPANCY, "LDGetLastStepOccupancy");
+    auto it = LDStateIndex.find(loopId);
+    if(it == LDStateIndex.end())
+        return -1;
 
-    double result = genericGetDouble(CMD_GET_INDUCTIONLOOP_VARIABLE, loopId, 0x13, RESPONSE_GET_INDUCTIONLOOP_VARIABLE);
+    return it->second;
+}
 
-    record_TraCI_activity_func(commandComplete, CMD_GET_INDUCTIONLOOP_VARIABLE, LAST_STEP_OCCUPANCY, "LDGetLastStepOccupancy");
 
-    return result;
+// the subscription results of all loop detectors arrive at the beginning of each time
+// step. LDActive is cleared before that (see TraCI_Start::handleMessage)
+void TraCI_Commands::processLDSubscription(std::string objectId, TraCIBuffer& buf)
+{
+    auto it = LDStateIndex.find(objectId);
+    if(it == LDStateIndex.end())
+        throw omnetpp::cRuntimeError("Received subscription result for unknown loop detector '%s'", objectId.c_str());
+
+    LDState_t &state = LDStates[it->second];
+
+    uint8_t variableNumber_resp; buf >> variableNumber_resp;
+    for (uint8_t j = 0; j < variableNumber_resp; ++j)
+    {
+        uint8_t variable_resp; buf >> variable_resp;
+        uint8_t isokay; buf >> isokay;
+
+        if (isokay != RTYPE_OK)
+        {
+            uint8_t varType; buf >> varType;
+            ASSERT(varType == TYPE_STRING);
+            std::string errormsg; buf >> errormsg;
+
+            throw omnetpp::cRuntimeError("TraCI server reported error subscribing to loop detector variable 0x%2x (\"%s\").", variable_resp, errormsg.c_str());
+        }
+        else if (variable_resp == LAST_STEP_MEAN_SPEED)
+        {
+            uint8_t varType; buf >> varType;
+            ASSERT(varType == TYPE_DOUBLE);
+            buf >> state.meanSpeed;
+        }
+        else if (variable_resp == LAST_STEP_TIME_SINCE_DETECTION)
+        {
+            uint8_t varType; buf >> varType;
+            ASSERT(varType == TYPE_DOUBLE);
+            buf >> state.elapsedTime;
+        }
+        else if (variable_resp == LAST_STEP_VEHICLE_DATA)
+        {
+            uint8_t varType; buf >> varType;
+            ASSERT(varType == TYPE_COMPOUND);
+            state.vehicles = readLDVehicleData(buf);
+
+            if(!state.vehicles.empty())
+                LDActive.push_back(it->second);
+        }
+        else
+            throw omnetpp::cRuntimeError("Received unhandled loop detector subscription result; type: 0x%2x", variable_resp);
+    }
 }
 
 
@@ -3040,10 +3266,9 @@ void TraCI_Commands::TLSetProgram(std::string TLid, std::string value)
     uint8_t variableId = TL_PROGRAM;
     uint8_t variableType = TYPE_STRING;
 
-    TraCIBuffer buf = connection->query(CMD_SET_TL_VARIABLE, TraCIBuffer() << variableId << TLid << variableType << value);
-    ASSERT(buf.eof());
+    bool sent = connection->set(CMD_SET_TL_VARIABLE, TraCIBuffer() << variableId << TLid << variableType << value);
 
-    record_TraCI_activity_func(commandComplete, CMD_SET_TL_VARIABLE, TL_PROGRAM, "TLSetProgram");
+    record_TraCI_activity_func(sent ? commandComplete : commandQueued, CMD_SET_TL_VARIABLE, TL_PROGRAM, "TLSetProgram");
 }
 
 
@@ -3054,10 +3279,9 @@ void TraCI_Commands::TLSetPhaseIndex(std::string TLid, int value)
     uint8_t variableId = TL_PHASE_INDEX;
     uint8_t variableType = TYPE_INTEGER;
 
-    TraCIBuffer buf = connection->query(CMD_SET_TL_VARIABLE, TraCIBuffer() << variableId << TLid << variableType << value);
-    ASSERT(buf.eof());
+    bool sent = connection->set(CMD_SET_TL_VARIABLE, TraCIBuffer() << variableId << TLid << variableType << value);
 
-    record_TraCI_activity_func(commandComplete, CMD_SET_TL_VARIABLE, TL_PHASE_INDEX, "TLSetPhaseIndex");
+    record_TraCI_activity_func(sent ? commandComplete : commandQueued, CMD_SET_TL_VARIABLE, TL_PHASE_INDEX, "TLSetPhaseIndex");
 }
 
 
@@ -3068,10 +3292,9 @@ void TraCI_Commands::TLSetPhaseDuration(std::string TLid, int value)
     uint8_t variableId = TL_PHASE_DURATION;
     uint8_t variableType = TYPE_INTEGER;
 
-    TraCIBuffer buf = connection->query(CMD_SET_TL_VARIABLE, TraCIBuffer() << variableId << TLid << variableType << value);
-    ASSERT(buf.eof());
+    bool sent = connection->set(CMD_SET_TL_VARIABLE, TraCIBuffer() << variableId << TLid << variableType << value);
 
-    record_TraCI_activity_func(commandComplete, CMD_SET_TL_VARIABLE, TL_PHASE_DURATION, "TLSetPhaseDuration");
+    record_TraCI_activity_func(sent ? commandComplete : commandQueued, CMD_SET_TL_VARIABLE, TL_PHASE_DURATION, "TLSetPhaseDuration");
 }
 
 
@@ -3082,10 +3305,9 @@ void TraCI_Commands::TLSetState(std::string TLid, std::string value)
     uint8_t variableId = TL_RED_YELLOW_GREEN_STATE;
     uint8_t variableType = TYPE_STRING;
 
-    TraCIBuffer buf = connection->query(CMD_SET_TL_VARIABLE, TraCIBuffer() << variableId << TLid << variableType << value);
-    ASSERT(buf.eof());
+    bool sent = connection->set(CMD_SET_TL_VARIABLE, TraCIBuffer() << variableId << TLid << variableType << value);
 
-    record_TraCI_activity_func(commandComplete, CMD_SET_TL_VARIABLE, TL_RED_YELLOW_GREEN_STATE, "TLSetState");
+    record_TraCI_activity_func(sent ? commandComplete : commandQueued, CMD_SET_TL_VARIABLE, TL_RED_YELLOW_GREEN_STATE, "TLSetState");
 }
 
 
@@ -3985,6 +4207,33 @@ boost::filesystem::path TraCI_Commands::getFullPath_SUMOConfig()
 }
 
 
+boost::filesystem::path TraCI_Commands::getFullPath_ScenarioSnapshot()
+{
+    if(!par("scenarioSnapshot").boolValue())
+        return boost::filesystem::path();
+
+    return getFullPath_SUMOConfig().parent_path() / "snapshot";
+}
+
+
+std::shared_ptr<const SumoNet> TraCI_Commands::getNetModel()
+{
+    if(!netModel)
+    {
+        try
+        {
+            netModel = SumoNet::load(SumoNet::netFileOf(getFullPath_SUMOConfig()));
+        }
+        catch(std::exception &e)
+        {
+            throw omnetpp::cRuntimeError("%s", e.what());
+        }
+    }
+
+    return netModel;
+}
+
+
 bool TraCI_Commands::IsGUI()
 {
     std::string sumo_application = this->par("SUMOapplication").stdstringValue();
@@ -4474,11 +4723,42 @@ void TraCI_Commands::record_TraCI_activity_func(TraCI_Commands::action_t state,
         if(!found)
             throw omnetpp::cRuntimeError("pair (%x, %x) is not found in exchangedTraCIcommands \n", commandGroupId, commandId);
     }
+    else if(state == commandQueued)
+    {
+        bool found = false;
+        for (auto it = exchangedTraCIcommands.rbegin(); it != exchangedTraCIcommands.rend(); ++it)
+        {
+            if(it->commandGroupId == commandGroupId && it->commandId == commandId)
+            {
+                found = true;
+                queuedTraCIcommands.push_back(exchangedTraCIcommands.rend() - it - 1);
+                break;
+            }
+        }
+
+        if(!found)
+            throw omnetpp::cRuntimeError("pair (%x, %x) is not found in exchangedTraCIcommands \n", commandGroupId, commandId);
+    }
     else
         throw omnetpp::cRuntimeError("unknown state '%d' in record_TraCI_activity_func method", state);
 }
 
 
+// the set commands of a batch are complete when the batch is sent and acknowledged
+void TraCI_Commands::record_TraCI_batchSent()
+{
+    if(queuedTraCIcommands.empty())
+        return;
+
+    Htime_t endTime = std::chrono::high_resolution_clock::now();
+
+    for(size_t index : queuedTraCIcommands)
+        exchangedTraCIcommands[index].completeAt = endTime;
+
+    queuedTraCIcommands.clear();
+}
+
+
 void TraCI_Commands::save_TraCI_activity_toFile()
 {
     if(exchangedTraCIcommands.empty())
@@ -28,9 +28,11 @@
 #ifndef TraCICOMMANDS_H
 #define TraCICOMMANDS_H
 
+#include <exception>
 #include <chrono>
 #include <ctime>
 #include <ratio>
+#include <unordered_map>
 
 #undef ev
 #include "boost/filesystem.hpp"
@@ -42,6 +44,7 @@
 #include "mobility/Coord.h"
 #include "global/Color.h"
 #include "global/GlobalConsts.h"
+#include "global/SumoNet.h"
 
 
 namespace VENTOS {
@@ -95,6 +98,22 @@ typedef struct vehLD
     std::string vehType;
 } vehLD_t;
 
+// state of a subscribed lane in the last time step (see TraCI_Commands::laneSubscribe)
+typedef struct laneState
+{
+    std::string id;
+    std::vector<std::string> vehicles;    // vehicles on the lane, in the order of LAST_STEP_VEHICLE_ID_LIST
+} laneState_t;
+
+// state of a subscribed loop detector in the last time step (see TraCI_Commands::LDSubscribe)
+typedef struct LDState
+{
+    std::string id;
+    double meanSpeed;                 // -1 if no vehicle passed the detector
+    double elapsedTime;               // time since the last detection
+    std::vector<vehLD_t> vehicles;    // vehicles on the detector
+} LDState_t;
+
 typedef struct leader
 {
     std::string leaderID;
@@ -221,6 +240,19 @@ protected:
     TraCICoord netbounds2;
     int margin;
 
+    // parsed net file of the SUMO config (see getNetModel)
+    std::shared_ptr<const SumoNet> netModel;
+
+    // subscribed lanes (see laneSubscribe)
+    std::vector<laneState_t> laneStates;
+    std::unordered_map<std::string /*lane id*/, int /*index into laneStates*/> laneStateIndex;
+
+    // subscribed loop detectors (see LDSubscribe)
+    bool LDSubscribed = false;
+    std::vector<LDState_t> LDStates;
+    std::unordered_map<std::string /*LD id*/, int /*index into LDStates*/> LDStateIndex;
+    std::vector<int> LDActive;
+
     bool equilibrium_vehicle = false;
 
     // start/end/duration of simulation
@@ -241,6 +273,7 @@ protected:
 
     bool record_TraCI_activity;
     std::vector<TraCIcommandEntry_t> exchangedTraCIcommands;
+    std::vector<size_t> queuedTraCIcommands;  // entries of set commands waiting in a batch
 
     // storing the mapping between vehicle ids and the corresponding SUMO ids
     std::map<std::string /*veh SUMO id*/, std::string /*veh OMNET id*/> SUMOid_OMNETid_mapping;
@@ -258,6 +291,10 @@ public:
 
     static TraCI_Commands * getTraCI();
 
+    void beginBatch();
+    void endBatch();
+    void abortBatch();
+
     // ################################################################
     //                          subscription
     // ################################################################
@@ -268,6 +305,10 @@ public:
     TraCIBuffer subscribeVehicle(uint32_t beginTime, uint32_t endTime, std::string objectId, std::vector<uint8_t> variables);
     // CMD_SUBSCRIBE_PERSON_VARIABLE
     TraCIBuffer subscribePerson(uint32_t beginTime, uint32_t endTime, std::string objectId, std::vector<uint8_t> variables);
+    // CMD_SUBSCRIBE_LANE_VARIABLE
+    TraCIBuffer subscribeLane(uint32_t beginTime, uint32_t endTime, std::string objectId, std::vector<uint8_t> variables);
+    // CMD_SUBSCRIBE_INDUCTIONLOOP_VARIABLE
+    TraCIBuffer subscribeInductionLoop(uint32_t beginTime, uint32_t endTime, std::string objectId, std::vector<uint8_t> variables);
 
     // ################################################################
     //                            simulation
@@ -455,6 +496,12 @@ public:
     // CMD_SET_LANE_VARIABLE
     void laneSetMaxSpeed(std::string, double);
 
+    // subscribes to the vehicles on these lanes. Lanes that are already subscribed are
+    // skipped. Their state is then updated at the beginning of each time step with no
+    // further query. Returns the index of each lane for laneGetState
+    std::vector<int> laneSubscribe(const std::vector<std::string> &);
+    const laneState_t & laneGetState(int index) { return laneStates[index]; }
+
     // ################################################################
     //                 loop detector (E1-Detectors)
     // ################################################################
@@ -471,6 +518,15 @@ public:
     std::vector<vehLD_t> LDGetLastStepVehicleData(std::string);
     double LDGetLastStepOccupancy(std::string);
 
+    // subscribes to all loop detectors (only once). Their state is then updated
+    // at the beginning of each time step with no further query
+    void LDSubscribe();
+    // subscribed loop detectors with at least one vehicle in the last time step
+    const std::vector<int> & LDGetActive() { return LDActive; }
+    const LDState_t & LDGetState(int index) { return LDStates[index]; }
+    // returns -1 if this loop detector is not subscribed
+    int LDGetIndex(std::string);
+
     // ################################################################
     //                lane area detector (E2-Detectors)
     // ################################################################
@@ -624,6 +680,8 @@ public:
 
     boost::filesystem::path getFullPath_SUMOApplication();
     boost::filesystem::path getFullPath_SUMOConfig();
+    boost::filesystem::path getFullPath_ScenarioSnapshot();  // empty if scenarioSnapshot is off
+    std::shared_ptr<const SumoNet> getNetModel();           // net file of the SUMO config, parsed once
 
     bool IsGUI();
 
@@ -665,6 +723,10 @@ protected:
     void recordDeparture(std::string SUMOID);
     void recordArrival(std::string SUMOID);
 
+    void processLaneSubscription(std::string objectId, TraCIBuffer& buf);
+    void processLDSubscription(std::string objectId, TraCIBuffer& buf);
+    void record_TraCI_batchSent();
+
 private:
     // ################################################################
     //                    generic methods for getters
@@ -679,10 +741,13 @@ private:
     uint8_t genericGetUnsignedByte(uint8_t commandId, std::string objectId, uint8_t variableId, uint8_t responseId);
     std::vector<double> genericGetBoundingBox(uint8_t commandId, std::string objectId, uint8_t variableId, uint8_t responseId);
 
+    std::vector<vehLD_t> readLDVehicleData(TraCIBuffer& buf);
+
     enum action_t
     {
         commandStart,
         commandComplete,
+        commandQueued,    // set command waiting in a batch. It is complete once the batch is sent
     };
 
     // logging TraCI exchange
@@ -691,6 +756,35 @@ private:
     void save_TraCI_activity_summary_toFile();
 };
 
+
+// Opens a batch of set commands (see TraCI_Commands::beginBatch) for the lifetime
+// of this object, and sends the queued commands when it goes out of scope. If an
+// exception is thrown in between, the batch is closed without sending anything,
+// so the connection is never left in batch mode.
+class TraCIBatch
+{
+private:
+    TraCI_Commands *TraCI;
+
+public:
+    explicit TraCIBatch(TraCI_Commands *TraCI) : TraCI(TraCI)
+    {
+        TraCI->beginBatch();
+    }
+
+    // sending the batch can throw (e.g. SUMO rejects a command)
+    ~TraCIBatch() noexcept(false)
+    {
+        if(std::uncaught_exception())
+            TraCI->abortBatch();
+        else
+            TraCI->endBatch();
+    }
+
+    TraCIBatch(const TraCIBatch&) = delete;
+    TraCIBatch& operator=(const TraCIBatch&) = delete;
+};
+
 }
 
 #endif
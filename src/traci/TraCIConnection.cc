@@ -49,12 +49,17 @@
 #include "traci/TraCICommands.h"
 #include "logging/VENTOS_logging.h"
 #include "global/utility.h"
+#include "global/HotPathCounters.h"
 
 namespace VENTOS {
 
 pid_t TraCIConnection::child_pid = -1;
 void* TraCIConnection::socketPtr = NULL;
 std::mutex TraCIConnection::lock_TraCI;
+int TraCIConnection::batchDepth = 0;
+std::string TraCIConnection::batchCommands;
+std::vector<uint8_t> TraCIConnection::batchIds;
+std::function<void()> TraCIConnection::batchSent;
 
 SOCKET socket(void* ptr)
 {
@@ -288,12 +293,113 @@ TraCIConnection* TraCIConnection::connect(const char* host, int port)
 
 TraCIBuffer TraCIConnection::query(uint8_t commandGroupId, const TraCIBuffer& buf)
 {
+    HOTPATH_SCOPE("TraCIConnection::query");
+
     // protect simultaneous access to TraCI
     std::lock_guard<std::mutex> lock(lock_TraCI);
 
+    // commands queued before this one should be executed first
+    flushBatch();
+
+    sendMessage(makeTraCICommand(commandGroupId, buf));
+
+    TraCIBuffer obuf(receiveMessage());
+    checkStatus(obuf, commandGroupId);
+
+    return obuf;
+}
+
+
+bool TraCIConnection::set(uint8_t commandGroupId, const TraCIBuffer& buf)
+{
+    // protect simultaneous access to TraCI
+    std::lock_guard<std::mutex> lock(lock_TraCI);
+
+    if(batchDepth > 0)
+    {
+        batchCommands += makeTraCICommand(commandGroupId, buf);
+        batchIds.push_back(commandGroupId);
+        if(batchIds.size() < MAX_BATCH)
+            return false;
+
+        flushBatch();
+        return true;
+    }
+
     sendMessage(makeTraCICommand(commandGroupId, buf));
 
     TraCIBuffer obuf(receiveMessage());
+    checkStatus(obuf, commandGroupId);
+    ASSERT(obuf.eof());
+
+    return true;
+}
+
+
+void TraCIConnection::beginBatch()
+{
+    std::lock_guard<std::mutex> lock(lock_TraCI);
+    batchDepth++;
+}
+
+
+void TraCIConnection::endBatch()
+{
+    std::lock_guard<std::mutex> lock(lock_TraCI);
+
+    ASSERT(batchDepth > 0);
+    if(--batchDepth == 0)
+        flushBatch();
+}
+
+
+void TraCIConnection::abortBatch()
+{
+    std::lock_guard<std::mutex> lock(lock_TraCI);
+
+    ASSERT(batchDepth > 0);
+    if(--batchDepth == 0)
+    {
+        batchCommands.clear();
+        batchIds.clear();
+    }
+}
+
+
+void TraCIConnection::setBatchSentCallback(std::function<void()> callback)
+{
+    std::lock_guard<std::mutex> lock(lock_TraCI);
+    batchSent = callback;
+}
+
+
+// sends all queued commands in one message. The server answers with
+// one status response per command, in the same order
+void TraCIConnection::flushBatch()
+{
+    if(batchIds.empty())
+        return;
+
+    std::string commands;
+    commands.swap(batchCommands);
+    std::vector<uint8_t> ids;
+    ids.swap(batchIds);
+
+    sendMessage(commands);
+
+    TraCIBuffer obuf(receiveMessage());
+    for(uint8_t commandGroupId : ids)
+        checkStatus(obuf, commandGroupId);
+
+    ASSERT(obuf.eof());
+
+    if(batchSent)
+        batchSent();
+}
+
+
+void TraCIConnection::checkStatus(TraCIBuffer& obuf, uint8_t commandGroupId)
+{
     uint8_t cmdLength; obuf >> cmdLength;
     uint8_t commandResp; obuf >> commandResp;
     ASSERT(commandResp == commandGroupId);
@@ -307,8 +413,6 @@ TraCIBuffer TraCIConnection::query(uint8_t commandGroupId, const TraCIBuffer& bu
         throw omnetpp::cRuntimeError("TraCI server reported throw cRuntimeError executing command 0x%2x (\"%s\").", commandGroupId, description.c_str());
 
     ASSERT(result == RTYPE_OK);
-
-    return obuf;
 }
 
 
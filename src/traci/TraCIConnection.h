@@ -30,6 +30,8 @@
 
 #include <stdint.h>
 #include <mutex>
+#include <functional>
+#include <vector>
 
 #include "mobility/Coord.h"
 #include "mobility/TraCICoord.h"
@@ -44,6 +46,13 @@ private:
     static pid_t child_pid;
     static std::mutex lock_TraCI;
 
+    // set commands queued between beginBatch() and endBatch()
+    static int batchDepth;
+    static std::string batchCommands;
+    static std::vector<uint8_t> batchIds;  // command id of each queued command
+    static const uint32_t MAX_BATCH = 1000;
+    static std::function<void()> batchSent;  // called after the responses of a batch are checked
+
 public:
     static void startSUMO(std::string SUMOexe, std::string SUMOconfig, std::string SUMOswitches, int port);
     static int getFreeEphemeralPort();
@@ -55,6 +64,20 @@ public:
      */
     TraCIBuffer query(uint8_t commandId, const TraCIBuffer& buf = TraCIBuffer());
 
+    /**
+     * sends a command whose only response is the status. Between beginBatch() and endBatch()
+     * the command is queued and sent together with the other queued commands in one message.
+     * Any query() sends the queued commands first, so the order of commands is kept.
+     * Returns false if the command is still queued
+     */
+    bool set(uint8_t commandId, const TraCIBuffer& buf);
+
+    void beginBatch();
+    void endBatch();
+    // leaves batch mode after an error without sending anything. The queued commands are dropped
+    void abortBatch();
+    void setBatchSentCallback(std::function<void()> callback);
+
     /**
      * sends a message via TraCI (after adding the header)
      */
@@ -67,6 +90,8 @@ public:
 
 private:
     TraCIConnection(void*);
+    void flushBatch();
+    void checkStatus(TraCIBuffer& obuf, uint8_t commandGroupId);
     void terminateSimulationOnError(std::string);
     static std::string getSUMOversion(std::string path);
 };
@@ -39,6 +39,8 @@
 
 #include "MIXIM_veins/obstacle/ObstacleControl.h"
 #include "router/Router.h"
+#include "global/SignalObj.h"
+#include "global/ScenarioSnapshot.h"
 #include "logging/VENTOS_logging.h"
 
 namespace VENTOS {
@@ -114,6 +116,8 @@ void TraCI_Start::initialize(int stage)
             Signal_arrived_vehs = registerSignal("vehicleArrivedSignal");
             this->subscribe("vehicleArrivedSignal", this);
 
+            Signal_edge_changed = registerSignal("vehicleEdgeChangedSignal");
+
             autoTerminate = par("autoTerminate");
             equilibrium_vehicle = par("equilibrium_vehicle").boolValue();
         }
@@ -161,6 +165,9 @@ void TraCI_Start::handleMessage(omnetpp::cMessage *msg)
             // proceed SUMO simulation to advance to targetTime
             auto output = simulationTimeStep(targetTime);
 
+            // loop detectors with vehicles in this time step are filled again from the subscription results
+            LDActive.clear();
+
             for (uint32_t i = 0; i < output.second /*number of subscription results*/; ++i)
                 processSubcriptionResult(output.first);
         }
@@ -267,6 +274,9 @@ void TraCI_Start::init_traci()
     // then connect to the 'SUMO TraCI server'
     connection = TraCIConnection::connect("localhost", port);
 
+    // set commands queued in a batch are complete once the batch is sent
+    connection->setBatchSentCallback([this]() { record_TraCI_batchSent(); });
+
     // get the version of SUMO TraCI API
     std::pair<uint32_t, std::string> versionS = getVersion();
     uint32_t apiVersionS = versionS.first;
@@ -341,24 +351,84 @@ void TraCI_Start::init_obstacles()
     Veins::ObstacleControl* obstacles = Veins::ObstacleControlAccess().getIfExists();
     if (obstacles)
     {
-        // get list of polygons
-        auto ids = polygonGetIDList();
+        // polygons are kept in SUMO coordinates in the snapshot
+        typedef struct polygon
+        {
+            std::string id;
+            std::string typeId;
+            std::vector<TraCICoord> coords;
+        } polygon_t;
+
+        std::vector<polygon_t> polygons;
 
-        for (auto &id : ids)
+        boost::filesystem::path snapshotDir = getFullPath_ScenarioSnapshot();
+        std::string snapshotKey = snapshotDir.empty() ? "" : ScenarioSnapshot::scenarioKey(getFullPath_SUMOConfig().parent_path());
+        ScenarioSnapshot snapshot(snapshotDir, "obstacles");
+
+        if(!snapshotDir.empty() && snapshot.open(snapshotKey))
         {
-            std::string typeId = polygonGetTypeID(id);
+            LOG_DEBUG << boost::format("    Reading obstacles from snapshot %1% \n") % snapshotDir.string() << std::flush;
 
-            if (!obstacles->isTypeSupported(typeId))
-                continue;
+            snapshotReader reader = snapshot.getReader();
+            uint32_t count = reader.get<uint32_t>();
+            for(uint32_t i = 0; i < count; i++)
+            {
+                polygon_t poly;
+                poly.id = reader.getString();
+                poly.typeId = reader.getString();
+
+                uint32_t numCoords = reader.get<uint32_t>();
+                for(uint32_t j = 0; j < numCoords; j++)
+                    poly.coords.push_back(reader.get<TraCICoord>());
+
+                polygons.push_back(poly);
+            }
+        }
+        else
+        {
+            // get list of polygons
+            auto ids = polygonGetIDList();
+
+            for (auto &id : ids)
+            {
+                std::string typeId = polygonGetTypeID(id);
+
+                // the snapshot keeps all polygons, since the supported
+                // obstacle types are set in omnetpp.ini and can differ between configs
+                if (snapshotDir.empty() && !obstacles->isTypeSupported(typeId))
+                    continue;
+
+                polygons.push_back({id, typeId, polygonGetShape(id)});
+            }
+
+            if(!snapshotDir.empty())
+            {
+                snapshotWriter writer;
+                writer.put<uint32_t>(polygons.size());
+                for(auto &poly : polygons)
+                {
+                    writer.putString(poly.id);
+                    writer.putString(poly.typeId);
+                    writer.put<uint32_t>(poly.coords.size());
+                    for(auto &point : poly.coords)
+                        writer.put<TraCICoord>(point);
+                }
 
-            auto coords = polygonGetShape(id);
+                snapshot.store(snapshotKey, writer.getBuffer());
+            }
+        }
+
+        for (auto &poly : polygons)
+        {
+            if (!obstacles->isTypeSupported(poly.typeId))
+                continue;
 
             // convert to OMNET++ coordinates
             std::vector<Coord> shape;
-            for(auto &point : coords)
+            for(auto &point : poly.coords)
                 shape.push_back(convertCoord_traci2omnet(point));
 
-            obstacles->addFromTypeAndShape(id, typeId, shape);
+            obstacles->addFromTypeAndShape(poly.id, poly.typeId, shape);
         }
     }
 }
@@ -502,6 +572,10 @@ void TraCI_Start::processSubcriptionResult(TraCIBuffer& buf)
         processVehicleSubscription(objectId_resp, buf);
     else if(commandId_resp == RESPONSE_SUBSCRIBE_PERSON_VARIABLE)
         processPersonSubscription(objectId_resp, buf);
+    else if(commandId_resp == RESPONSE_SUBSCRIBE_LANE_VARIABLE)
+        processLaneSubscription(objectId_resp, buf);
+    else if(commandId_resp == RESPONSE_SUBSCRIBE_INDUCTIONLOOP_VARIABLE)
+        processLDSubscription(objectId_resp, buf);
     else
         throw omnetpp::cRuntimeError("Received unhandled subscription result");
 }
@@ -556,6 +630,7 @@ void TraCI_Start::processSimSubscription(std::string objectId, TraCIBuffer& buf)
                 if (subscribedVehicles.find(idstring) != subscribedVehicles.end())
                 {
                     subscribedVehicles.erase(idstring);
+                    subscribedVehicleEdges.erase(idstring);
 
                     // unsubscribe
                     std::vector<uint8_t> variables;
@@ -788,6 +863,7 @@ void TraCI_Start::processVehicleSubscription(std::string objectId, TraCIBuffer&
             for (std::set<std::string>::const_iterator i = needUnsubscribe.begin(); i != needUnsubscribe.end(); ++i)
             {
                 subscribedVehicles.erase(*i);
+                subscribedVehicleEdges.erase(*i);
 
                 // unsubscribe
                 std::vector<uint8_t> variables;
@@ -852,6 +928,23 @@ void TraCI_Start::processVehicleSubscription(std::string objectId, TraCIBuffer&
     // make sure we got updates for all attributes
     if (numRead != 5) return;
 
+    // signal to those interested (e.g. the router) that this vehicle has entered a new edge.
+    // This replaces polling the edge of every vehicle in each time step
+    if (edge != "")
+    {
+        std::string &lastEdge = subscribedVehicleEdges[objectId];
+        if (lastEdge != edge)
+        {
+            if (mayHaveListeners(Signal_edge_changed))
+            {
+                vehicleEdgeData data(objectId, lastEdge, edge);
+                this->emit(Signal_edge_changed, &data);
+            }
+
+            lastEdge = edge;
+        }
+    }
+
     Coord p = convertCoord_traci2omnet(TraCICoord(px, py));
     if ((p.x < 0) || (p.y < 0))
         throw omnetpp::cRuntimeError("received bad node position (%.2f, %.2f), translated to (%.2f, %.2f)", px, py, p.x, p.y);
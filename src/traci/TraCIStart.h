@@ -29,6 +29,7 @@
 #define TRACISTART_H
 
 #include <queue>
+#include <unordered_map>
 
 #include "global/BaseWorldUtility.h"
 #include "MIXIM_veins/connectionManager/ConnectionManager.h"
@@ -58,8 +59,10 @@ protected:
 
     omnetpp::simsignal_t Signal_departed_vehs;
     omnetpp::simsignal_t Signal_arrived_vehs;
+    omnetpp::simsignal_t Signal_edge_changed;
 
     std::set<std::string> subscribedVehicles;    // all vehicles we have already subscribed to
+    std::unordered_map<std::string, std::string> subscribedVehicleEdges;  // last edge reported for each subscribed vehicle
     std::set<std::string> subscribedPerson;      // all person we have already subscribed to
 
     // next OMNeT++ module vector index to use
@@ -25,6 +25,8 @@
 // Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 //
 
+#include <algorithm>
+
 #include "trafficLight/03_IntersectionDemand.h"
 
 namespace VENTOS {
@@ -59,6 +61,9 @@ void IntersectionQueue::initialize(int stage)
 
         if(queueSizeLimit <= 0 && queueSizeLimit != -1)
             throw omnetpp::cRuntimeError("queueSizeLimit value is set incorrectly!");
+
+        if(record_intersectionQueue_stat)
+            trackIncomingLanes = true;
     }
 }
 
@@ -81,7 +86,7 @@ void IntersectionQueue::initialize_withTraCI()
 {
     super::initialize_withTraCI();
 
-    if(record_intersectionQueue_stat)
+    if(trackIncomingLanes)
     {
         TLList = TraCI->TLGetIDList();
 
@@ -97,11 +102,12 @@ void IntersectionQueue::executeEachTimeStep()
 {
     super::executeEachTimeStep();
 
-    if(record_intersectionQueue_stat)
+    if(trackIncomingLanes)
     {
         updateQueuePerLane();
 
-        updateQueuePerTL();
+        if(record_intersectionQueue_stat)
+            updateQueuePerTL();
     }
 }
 
@@ -128,12 +134,9 @@ void IntersectionQueue::initVariables()
             incomingLanes[lane] = TLid;
 
             // initialize queue value in laneQueueSize to zero
-            queueInfoLane_t entry;
+            queueInfoLane_t &entry = queueInfo_perLane[lane];
             entry.TLid = TLid;
             entry.queueSize = 0;
-            entry.vehs = std::vector<vehInfo_t> ();
-
-            queueInfo_perLane[lane] = entry;
 
             // store all bike lanes and side walks
             auto allowedClasses = TraCI->laneGetAllowedClasses(lane);
@@ -155,43 +158,72 @@ void IntersectionQueue::initVariables()
         else
             ++it;
     }
+
+    // the vehicles on all incoming lanes arrive with the subscription results of each time step
+    std::vector<std::string> lanes;
+    for(auto &y : incomingLanes)
+        lanes.push_back(y.first);
+
+    std::vector<int> indices = TraCI->laneSubscribe(lanes);
+    for(unsigned int i = 0; i < lanes.size(); i++)
+        subscribedLanes.push_back(std::make_pair(lanes[i], indices[i]));
+
+    vehsPerLane.resize(subscribedLanes.size());
 }
 
 
 // update queueInfo_perLane with the latest queue information
 void IntersectionQueue::updateQueuePerLane()
 {
+    uint64_t firstScan = laneScan + 1;
+
     // for each 'lane i' that is controlled by traffic light j
-    for(auto &y : incomingLanes)
+    for(unsigned int i = 0; i < subscribedLanes.size(); i++)
     {
-        std::string lane = y.first;
-        std::string TLid = y.second;
+        const std::string &lane = subscribedLanes[i].first;
+
+        // each lane scan stamps the vehicles it finds
+        laneScan++;
 
         // get all vehicles on this incoming lane
         // note: a vehicle that crosses the intersection is not considered part of the incoming lane
-        auto vehsOnLane = TraCI->laneGetLastStepVehicleIDs(lane);
+        std::vector<int> &vehsOnLane = vehsPerLane[i];
+        vehsOnLane.clear();
+        for(auto &SUMOID : TraCI->laneGetState(subscribedLanes[i].second).vehicles)
+        {
+            int index = vehicleIndex(SUMOID);
+            vehTable[index].lastSeen = laneScan;
+            vehTable[index].lane = i;
+            vehsOnLane.push_back(index);
+        }
+
+        // only the vehicles on the lane are needed for the delay
+        if(!record_intersectionQueue_stat)
+            continue;
 
         // get the vehicles that are waiting on this lane
-        auto location = queueInfo_perLane.find(lane);
-        auto &queuedVehs = location->second.vehs;
+        queueInfoLane_t &queue = queueInfo_perLane.find(lane)->second;
 
-        // remove the vehicles in queuedVehs that are not in vehsOnLane anymore
-        for (auto it = queuedVehs.begin(); it != queuedVehs.end() /* not hoisted */; /* no increment */)
-        {
-            auto search = std::find(vehsOnLane.begin(), vehsOnLane.end(), (*it).id);
-            if (search == vehsOnLane.end())
-                it = queuedVehs.erase(it);
-            else
-                ++it;
-        }
+        // remove the vehicles in the queue that are not on the lane anymore
+        auto newEnd = std::remove_if(queue.vehs.begin(), queue.vehs.end(), [&](int index) {
+            if(vehTable[index].lastSeen == laneScan)
+                return false;
+
+            queue.members.erase(index);
+            queue.classCount[vehTable[index].vehClass]--;
+            return true;
+        });
+        queue.vehs.erase(newEnd, queue.vehs.end());
 
         // iterate over vehicles starting from the end of lane (closer to the intersection)
         int vehCount = 0;
         for(auto rit = vehsOnLane.rbegin(); rit != vehsOnLane.rend(); rit++)
         {
+            int index = *rit;
+            const std::string &SUMOID = vehTable[index].id;
+
             // if the vehicle is waiting
-            auto search = std::find_if(queuedVehs.begin(), queuedVehs.end(), [&](const vehInfo_t &a){return a.id == *rit;});
-            if(search != queuedVehs.end())
+            if(queue.members.count(index))
             {
                 vehCount++;
                 continue;
@@ -200,7 +232,7 @@ void IntersectionQueue::updateQueuePerLane()
             // treating the leading vehicle differently
             if(vehCount == 0)
             {
-                std::vector<TL_info_t> nextTL = TraCI->vehicleGetNextTLS(*rit);
+                std::vector<TL_info_t> nextTL = TraCI->vehicleGetNextTLS(SUMOID);
 
                 // SUMO returns empty 'nextTL' for the leading vehicle.
                 // this happens when the leading vehicle is changing lane on a wrong incoming lane
@@ -210,52 +242,35 @@ void IntersectionQueue::updateQueuePerLane()
                 // queue start should be [0,10] meters from the intersection
                 if(nextTL[0].TLS_distance > 10)
                     break;
-
-                std::string vehType = TraCI->vehicleGetTypeID(*rit);
-
-                double stoppingDelayThreshold = 0;
-                if(vehType == "bicycle")
-                    stoppingDelayThreshold = speedThreshold_bike;
-                else
-                    stoppingDelayThreshold = speedThreshold_veh;
-
-                double speed = TraCI->vehicleGetSpeed(*rit);
-
-                if(speed <= stoppingDelayThreshold)
-                {
-                    if(queueSizeLimit == -1 || (queueSizeLimit != -1 && queuedVehs.size() < (unsigned int)queueSizeLimit))
-                    {
-                        vehInfo_t entry = {*rit, vehType};
-                        queuedVehs.push_back(entry);
-                    }
-                }
-
-                vehCount++;
-                continue;
             }
+            else
+            {
+                // get the leading vehicle
+                auto leader = TraCI->vehicleGetLeader(SUMOID, 10000);
 
-            // get the leading vehicle
-            auto leader = TraCI->vehicleGetLeader(*rit, 10000);
-
-            if(leader.distance2Leader > 10)
-                break;
-
-            std::string vehType = TraCI->vehicleGetTypeID(*rit);
+                if(leader.distance2Leader > 10)
+                    break;
+            }
 
             double stoppingDelayThreshold = 0;
-            if(vehType == "bicycle")
+            if(vehicleType(index) == "bicycle")
                 stoppingDelayThreshold = speedThreshold_bike;
             else
                 stoppingDelayThreshold = speedThreshold_veh;
 
-            double speed = TraCI->vehicleGetSpeed(*rit);
+            double speed = TraCI->vehicleGetSpeed(SUMOID);
 
             if(speed <= stoppingDelayThreshold)
             {
-                if(queueSizeLimit == -1 || (queueSizeLimit != -1 && queuedVehs.size() < (unsigned int)queueSizeLimit))
+                if(queueSizeLimit == -1 || (queueSizeLimit != -1 && queue.vehs.size() < (unsigned int)queueSizeLimit))
                 {
-                    vehInfo_t entry = {*rit, vehType};
-                    queuedVehs.push_back(entry);
+                    queue.vehs.push_back(index);
+                    queue.members.insert(index);
+
+                    int vehClass = vehTable[index].vehClass;
+                    if((int)queue.classCount.size() <= vehClass)
+                        queue.classCount.resize(vehClass + 1, 0);
+                    queue.classCount[vehClass]++;
                 }
             }
 
@@ -263,8 +278,95 @@ void IntersectionQueue::updateQueuePerLane()
         }
 
         // update queue size in laneQueueSize
-        location->second.queueSize = queuedVehs.size();
+        queue.queueSize = queue.vehs.size();
+    }
+
+    releaseVehicles(firstScan);
+}
+
+
+int IntersectionQueue::vehicleIndex(const std::string &SUMOID)
+{
+    auto it = vehTableIndex.find(SUMOID);
+    if(it != vehTableIndex.end())
+        return it->second;
+
+    int index;
+    if(freeSlots.empty())
+    {
+        index = vehTable.size();
+        vehTable.push_back({SUMOID, "", -1, 0, -1});
+    }
+    else
+    {
+        index = freeSlots.back();
+        freeSlots.pop_back();
+
+        vehTable[index].id = SUMOID;
     }
+
+    vehTableIndex[SUMOID] = index;
+
+    return index;
+}
+
+
+int IntersectionQueue::vehicleGetIndex(const std::string &SUMOID) const
+{
+    auto it = vehTableIndex.find(SUMOID);
+    if(it == vehTableIndex.end())
+        return -1;
+
+    return it->second;
+}
+
+
+// vehicles that are not found by the lane scans of this time step are not on any
+// incoming lane. They are already removed from the queues, so their slots are free
+void IntersectionQueue::releaseVehicles(uint64_t firstScan)
+{
+    for(auto it = vehTableIndex.begin(); it != vehTableIndex.end(); )
+    {
+        int index = it->second;
+        vehInfo_t &veh = vehTable[index];
+
+        if(veh.lastSeen >= firstScan)
+        {
+            ++it;
+            continue;
+        }
+
+        veh.id.clear();
+        veh.type.clear();
+        veh.vehClass = -1;
+        veh.lastSeen = 0;
+        veh.lane = -1;
+        freeSlots.push_back(index);
+
+        it = vehTableIndex.erase(it);
+    }
+}
+
+
+// the type of a vehicle does not change, so we ask SUMO only once
+const std::string & IntersectionQueue::vehicleType(int index)
+{
+    vehInfo_t &veh = vehTable[index];
+    if(veh.type.empty())
+    {
+        veh.type = TraCI->vehicleGetTypeID(veh.id);
+
+        auto it = vehClassIndex.find(veh.type);
+        if(it == vehClassIndex.end())
+        {
+            it = vehClassIndex.insert(std::make_pair(veh.type, (int)vehClasses.size())).first;
+            vehClasses.push_back(veh.type);
+        }
+
+        veh.vehClass = it->second;
+    }
+
+    return veh.type;
 }
 
 
@@ -327,7 +429,7 @@ void IntersectionQueue::updateQueuePerTL()
 
 
 
-queueInfoLane_t IntersectionQueue::laneGetQueue(std::string laneID)
+const queueInfoLane_t & IntersectionQueue::laneGetQueue(const std::string &laneID)
 {
     auto it = queueInfo_perLane.find(laneID);
     if(it == queueInfo_perLane.end())
@@ -337,7 +439,7 @@ queueInfoLane_t IntersectionQueue::laneGetQueue(std::string laneID)
 }
 
 
-queueInfoTL_t IntersectionQueue::TLGetQueue(std::string TLid)
+const queueInfoTL_t & IntersectionQueue::TLGetQueue(const std::string &TLid)
 {
     auto it = queueInfo_perTL.find(TLid);
     if(it == queueInfo_perTL.end())
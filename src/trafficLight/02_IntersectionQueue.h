@@ -30,6 +30,8 @@
 
 #include <boost/circular_buffer.hpp>
 #include <unordered_map>
+#include <unordered_set>
+#include <deque>
 
 #include "trafficLight/01_Base.h"
 
@@ -38,14 +40,19 @@ namespace VENTOS {
 struct vehInfo_t
 {
     std::string id;
-    std::string type;
+    std::string type;       // empty until it is needed
+    int vehClass;           // index of 'type' in IntersectionQueue::vehClasses, -1 until the type is known
+    uint64_t lastSeen;      // last lane scan that found this vehicle (see IntersectionQueue::updateQueuePerLane)
+    int lane;               // incoming lane of the vehicle in the last time step (see IntersectionQueue::incomingLaneName)
 };
 
 struct queueInfoLane_t
 {
     std::string TLid;
     int queueSize;
-    std::vector<vehInfo_t> vehs;
+    std::deque<int> vehs;               // queued vehicles in the order they joined the queue (see IntersectionQueue::queuedVehicle)
+    std::unordered_set<int> members;    // the same vehicles, for look-ups
+    std::vector<int> classCount;        // number of queued vehicles per class (see IntersectionQueue::vehicleClassName)
 };
 
 struct queueInfoTL_t
@@ -79,29 +86,67 @@ private:
     // all incoming lanes in all traffic lights
     std::unordered_map<std::string /*lane*/, std::string /*TLid*/> incomingLanes;
 
+    // the same lanes and their index in the lane subscription (see TraCI_Commands::laneSubscribe)
+    std::vector<std::pair<std::string /*lane*/, int /*lane state index*/>> subscribedLanes;
+
+    // vehicles on each of subscribedLanes in the last time step, from the end of the
+    // lane to the intersection
+    std::vector<std::vector<int>> vehsPerLane;
+
     // real-time queue info for each incoming lane in each intersection
     std::unordered_map<std::string /*lane*/, queueInfoLane_t> queueInfo_perLane;
 
     // queue info for each TL over time
     std::map<std::string /*TLid*/, std::vector<queueInfoTL_t>> queueInfo_perTL;
 
+    // every vehicle on an incoming lane gets a fixed index into vehTable. The index stays
+    // valid while the vehicle is on an incoming lane. Once it leaves all incoming lanes
+    // (and hence all queues), the slot is put in freeSlots and reused by the next vehicle
+    std::vector<vehInfo_t> vehTable;
+    std::unordered_map<std::string /*SUMOID*/, int> vehTableIndex;
+    std::vector<int> freeSlots;
+    uint64_t laneScan = 0;
+
+    // vehicle types seen so far. A type gets a fixed class index when it is first seen
+    std::vector<std::string> vehClasses;
+    std::unordered_map<std::string /*type*/, int> vehClassIndex;
+
 public:
     virtual ~IntersectionQueue();
     virtual void initialize(int);
     virtual void finish();
     virtual void handleMessage(omnetpp::cMessage *);
 
-    // public methods accessible by other classes
-    queueInfoLane_t laneGetQueue(std::string);
-    queueInfoTL_t TLGetQueue(std::string);
+    // public methods accessible by other classes. The references
+    // stay valid until the next time step
+    const queueInfoLane_t & laneGetQueue(const std::string &);
+    const queueInfoTL_t & TLGetQueue(const std::string &);
+    const vehInfo_t & queuedVehicle(int index) const { return vehTable[index]; }
+    int vehicleClassCount() const { return vehClasses.size(); }
+    const std::string & vehicleClassName(int vehClass) const { return vehClasses[vehClass]; }
+
+    // incoming lanes (side walks are not included) and the vehicles on them in the last
+    // time step. Vehicles are indices for queuedVehicle
+    int incomingLaneCount() const { return subscribedLanes.size(); }
+    const std::string & incomingLaneName(int lane) const { return subscribedLanes[lane].first; }
+    const std::vector<int> & incomingLaneVehicles(int lane) const { return vehsPerLane[lane]; }
+    // returns -1 if the vehicle is not on any incoming lane
+    int vehicleGetIndex(const std::string &SUMOID) const;
 
 protected:
+    // the vehicles on the incoming lanes are tracked if the queue or the delay (see IntersectionDelay) is recorded
+    bool trackIncomingLanes = false;
+
+
     void virtual initialize_withTraCI();
     void virtual executeEachTimeStep();
 
 private:
     void initVariables();
     void updateQueuePerLane();
+    int vehicleIndex(const std::string &SUMOID);
+    void releaseVehicles(uint64_t firstScan);
+    const std::string & vehicleType(int index);
     void updateQueuePerTL();
     void saveTLQueueingData();
 };
@@ -94,6 +94,13 @@ void IntersectionDemand::executeEachTimeStep()
 
 void IntersectionDemand::initVariables()
 {
+    if(TDalpha >= 0)
+    {
+        TDdecay.assign(trafficDemandBuffSize + 1, 1.);
+        for(int n = 1; n <= trafficDemandBuffSize; n++)
+            TDdecay[n] = TDdecay[n-1] * (1 - TDalpha);
+    }
+
     // for each traffic light
     for (auto &TLid : TLList)
     {
@@ -104,51 +111,58 @@ void IntersectionDemand::initVariables()
         sort( lan.begin(), lan.end() );
         lan.erase( unique( lan.begin(), lan.end() ), lan.end() );
 
-        std::vector<std::string> sideWalkList;
-
         // for each incoming lane
         for(auto &lane : lan)
         {
-            incomingLanes[lane] = TLid;
-
-            // store all bike lanes and side walks
+            // ignore side walks
             auto allowedClasses = TraCI->laneGetAllowedClasses(lane);
             if(allowedClasses.size() == 1 && allowedClasses.front() == "pedestrian")
-                sideWalkList.push_back(lane);
-
-            boost::circular_buffer<std::vector<double>> CB; // create a circular buffer
-            CB.set_capacity(trafficDemandBuffSize);         // set max capacity
-            CB.clear();
-            TD_perLane[lane] = std::make_pair(TLid, CB);    // initialize laneTD
-
-            // initialize laneTotalVehCount
-            laneVehInfo_t entry = {};
-
-            entry.firstArrivalTime = -1;
-            entry.lastArrivalTime = -1;
-            entry.totalVehCount = 0;
+                continue;
 
-            laneTotalVehCount.insert( std::make_pair(lane, std::make_pair(TLid, entry)) );
+            demandLane_t entry;
+
+            entry.lane = lane;
+            entry.TLid = TLid;
+            entry.LDindex = -1;
+            entry.LDPos = 0;
+            entry.lastDetection = -1;
+            entry.vehInfo.firstArrivalTime = -1;
+            entry.vehInfo.lastArrivalTime = -1;
+            entry.vehInfo.totalVehCount = 0;
+            entry.TD.set_capacity(trafficDemandBuffSize);
+            entry.TDave = {0, 0};
+
+            demandLaneIndex[lane] = demandLanes.size();
+            demandLanes.push_back(entry);
         }
 
-        sideWalks_perTL[TLid] = sideWalkList;
-
         // get all links controlled by this TL
         auto result = TraCI->TLGetControlledLinks(TLid);
 
+        std::vector<int> &linkIndex = demandLinkIndex[TLid];
+        linkIndex.assign(result.empty() ? 0 : result.rbegin()->first + 1, -1);
+
         // for each link in this TLid
         for(auto &it : result)
         {
             int linkNumber = it.first;
-            std::vector<std::string> link = it.second;
-            std::string incommingLane = link[0];
+            std::string incommingLane = it.second[0];
 
-            boost::circular_buffer<std::vector<double>> CB;   // create a circular buffer
-            CB.set_capacity(trafficDemandBuffSize);           // set max capacity
-            CB.clear();
-            TD_perLink[std::make_pair(TLid,linkNumber)] = CB; // initialize linkTD
+            demandLink_t entry;
 
-            outgoingLinks_perLane.insert( std::make_pair(incommingLane, std::make_pair(TLid,linkNumber)) );
+            entry.TLid = TLid;
+            entry.linkNumber = linkNumber;
+            entry.TD.set_capacity(trafficDemandBuffSize);
+            entry.TDave = {0, 0};
+
+            auto loc = demandLaneIndex.find(incommingLane);
+            entry.lane = (loc == demandLaneIndex.end()) ? -1 : loc->second;
+
+            if(entry.lane != -1)
+                demandLanes[entry.lane].links.push_back(demandLinks.size());
+
+            linkIndex[linkNumber] = demandLinks.size();
+            demandLinks.push_back(entry);
         }
     }
 }
@@ -159,38 +173,40 @@ void IntersectionDemand::checkLoopDetectors()
     // get all loop detectors
     auto str = TraCI->LDGetIDList();
 
+    // demand LDs are read from the loop detector subscription
+    TraCI->LDSubscribe();
+
+    int LDcount = 0;
+
     // for each loop detector
     for (auto &it : str)
     {
+        if( std::string(it).find("demand_") == std::string::npos )
+            continue;
+
         std::string lane = TraCI->LDGetLaneID(it);
 
-        if( std::string(it).find("demand_") != std::string::npos )
-            LD_demand[lane] = std::make_pair(it,-1);
+        auto loc = demandLaneIndex.find(lane);
+        if(loc == demandLaneIndex.end())
+            continue;
+
+        // the position of the LD does not change, so we ask SUMO only once
+        demandLane_t &entry = demandLanes[loc->second];
+        entry.LDid = it;
+        entry.LDindex = TraCI->LDGetIndex(it);
+        entry.LDPos = TraCI->laneGetLength(lane) - TraCI->LDGetPosition(it);
+
+        LDcount++;
     }
 
     if(str.size() > 0)
-        LOG_INFO << boost::format(">>> %1%/%2% loop detectors are used for measuring traffic demand. \n") % LD_demand.size() % str.size() << std::flush;
+        LOG_INFO << boost::format(">>> %1%/%2% loop detectors are used for measuring traffic demand. \n") % LDcount % str.size() << std::flush;
 
-    // make sure we have all detectors we need
-    for (auto &TLid : TLList)
+    // if we are measuring traffic demand using loop detectors then make sure we have an LD on each lane
+    for (auto &entry : demandLanes)
     {
-        auto lan = TraCI->TLGetControlledLanes(TLid);
-
-        // remove duplicate entries
-        sort( lan.begin(), lan.end() );
-        lan.erase( unique( lan.begin(), lan.end() ), lan.end() );
-
-        // for each incoming lane
-        for(auto &lane : lan)
-        {
-            // ignore side walk
-            if( std::find(sideWalks_perTL[TLid].begin(), sideWalks_perTL[TLid].end(), lane) != sideWalks_perTL[TLid].end() )
-                continue;
-
-            // if we are measuring traffic demand using loop detectors then make sure we have an LD on each lane
-            if(LD_demand.find(lane) == LD_demand.end() )
-                LOG_WARNING << boost::format("WARNING: no loop detector found on lane (%1%). No traffic demand measurement is available for this lane. \n") % lane;
-        }
+        if(entry.LDid == "")
+            LOG_WARNING << boost::format("WARNING: no loop detector found on lane (%1%). No traffic demand measurement is available for this lane. \n") % entry.lane;
     }
 }
 
@@ -198,30 +214,21 @@ void IntersectionDemand::checkLoopDetectors()
 void IntersectionDemand::measureTrafficDemand()
 {
     // for each 'lane i' that is controlled by traffic light j
-    for(auto &y : incomingLanes)
+    for(auto &entry : demandLanes)
     {
-        std::string lane = y.first;
-        std::string TLid = y.second;
-
-        // ignore side walk
-        if( std::find(sideWalks_perTL[TLid].begin(), sideWalks_perTL[TLid].end(), lane) != sideWalks_perTL[TLid].end() )
-            continue;
-
         // make sure we have a demand loop detector in this lane
-        auto loc = LD_demand.find(lane);
-        if( loc == LD_demand.end() )
+        if(entry.LDindex == -1)
             continue;
 
-        std::string LDid = loc->second.first;
-        double lastDetection_old = loc->second.second;   // lastDetection_old is one step behind lastDetection
-        double lastDetection = TraCI->LDGetElapsedTimeLastDetection(LDid);
+        const LDState_t &LDstate = TraCI->LDGetState(entry.LDindex);
+
+        double lastDetection_old = entry.lastDetection;   // lastDetection_old is one step behind lastDetection
+        double lastDetection = LDstate.elapsedTime;
 
         // lastDetection == 0        if a vehicle is above the LD
         // lastDetection_old != 0    if this is the first detection for this vehicle (we ignore any subsequent detections for the same vehicle)
         if(lastDetection == 0 && lastDetection_old != 0)
         {
-            double TD = 0;
-
             // traffic measurement is done by measuring headway time between each two consecutive vehicles
             if(trafficDemandMode == 1)
             {
@@ -231,61 +238,112 @@ void IntersectionDemand::measureTrafficDemand()
                 if(diff > 0.0001)
                 {
                     // calculate the instantaneous traffic demand
-                    TD = 3600. / lastDetection_old;
+                    double TD = 3600. / lastDetection_old;
 
                     // bound TD
                     TD = std::min(TD, saturationTD);
 
                     // calculate lagT: when the measured TD will be effective?
                     // measured TD does not represent the condition in the intersection, and is effective after lagT
-                    double LDPos = TraCI->laneGetLength(lane) - TraCI->LDGetPosition(LDid);  // get position of the LD from end of lane
-                    double approachSpeed = TraCI->LDGetLastStepMeanVehicleSpeed(LDid);
-                    double lagT = std::fabs(LDPos) / approachSpeed;
-
-                    // push it into the circular buffer
-                    auto loc = TD_perLane.find(lane);
-                    std::vector<double> entry {TD /*traffic demand*/, omnetpp::simTime().dbl() /*time of measure*/, lagT /*time it takes to arrive at intersection*/};
-                    (loc->second).second.push_back(entry);
-
-                    // iterate over outgoing links
-                    auto ppp = outgoingLinks_perLane.equal_range(lane);
-                    for(std::multimap<std::string, std::pair<std::string, int>>::iterator z = ppp.first; z != ppp.second; ++z)
-                    {
-                        int linkNumber = (*z).second.second;
-
-                        // push the new TD into the circular buffer
-                        auto location = TD_perLink.find( make_pair(TLid,linkNumber) );
-                        std::vector<double> entry {TD /*traffic demand*/, omnetpp::simTime().dbl() /*time of measure*/, lagT /*time it takes to arrive at intersection*/};
-                        (location->second).push_back(entry);
-                    }
+                    double approachSpeed = LDstate.meanSpeed;
+                    double lagT = std::fabs(entry.LDPos) / approachSpeed;
+
+                    pushTD(entry, {TD /*traffic demand*/, omnetpp::simTime().dbl() /*time of measure*/, lagT /*time it takes to arrive at intersection*/});
                 }
             }
             // traffic demand measurement is done by counting total # of passed vehicles in interval
             // Note that updating laneTD and laneLinks is done at the beginning of each cycle at updateTLstate method
             else if(trafficDemandMode == 2)
             {
-                auto u = laneTotalVehCount.find(lane);
-
-                if(u == laneTotalVehCount.end())
-                    throw omnetpp::cRuntimeError("lane %s does not exist in laneTotalVehCount", lane.c_str());
-
-                (*u).second.second.totalVehCount = (*u).second.second.totalVehCount + 1;
+                entry.vehInfo.totalVehCount++;
 
                 // if this is the first vehicle on this lane
-                if((*u).second.second.totalVehCount == 1)
-                    (*u).second.second.firstArrivalTime = omnetpp::simTime().dbl();
+                if(entry.vehInfo.totalVehCount == 1)
+                    entry.vehInfo.firstArrivalTime = omnetpp::simTime().dbl();
 
                 // last detection time
-                (*u).second.second.lastArrivalTime = omnetpp::simTime().dbl();
+                entry.vehInfo.lastArrivalTime = omnetpp::simTime().dbl();
             }
         }
 
         // update lastDetection in this LD
-        loc->second.second = lastDetection;
+        entry.lastDetection = lastDetection;
     }
 }
 
 
+// push a new TD into the circular buffer of this lane and of its outgoing links
+void IntersectionDemand::pushTD(demandLane_t &entry, const TDSample_t &sample)
+{
+    pushSample(entry.TD, entry.TDave, sample);
+
+    for(int link : entry.links)
+        pushSample(demandLinks[link].TD, demandLinks[link].TDave, sample);
+}
+
+
+void IntersectionDemand::pushSample(TDBuffer_t &buffer, TDAverage_t &ave, const TDSample_t &sample)
+{
+    if(TDalpha < 0 || buffer.capacity() == 0)
+    {
+        buffer.push_back(sample);
+        return;
+    }
+
+    // the oldest sample leaves the buffer
+    if(buffer.full())
+        ave.weighted -= TDalpha * TDdecay[buffer.size()-1] * buffer.front().td;
+
+    ave.weighted = TDalpha * sample.td + (1 - TDalpha) * ave.weighted;
+    buffer.push_back(sample);
+
+    // recalculate the sum once per buffer length to drop the rounding errors of the subtractions
+    if(++ave.pushCount >= (int)buffer.capacity())
+    {
+        ave.weighted = 0;
+        for(auto &it : buffer)
+            ave.weighted = TDalpha * it.td + (1 - TDalpha) * ave.weighted;
+
+        ave.pushCount = 0;
+    }
+}
+
+
+// returns the 'exponential moving average' of TD in buffer in O(1)
+double IntersectionDemand::getAverageTD(const TDBuffer_t &buffer, const TDAverage_t &ave) const
+{
+    if(buffer.empty())
+        return 0;
+
+    if(TDalpha < 0)
+        throw omnetpp::cRuntimeError("moving average of traffic demand is not maintained (TDalpha is not set)");
+
+    // the oldest sample is the starting value of the average
+    return ave.weighted + TDdecay[buffer.size()] * buffer.front().td;
+}
+
+
+const TDBuffer_t & IntersectionDemand::linkGetTD(const std::string &TLid, int linkNumber) const
+{
+    int index = linkGetIndex(TLid, linkNumber);
+    if(index == -1)
+        return emptyTD;
+
+    return demandLinks[index].TD;
+}
+
+
+// returns the index of the link into demandLinks, or -1 if the link is not known
+int IntersectionDemand::linkGetIndex(const std::string &TLid, int linkNumber) const
+{
+    auto it = demandLinkIndex.find(TLid);
+    if(it == demandLinkIndex.end() || linkNumber < 0 || linkNumber >= (int)it->second.size())
+        return -1;
+
+    return it->second[linkNumber];
+}
+
+
 // update traffic demand for each lane at the beginning of each cycle
 // this method is called only when measureTrafficDemandMode == 2
 void IntersectionDemand::updateTrafficDemand()
@@ -293,18 +351,13 @@ void IntersectionDemand::updateTrafficDemand()
     if(!record_trafficDemand_stat || trafficDemandMode != 2)
         return;
 
-    for(auto & u : laneTotalVehCount)
+    for(auto &entry : demandLanes)
     {
-        std::string lane = u.first;
-        std::string TLid = u.second.first;
-
-        // ignore side walk
-        if( std::find(sideWalks_perTL[TLid].begin(), sideWalks_perTL[TLid].end(), lane) != sideWalks_perTL[TLid].end() )
-            continue;
+        laneVehInfo_t &vehInfo = entry.vehInfo;
 
-        double interval = u.second.second.lastArrivalTime - u.second.second.firstArrivalTime;
+        double interval = vehInfo.lastArrivalTime - vehInfo.firstArrivalTime;
 
-        double TD = (interval == 0) ? 0 : 3600. * ( (double)u.second.second.totalVehCount / interval );
+        double TD = (interval == 0) ? 0 : 3600. * ( (double)vehInfo.totalVehCount / interval );
 
         // bound TD
         TD = std::min(TD, saturationTD);
@@ -312,46 +365,23 @@ void IntersectionDemand::updateTrafficDemand()
         // if interval is too big then clear the buffer and restart!
         if(interval >= 200)
         {
-            u.second.second.totalVehCount = 0;
-            u.second.second.firstArrivalTime = omnetpp::simTime().dbl();
+            vehInfo.totalVehCount = 0;
+            vehInfo.firstArrivalTime = omnetpp::simTime().dbl();
 
-            // clear buffer for this lane in laneTD
-            const auto &loc = TD_perLane.find(lane);
-            (loc->second).second.clear();
-
-            // clear buffer for this lane in linkTD
-            const auto &ppp = outgoingLinks_perLane.equal_range(lane);
-            for(std::multimap<std::string, std::pair<std::string, int>>::iterator z = ppp.first; z != ppp.second; ++z)
+            // clear buffer for this lane and its outgoing links
+            entry.TD.clear();
+            entry.TDave = {0, 0};
+            for(int link : entry.links)
             {
-                int linkNumber = (*z).second.second;
-
-                // push the new TD into the circular buffer
-                const auto &location = TD_perLink.find( make_pair(TLid,linkNumber) );
-                (location->second).clear();
+                demandLinks[link].TD.clear();
+                demandLinks[link].TDave = {0, 0};
             }
 
-            LOG_DEBUG << boost::format("\n>>> Traffic demand measurement restarted for lane %1% \n") % lane << std::flush;
+            LOG_DEBUG << boost::format("\n>>> Traffic demand measurement restarted for lane %1% \n") % entry.lane << std::flush;
         }
 
         if(TD != 0)
-        {
-            // push it into the circular buffer
-            auto loc = TD_perLane.find(lane);
-            std::vector<double> entry {TD /*traffic demand*/, omnetpp::simTime().dbl() /*time of measure*/, -1};
-            (loc->second).second.push_back(entry);
-
-            // iterate over outgoing links
-            auto ppp = outgoingLinks_perLane.equal_range(lane);
-            for(std::multimap<std::string, std::pair<std::string, int>>::iterator z = ppp.first; z != ppp.second; ++z)
-            {
-                int linkNumber = (*z).second.second;
-
-                // push the new TD into the circular buffer
-                auto location = TD_perLink.find( make_pair(TLid,linkNumber) );
-                std::vector<double> entry {TD /*traffic demand*/, omnetpp::simTime().dbl() /*time of measure*/, -1};
-                (location->second).push_back(entry);
-            }
-        }
+            pushTD(entry, {TD /*traffic demand*/, omnetpp::simTime().dbl() /*time of measure*/, -1});
     }
 }
 
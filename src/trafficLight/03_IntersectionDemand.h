@@ -33,17 +33,72 @@
 
 namespace VENTOS {
 
+// one traffic demand measurement
+typedef struct TDSample
+{
+    double td;      // traffic demand (veh/h)
+    double time;    // time of measurement
+    double lag;     // time it takes to arrive at the intersection, -1 if not known
+} TDSample_t;
+
+// fixed-capacity ring buffer of measurements, oldest first
+typedef boost::circular_buffer<TDSample_t> TDBuffer_t;
+
+// running 'exponential moving average' of the measurements in a TDBuffer_t. It is
+// updated in O(1) as each measurement is pushed (or evicted), and reading it gives
+// the same value as folding the buffer from its oldest measurement
+typedef struct TDAverage
+{
+    double weighted;    // sum of alpha*(1-alpha)^age * td over the buffer
+    int pushCount;      // pushes since the last exact recalculation
+} TDAverage_t;
+
 class IntersectionDemand : public IntersectionQueue
 {
 protected:
-    // real-time traffic demand for each incoming lane for each intersection
-    std::unordered_map<std::string /*lane*/, std::pair<std::string /*TLid*/, boost::circular_buffer<std::vector<double>> /*TD*/>> TD_perLane;
+    typedef struct laneVehInfo
+    {
+        double firstArrivalTime;
+        double lastArrivalTime;
+        int totalVehCount;
+    } laneVehInfo_t;
+
+    // an incoming lane (side walks are not included)
+    typedef struct demandLane
+    {
+        std::string lane;
+        std::string TLid;
+        std::string LDid;       // demand loop detector on this lane, empty if there is none
+        int LDindex;            // index of the loop detector in TraCI, -1 if there is none
+        double LDPos;           // distance of the loop detector from the end of the lane
+        double lastDetection;   // elapsed time since the last detection in the previous time step
+        laneVehInfo_t vehInfo;  // used when trafficDemandMode == 2
+        std::vector<int> links; // outgoing links (indices into demandLinks)
+        TDBuffer_t TD;
+        TDAverage_t TDave;
+    } demandLane_t;
+
+    // a link controlled by a TL
+    typedef struct demandLink
+    {
+        std::string TLid;
+        int linkNumber;
+        int lane;               // index into demandLanes, -1 if the incoming lane is a side walk
+        TDBuffer_t TD;
+        TDAverage_t TDave;
+    } demandLink_t;
+
+    // real-time traffic demand for each incoming lane in each intersection
+    std::vector<demandLane_t> demandLanes;
 
     // real-time traffic demand for each link in each intersection
-    std::map<std::pair<std::string /*TLid*/, int /*link*/>, boost::circular_buffer<std::vector<double>> /*TD*/> TD_perLink;
+    std::vector<demandLink_t> demandLinks;
 
     double saturationTD;
 
+    // weight of the newest measurement in the moving average of TD, -1 if no average is needed
+    double TDalpha = -1;
+
 private:
     typedef IntersectionQueue super;
 
@@ -55,26 +110,14 @@ private:
     // list of all traffic lights in the network
     std::vector<std::string> TLList;
 
-    // list of all 'side walks' in each TL
-    std::unordered_map< std::string /*TLid*/, std::vector<std::string> > sideWalks_perTL;
-
-    // all incoming lanes in all traffic lights
-    std::unordered_map<std::string /*lane*/, std::string /*TLid*/> incomingLanes;
+    std::unordered_map<std::string /*lane*/, int /*index into demandLanes*/> demandLaneIndex;
+    std::unordered_map<std::string /*TLid*/, std::vector<int> /*index into demandLinks per link number*/> demandLinkIndex;
 
-    // all outgoing link # for each incoming lane
-    std::multimap<std::string /*lane*/, std::pair<std::string /*TLid*/, int /*link number*/>> outgoingLinks_perLane;
-
-    // loop detector ids used for measuring incoming traffic demand
-    std::unordered_map<std::string /*lane*/, std::pair<std::string /*LD id*/, double /*last actuation*/>> LD_demand;
-
-    typedef struct laneVehInfo
-    {
-        double firstArrivalTime;
-        double lastArrivalTime;
-        int totalVehCount;
-    } laneVehInfo_t;
+    // returned for links that are not known
+    TDBuffer_t emptyTD;
 
-    std::unordered_map<std::string /*lane*/, std::pair<std::string /*TLid*/, laneVehInfo_t> > laneTotalVehCount;
+    // (1-TDalpha)^n for n = 0 .. trafficDemandBuffSize
+    std::vector<double> TDdecay;
 
 public:
     virtual ~IntersectionDemand();
@@ -86,12 +129,16 @@ protected:
     void virtual initialize_withTraCI();
     void virtual executeEachTimeStep();
     void updateTrafficDemand();
+    const TDBuffer_t & linkGetTD(const std::string &TLid, int linkNumber) const;
+    int linkGetIndex(const std::string &TLid, int linkNumber) const;
+    double getAverageTD(const TDBuffer_t &, const TDAverage_t &) const;
 
 private:
     void initVariables();
     void checkLoopDetectors();
     void measureTrafficDemand();
-    void saveTLQueueingData();
+    void pushTD(demandLane_t &, const TDSample_t &);
+    void pushSample(TDBuffer_t &, TDAverage_t &, const TDSample_t &);
 };
 
 }
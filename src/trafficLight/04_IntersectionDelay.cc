@@ -24,6 +24,8 @@
 // Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 //
 
+#include <algorithm>
+
 #include "trafficLight/04_IntersectionDelay.h"
 
 namespace VENTOS {
@@ -33,14 +35,16 @@ Define_Module(VENTOS::IntersectionDelay);
 
 IntersectionDelay::~IntersectionDelay()
 {
-    for(auto &item : vehDelay_perTL)
-        for(auto &item2 : item.second)
-            delete item2;
+
 }
 
 
 void IntersectionDelay::initialize(int stage)
 {
+    // vehicles on the incoming lanes are taken from the lane tracker of IntersectionQueue
+    if(par("record_intersectionDelay_stat").boolValue())
+        trackIncomingLanes = true;
+
     super::initialize(stage);
 
     if(stage == 0)
@@ -86,21 +90,17 @@ void IntersectionDelay::receiveSignal(omnetpp::cComponent *source, omnetpp::sims
 
     if(signalID == Signal_arrived_vehs)
     {
-        // remove the arrived vehicle entry from the map
-        auto it = vehDelay_perTL.find(SUMOID);
-        if(it != vehDelay_perTL.end())
+        // the entries of the arrived vehicle can not change anymore
+        auto it = vehActiveDelays.find(SUMOID);
+        if(it != vehActiveDelays.end())
         {
-            for(auto &e : it->second)
-            {
-                e->lastSpeeds.clear();
-                e->lastSpeeds2.clear();
-                e->lastAccels.clear();
-                e->lastSignals.clear();
+            std::vector<int> slots = it->second;
+            for(int slot : slots)
+                releaseDelay(slot);
 
-                delete e;
-            }
-
-            vehDelay_perTL.erase(it);
+            activeDelays.erase(std::remove_if(activeDelays.begin(), activeDelays.end(), [this](int slot) {
+                return delayPool[slot].vehID.empty();
+            }), activeDelays.end());
         }
     }
 }
@@ -117,20 +117,20 @@ void IntersectionDelay::initialize_withTraCI()
         if(TLList.empty())
             LOG_INFO << ">>> WARNING: no traffic light found in the network. \n" << std::flush;
 
-        // for each traffic light
-        for (auto &TLid : TLList)
-        {
-            // get all incoming lanes
-            auto lan = TraCI->TLGetControlledLanes(TLid);
+        // the lane tracker does not include side walks
+        for(int lane = 0; lane < incomingLaneCount(); lane++)
+            approachLanes.push_back(std::make_pair(lane, laneGetQueue(incomingLaneName(lane)).TLid));
 
-            // remove duplicate entries
-            sort( lan.begin(), lan.end() );
-            lan.erase( unique( lan.begin(), lan.end() ), lan.end() );
+        // get simulation time step in seconds
+        double TS = (double)TraCI->simulationGetDelta() / 1000.;
 
-            // for each incoming lane
-            for(auto &it2 : lan)
-                incomingLanes[it2] = TLid;
-        }
+        // how much further we need to look at speed/accel/signal data
+        buffSize = std::floor(1. / TS);
+
+        // buffer size cannot be lower than 1
+        buffSize = std::max(1, buffSize);
+
+        partFile.open("vehDelay.txt");
     }
 }
 
@@ -149,92 +149,87 @@ void IntersectionDelay::executeEachTimeStep()
 }
 
 
+// only vehicles on the incoming lanes, and vehicles that are still accelerating
+// after crossing the intersection, are visited. The vehicles on the incoming lanes
+// come from the lane scan of IntersectionQueue in this time step
 void IntersectionDelay::vehiclesDelay()
 {
-    // iterate over all vehicles in the network
-    for(auto vID : TraCI->vehicleGetIDList())
+    // look for vehicles that approach an intersection
+    for(auto &y : approachLanes)
     {
-        // look for the vehicle
-        auto loc = vehDelay_perTL.find(vID);
+        const std::string &TLid = y.second;
 
-        if(loc == vehDelay_perTL.end())
+        for(int v : incomingLaneVehicles(y.first))
         {
-            auto TL = TraCI->vehicleGetNextTLS(vID);
-
-            // get the id of the next TL
-            std::string TLid = "";
-            if(!TL.empty())
-                TLid = TL[0].TLS_id;
-
-            // there is no TL ahead of this vehicle
-            if(TLid == "")
-                continue;
-
-            delayEntry_t *entry = generateEmptyDelay(vID, TLid);
-            std::vector<delayEntry_t *> thisIntersection = {entry};
-
-            auto r = vehDelay_perTL.insert(std::make_pair(vID,thisIntersection));
+            const std::string &vID = queuedVehicle(v).id;
 
-            vehiclesDelayStart(vID, r.first->second.back());
-            vehiclesDelayDuration(vID, r.first->second.back());
-        }
-        else
-        {
-            // if the vehicle crossed the intersection
-            if(loc->second.back()->crossed)
+            auto loc = vehActiveDelays.find(vID);
+            if(loc != vehActiveDelays.end())
             {
-                // keep checking the next TL along the way
-                // and add it if a new TL appears (ex. re-routing)
-                auto TL = TraCI->vehicleGetNextTLS(vID);
-
-                // get the id of the next TL
-                std::string TLid = "";
-                if(!TL.empty())
-                    TLid = TL[0].TLS_id;
-
-                // check if TLid has changed
-                if(TLid != "" && loc->second.back()->TLid != TLid)
+                bool found = false;
+                for(int slot : loc->second)
                 {
-                    delayEntry_t *entry = generateEmptyDelay(vID, TLid);
-                    loc->second.push_back(entry);
+                    if(delayPool[slot].TLid == TLid)
+                    {
+                        found = true;
+                        break;
+                    }
                 }
-            }
 
-            for(int index = loc->second.size()-1; index >= 0; index--)
-            {
-                // keep measuring delay as long as endDelay is unknown!
-                if(loc->second[index]->endDelay == -1)
-                {
-                    vehiclesDelayStart(vID, loc->second[index]);
-                    vehiclesDelayDuration(vID, loc->second[index]);
-                }
+                if(found)
+                    continue;
             }
+
+            generateEmptyDelay(vID, TLid);
         }
     }
-}
 
-
-void IntersectionDelay::vehiclesDelayStart(std::string vID, delayEntry_t *vehDelay)
-{
-    // wait for the vehicle to enter into an incoming lane
-    if(!vehDelay->onIncomingLane)
+    // keep measuring delay as long as the entry is not finished
+    for(int slot : activeDelays)
     {
-        // get current lane
-        std::string currentLane = TraCI->vehicleGetLaneID(vID);
+        delayEntry_t *vehDelay = &delayPool[slot];
 
-        // If not on one of the incoming lanes of this TL
-        auto itl = incomingLanes.find(currentLane);
-        if(itl == incomingLanes.end() || itl->second != vehDelay->TLid)
-            return;
+        vehiclesDelayStart(vehDelay->vehID, vehDelay);
+        vehiclesDelayDuration(vehDelay->vehID, vehDelay);
 
-        vehDelay->onIncomingLane = true;
+        if(vehDelay->endDelay != -1 || (vehDelay->crossed && vehDelay->startDeccel == -1))
+            vehDelay->finished = true;
     }
 
+    // write the finished entries to file and reuse their slots
+    auto newEnd = std::remove_if(activeDelays.begin(), activeDelays.end(), [this](int slot) {
+        if(!delayPool[slot].finished)
+            return false;
+
+        releaseDelay(slot);
+        return true;
+    });
+    activeDelays.erase(newEnd, activeDelays.end());
+}
+
+
+void IntersectionDelay::vehiclesDelayStart(std::string vID, delayEntry_t *vehDelay)
+{
+    // incoming lane of the vehicle, -1 if it is on none
+    int index = vehicleGetIndex(vID);
+    int lane = (index == -1) ? -1 : queuedVehicle(index).lane;
+
     // if the veh is on its last lane before the intersection
     if(vehDelay->lastLane == "")
     {
-        // get current lane
-        std::string currentLane = TraCI->vehicleGetLaneID(vID);
+        // the vehicle left the incoming lanes of this TL before reaching its last lane
+        if(lane == -1 || approachLanes[lane].second != vehDelay->TLid)
+        {
+            vehDelay->finished = true;
+            return;
+        }
+
+        // the best lanes are checked once per lane
+        if(lane == vehDelay->checkedLane)
+            return;
+
+        vehDelay->checkedLane = lane;
+        const std::string &currentLane = incomingLaneName(lane);
 
         // get best lanes for this vehicle
         auto best = TraCI->vehicleGetBestLanes(vID);
@@ -269,11 +264,8 @@ void IntersectionDelay::vehiclesDelayStart(std::string vID, delayEntry_t *vehDel
     // if we have not crossed the intersection yet
     if(!vehDelay->crossed)
     {
-        // get current lane
-        std::string currentLane = TraCI->vehicleGetLaneID(vID);
-
         // If we are at the middle of intersection
-        if(incomingLanes.find(currentLane) == incomingLanes.end())
+        if(lane == -1)
         {
             vehDelay->crossed = true;
             vehDelay->crossedTime = omnetpp::simTime().dbl();
@@ -451,7 +443,7 @@ void IntersectionDelay::vehiclesDelayDuration(std::string vID, delayEntry_t *veh
 }
 
 
-delayEntry_t* IntersectionDelay::generateEmptyDelay(std::string vID, std::string TLid)
+int IntersectionDelay::generateEmptyDelay(std::string vID, std::string TLid)
 {
     std::string vehType = TraCI->vehicleGetTypeID(vID);
 
@@ -461,12 +453,32 @@ delayEntry_t* IntersectionDelay::generateEmptyDelay(std::string vID, std::string
     else
         stoppingDelayThreshold = speedThreshold_veh;
 
-    delayEntry_t *entry = new delayEntry_t();
+    int slot;
+    if(freeSlots.empty())
+    {
+        slot = delayPool.size();
+        delayPool.emplace_back();
+
+        delayEntry_t &entry = delayPool.back();
+        entry.lastSpeeds.set_capacity(buffSize);
+        entry.lastSpeeds2.set_capacity(buffSize);
+        entry.lastAccels.set_capacity(buffSize);
+        entry.lastSignals.set_capacity(buffSize);
+    }
+    else
+    {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    }
+
+    delayEntry_t *entry = &delayPool[slot];
 
+    entry->vehID = vID;
     entry->TLid = TLid;
     entry->vehType = vehType;
-    entry->onIncomingLane = false;
+    entry->finished = false;
     entry->lastLane = "";
+    entry->checkedLane = -1;
     entry->intersectionEntrance = -1;
     entry->crossed = false;
     entry->crossedTime = -1;
@@ -478,66 +490,100 @@ delayEntry_t* IntersectionDelay::generateEmptyDelay(std::string vID, std::string
     entry->endDelay = -1;
     entry->decelDelay = 0;
     entry->waitingDelay = 0;
+    entry->accelDelay = 0;
     entry->totalDelay = 0;
 
-    // get simulation time step in seconds
-    double TS = (double)TraCI->simulationGetDelta() / 1000.;
+    entry->lastSpeeds.clear();
+    entry->lastSpeeds2.clear();
+    entry->lastAccels.clear();
+    entry->lastSignals.clear();
 
-    // how much further we need to look at speed/accel/signal data
-    int buffSize = std::floor(1. / TS);
+    activeDelays.push_back(slot);
+    vehActiveDelays[vID].push_back(slot);
 
-    // buffer size cannot be lower than 1
-    buffSize = std::max(1, buffSize);
+    return slot;
+}
 
-    boost::circular_buffer<std::pair<double,double>> CB_speed;  // create a circular buffer
-    CB_speed.set_capacity(buffSize);                            // set max capacity
-    CB_speed.clear();
-    entry->lastSpeeds = CB_speed;
 
-    boost::circular_buffer<std::pair<double,double>> CB_speed2;  // create a circular buffer
-    CB_speed2.set_capacity(buffSize);                            // set max capacity
-    CB_speed2.clear();
-    entry->lastSpeeds2 = CB_speed2;
+// writes the entry to file and returns its slot to the pool.
+// The caller removes the slot from activeDelays
+void IntersectionDelay::releaseDelay(int slot)
+{
+    delayEntry_t &entry = delayPool[slot];
 
-    boost::circular_buffer<std::pair<double,double>> CB_accel;  // create a circular buffer
-    CB_accel.set_capacity(buffSize);                            // set max capacity
-    CB_accel.clear();
-    entry->lastAccels = CB_accel;
+    writeDelay(entry);
 
-    boost::circular_buffer<char> CB_sig;   // create a circular buffer
-    CB_sig.set_capacity(buffSize);         // set max capacity
-    CB_sig.clear();
-    entry->lastSignals = CB_sig;
+    auto it = vehActiveDelays.find(entry.vehID);
+    if(it != vehActiveDelays.end())
+    {
+        it->second.erase(std::remove(it->second.begin(), it->second.end(), slot), it->second.end());
+        if(it->second.empty())
+            vehActiveDelays.erase(it);
+    }
 
-    return entry;
+    entry.vehID.clear();
+    freeSlots.push_back(slot);
 }
 
 
-delayEntry_t* IntersectionDelay::vehicleGetDelay(std::string vID, std::string TLid)
+const delayEntry_t* IntersectionDelay::vehicleGetDelay(const std::string &vID, const std::string &TLid)
 {
-    auto it = vehDelay_perTL.find(vID);
-    if(it == vehDelay_perTL.end())
+    auto it = vehActiveDelays.find(vID);
+    if(it == vehActiveDelays.end())
         return NULL;
 
-    // delay in each intersection that this vehicle has encountered so far
-    auto allDelays = it->second;
-
     // iterate from the last visited intersection
-    for(auto itt = allDelays.rbegin(); itt != allDelays.rend(); ++itt)
+    for(auto itt = it->second.rbegin(); itt != it->second.rend(); ++itt)
     {
-        if((*itt)->TLid == TLid)
-            return *itt;
+        if(delayPool[*itt].TLid == TLid)
+            return &delayPool[*itt];
     }
 
     return NULL;
 }
 
 
+void IntersectionDelay::writeDelay(const delayEntry_t &z)
+{
+    FILE *partFilePtr = partFile.get();
+    if(!partFilePtr)
+        return;
+
+    fprintf (partFilePtr, "%-25s", z.vehID.c_str());
+    fprintf (partFilePtr, "%-20s", z.vehType.c_str());
+    fprintf (partFilePtr, "%-50s", z.TLid.c_str());
+    fprintf (partFilePtr, "%-15.2f", z.crossedTime);
+    fprintf (partFilePtr, "%-15.2f", z.oldSpeed);
+    fprintf (partFilePtr, "%-15.2f", z.startDeccel);
+    fprintf (partFilePtr, "%-15.2f", z.startStopping);
+    fprintf (partFilePtr, "%-15.2f", z.startAccel);
+    fprintf (partFilePtr, "%-15.2f", z.endDelay);
+    fprintf (partFilePtr, "%-17.2f", z.decelDelay);
+    fprintf (partFilePtr, "%-17.2f", z.waitingDelay);
+    fprintf (partFilePtr, "%-17.2f", z.accelDelay);
+    fprintf (partFilePtr, "%-17.2f\n", z.totalDelay);
+
+    recordCount++;
+}
+
+
 void IntersectionDelay::vehiclesDelayToFile()
 {
-    if(vehDelay_perTL.empty())
+    if(!partFile.isOpen())
         return;
 
+    // entries that are still being measured
+    for(int slot : activeDelays)
+        releaseDelay(slot);
+
+    activeDelays.clear();
+
+    if(recordCount == 0)
+    {
+        partFile.discard();
+        return;
+    }
+
     int currentRun = omnetpp::getEnvir()->getConfigEx()->getActiveRunNumber();
 
     std::ostringstream fileName;
@@ -603,27 +649,7 @@ void IntersectionDelay::vehiclesDelayToFile()
     fprintf (filePtr, "%-17s \n\n","totalDelay");
 
     // write body
-    for(auto &y : vehDelay_perTL)
-    {
-        for(auto &z : y.second)
-        {
-            fprintf (filePtr, "%-25s", y.first.c_str());
-            fprintf (filePtr, "%-20s", z->vehType.c_str());
-            fprintf (filePtr, "%-50s", z->TLid.c_str());
-            fprintf (filePtr, "%-15.2f", z->crossedTime);
-            fprintf (filePtr, "%-15.2f", z->oldSpeed);
-            fprintf (filePtr, "%-15.2f", z->startDeccel);
-            fprintf (filePtr, "%-15.2f", z->startStopping);
-            fprintf (filePtr, "%-15.2f", z->startAccel);
-            fprintf (filePtr, "%-15.2f", z->endDelay);
-            fprintf (filePtr, "%-17.2f", z->decelDelay);
-            fprintf (filePtr, "%-17.2f", z->waitingDelay);
-            fprintf (filePtr, "%-17.2f", z->accelDelay);
-            fprintf (filePtr, "%-17.2f\n", z->totalDelay);
-        }
-
-        fprintf (filePtr, "\n");
-    }
+    partFile.appendTo(filePtr);
 
     fclose(filePtr);
 }
@@ -28,15 +28,18 @@
 #define INTERSECTIONDELAY_H
 
 #include "trafficLight/03_IntersectionDemand.h"
+#include "global/PartFile.h"
 
 namespace VENTOS {
 
 struct delayEntry_t
 {
+    std::string vehID;
     std::string TLid;
     std::string vehType;
-    bool onIncomingLane;
+    bool finished;          // no more delay can be measured for this entry
     std::string lastLane;
+    int checkedLane;        // incoming lane of the last vehicleGetBestLanes query, -1 if none
     double intersectionEntrance;
     bool crossed;
     double crossedTime;
@@ -76,11 +79,22 @@ private:
     // list of all traffic lights in the network
     std::vector<std::string> TLList;
 
-    // all incoming lanes in all traffic lights
-    std::unordered_map<std::string /*lane*/, std::string /*TLid*/> incomingLanes;
+    // incoming lanes that vehicles can use and their TL, indexed as in IntersectionQueue::incomingLaneName
+    std::vector<std::pair<int /*incoming lane*/, std::string /*TLid*/>> approachLanes;
 
-    // vehicle delay for each intersection that it crosses
-    std::map<std::string /*vehID*/, std::vector<delayEntry_t *>> vehDelay_perTL;
+    // delay entries are pooled. The slot of a finished entry is written to
+    // file and reused, which keeps the circular buffers allocated
+    std::vector<delayEntry_t> delayPool;
+    std::vector<int> freeSlots;
+    int buffSize = 1;
+
+    // slots that are being measured, and the same slots per vehicle
+    std::vector<int> activeDelays;
+    std::unordered_map<std::string /*vehID*/, std::vector<int>> vehActiveDelays;
+
+    // finished entries are written to this file as they finish
+    PartFile partFile;
+    uint64_t recordCount = 0;
 
 public:
     virtual ~IntersectionDelay();
@@ -89,7 +103,8 @@ public:
     virtual void handleMessage(omnetpp::cMessage *);
     virtual void receiveSignal(omnetpp::cComponent *, omnetpp::simsignal_t, const char *, cObject *);
 
-    delayEntry_t* vehicleGetDelay(std::string, std::string);
+    // the returned entry stays valid until the next time step
+    const delayEntry_t* vehicleGetDelay(const std::string &, const std::string &);
 
 protected:
     void virtual initialize_withTraCI();
@@ -99,7 +114,9 @@ private:
     void vehiclesDelay();
     void vehiclesDelayStart(std::string, delayEntry_t*);
     void vehiclesDelayDuration(std::string, delayEntry_t*);
-    delayEntry_t* generateEmptyDelay(std::string, std::string);
+    int generateEmptyDelay(std::string, std::string);
+    void releaseDelay(int slot);
+    void writeDelay(const delayEntry_t &);
     void vehiclesDelayToFile();
 };
 
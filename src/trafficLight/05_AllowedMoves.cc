@@ -24,8 +24,11 @@
 // Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 //
 
-#include <boost/graph/adjacency_list.hpp>
+#include <iomanip>
+#include <sstream>
 #include "trafficLight/05_AllowedMoves.h"
+#include "global/ScenarioSnapshot.h"
+#include "global/SumoNet.h"
 
 namespace VENTOS {
 
@@ -75,354 +78,242 @@ void TrafficLightAllowedMoves::executeEachTimeStep()
 
 std::vector<std::vector<int>>& TrafficLightAllowedMoves::getMovements(std::string TLid)
 {
-    // Get all links for this TL
-    auto allLinks = TraCI->TLGetControlledLinks(TLid);
-
-    LINKSIZE = allLinks.size();
-
-    if(LINKSIZE == 0)
-        throw omnetpp::cRuntimeError("LINKSIZE can not be zero for this TL!");
+    buildConflicts(TLid);
 
+    // the movements only depend on the conflict graph. Replications (and
+    // scenarios) with the same intersection share the cached result
     boost::filesystem::path dir (TraCI->getFullPath_SUMOConfig().parent_path());
-    movementsFilePath = dir / "allMovements.txt";
+    std::string key = conflictsKey();
+    ScenarioSnapshot cache(dir, "allMovements_" + key);
 
-    // check if this file exists?
-    if( boost::filesystem::exists( movementsFilePath ) )
+    if(cache.open(key))
     {
-        LOG_INFO << "\nReading movements from file ... " << std::flush;
-        FILE *filePtr = fopen (movementsFilePath.string().c_str(), "r");
-
-        std::vector<int> temp;
-        char c;
-        allMovements.clear();
+        snapshotReader reader = cache.getReader();
+        uint32_t rows = reader.get<uint32_t>();
 
-        while ((c = getc(filePtr)) != EOF)
+        allMovements.assign(rows, std::vector<int>(LINKSIZE));
+        for(auto &row : allMovements)
         {
-            if(c != '\n')
-            {
-                int val = c - '0';
-                temp.push_back(val);
-            }
-            else
-            {
-                allMovements.push_back(temp);
-                temp.clear();
-            }
+            uint64_t mask = reader.get<uint64_t>();
+            for(int j = 0; j < LINKSIZE; j++)
+                row[j] = (mask >> j) & 1;
         }
-
-        fclose(filePtr);
-        LOG_INFO << "Done! \n";
     }
     else
+    {
         generateAllAllowedMovements();
 
+        snapshotWriter writer;
+        writer.put<uint32_t>(allMovements.size());
+        for(auto &row : allMovements)
+        {
+            uint64_t mask = 0;
+            for(int j = 0; j < LINKSIZE; j++)
+                if(row[j])
+                    mask |= (uint64_t)1 << j;
+            writer.put<uint64_t>(mask);
+        }
+
+        cache.store(key, writer.getBuffer());
+    }
+
     if(allMovements.empty())
         throw omnetpp::cRuntimeError("allMovements vector is empty!");
 
-    if(omnetpp::cSimulation::getActiveEnvir()->isGUI() && debugLevel > 2)
+    if(omnetpp::cSimulation::getActiveEnvir()->isGUI() && debugLevel > 2 && LINKSIZE > 14)
         allMovementBatch(14);
 
     return allMovements;
 }
 
 
-// if allMovements.txt is not found then we should generate it.
-// this process is CPU-intensive and lengthy, but hopefully this
-// needs to be executed once to obtain allMovements.txt
-void TrafficLightAllowedMoves::generateAllAllowedMovements()
+// conflicts are taken from the junction logic of the net file. Two links are in
+// conflict if SUMO lists them as foes. Right turns (dir="r") are permissive and
+// do not conflict with anything. The TL link index is assumed to be the junction
+// link index, which is the case when the TL controls one junction with the same id.
+// TLs that are not in the net file are asked from SUMO (see defaultConflicts)
+void TrafficLightAllowedMoves::buildConflicts(std::string TLid)
 {
-    // Create a graph type
-    typedef boost::adjacency_list<boost::mapS /*OutEdgeList*/, boost::vecS /*VertexListS*/, boost::undirectedS /*graph type*/> Graph;
-
-    // Create the graph object
-    Graph conflictGraph(LINKSIZE);
-
-    /* these are the list of all movements in our intersection
-        Movements from north:
-        0: NW, bike
-        1: NS, bike
-        2: NW, veh
-        3: NS, veh
-        4: NE, veh
-
-        Movements from east:
-        5: EN, bike
-        6: EW, bike
-        7: EN, veh
-        8: EW, veh
-        9: ES, veh
-
-        Movements from south:
-        10: SE, bike
-        11: SN, bike
-        12: SE, veh
-        13: SN, veh
-        14: SW, veh
-
-        Movements from west:
-        15: WS, bike
-        16: WE, bike
-        17: WS, veh
-        18: WE, veh
-        19: WN, veh
-
-        Pedestrian crossings:
-        20: N
-        21: E
-        22: S
-        23: W
-     */
-
-    // Add edges for link 3 (vehNS)
-    add_edge(3, 8, conflictGraph);  // movement 3 (NS) and movement 8 (EW) are conflicting
-    add_edge(3, 9, conflictGraph);
-    add_edge(3, 14, conflictGraph);
-    add_edge(3, 18, conflictGraph);
-    add_edge(3, 19, conflictGraph);
-    add_edge(3, 6, conflictGraph);
-    add_edge(3, 16, conflictGraph);
-    add_edge(3, 20, conflictGraph);
-    add_edge(3, 22, conflictGraph);
-
-    // Add edges for link 4 (vehNE)
-    add_edge(4, 8, conflictGraph);
-    add_edge(4, 9, conflictGraph);
-    add_edge(4, 13, conflictGraph);
-    add_edge(4, 18, conflictGraph);
-    add_edge(4, 19, conflictGraph);
-    add_edge(4, 6, conflictGraph);
-    add_edge(4, 11, conflictGraph);
-    add_edge(4, 16, conflictGraph);
-    add_edge(4, 20, conflictGraph);
-    add_edge(4, 21, conflictGraph);
-
-    // Add edges for link 8 (vehEW)
-    add_edge(8, 3, conflictGraph);
-    add_edge(8, 4, conflictGraph);
-    add_edge(8, 13, conflictGraph);
-    add_edge(8, 14, conflictGraph);
-    add_edge(8, 19, conflictGraph);
-    add_edge(8, 1, conflictGraph);
-    add_edge(8, 11, conflictGraph);
-    add_edge(8, 21, conflictGraph);
-    add_edge(8, 23, conflictGraph);
-
-    // Add edges for link 9 (vehES)
-    add_edge(9, 3, conflictGraph);
-    add_edge(9, 4, conflictGraph);
-    add_edge(9, 13, conflictGraph);
-    add_edge(9, 14, conflictGraph);
-    add_edge(9, 18, conflictGraph);
-    add_edge(9, 1, conflictGraph);
-    add_edge(9, 11, conflictGraph);
-    add_edge(9, 16, conflictGraph);
-    add_edge(9, 21, conflictGraph);
-    add_edge(9, 22, conflictGraph);
-
-    // Add edges for link 13 (vehSN)
-    add_edge(13, 4, conflictGraph);
-    add_edge(13, 8, conflictGraph);
-    add_edge(13, 9, conflictGraph);
-    add_edge(13, 18, conflictGraph);
-    add_edge(13, 19, conflictGraph);
-    add_edge(13, 6, conflictGraph);
-    add_edge(13, 16, conflictGraph);
-    add_edge(13, 20, conflictGraph);
-    add_edge(13, 22, conflictGraph);
-
-    // Add edges for link 14 (vehSW)
-    add_edge(14, 3, conflictGraph);
-    add_edge(14, 8, conflictGraph);
-    add_edge(14, 9, conflictGraph);
-    add_edge(14, 18, conflictGraph);
-    add_edge(14, 19, conflictGraph);
-    add_edge(14, 1, conflictGraph);
-    add_edge(14, 6, conflictGraph);
-    add_edge(14, 16, conflictGraph);
-    add_edge(14, 22, conflictGraph);
-    add_edge(14, 23, conflictGraph);
-
-    // Add edges for link 18 (vehWE)
-    add_edge(18, 3, conflictGraph);
-    add_edge(18, 4, conflictGraph);
-    add_edge(18, 9, conflictGraph);
-    add_edge(18, 13, conflictGraph);
-    add_edge(18, 14, conflictGraph);
-    add_edge(18, 1, conflictGraph);
-    add_edge(18, 11, conflictGraph);
-    add_edge(18, 21, conflictGraph);
-    add_edge(18, 23, conflictGraph);
-
-    // Add edges for link 19 (vehWN)
-    add_edge(19, 3, conflictGraph);
-    add_edge(19, 4, conflictGraph);
-    add_edge(19, 8, conflictGraph);
-    add_edge(19, 13, conflictGraph);
-    add_edge(19, 14, conflictGraph);
-    add_edge(19, 1, conflictGraph);
-    add_edge(19, 6, conflictGraph);
-    add_edge(19, 11, conflictGraph);
-    add_edge(19, 20, conflictGraph);
-    add_edge(19, 23, conflictGraph);
-
-    // Add edges for link 1 (bikeNS)
-    add_edge(1, 8, conflictGraph);
-    add_edge(1, 9, conflictGraph);
-    add_edge(1, 14, conflictGraph);
-    add_edge(1, 18, conflictGraph);
-    add_edge(1, 19, conflictGraph);
-    add_edge(1, 6, conflictGraph);
-    add_edge(1, 16, conflictGraph);
-    add_edge(1, 20, conflictGraph);
-    add_edge(1, 22, conflictGraph);
-
-    // Add edges for link 6 (bikeEW)
-    add_edge(6, 3, conflictGraph);
-    add_edge(6, 4, conflictGraph);
-    add_edge(6, 13, conflictGraph);
-    add_edge(6, 14, conflictGraph);
-    add_edge(6, 19, conflictGraph);
-    add_edge(6, 1, conflictGraph);
-    add_edge(6, 11, conflictGraph);
-    add_edge(6, 21, conflictGraph);
-    add_edge(6, 23, conflictGraph);
-
-    // Add edges for link 11 (bikeSN)
-    add_edge(11, 4, conflictGraph);
-    add_edge(11, 8, conflictGraph);
-    add_edge(11, 9, conflictGraph);
-    add_edge(11, 18, conflictGraph);
-    add_edge(11, 19, conflictGraph);
-    add_edge(11, 6, conflictGraph);
-    add_edge(11, 16, conflictGraph);
-    add_edge(11, 20, conflictGraph);
-    add_edge(11, 22, conflictGraph);
-
-    // Add edges for link 16 (bikeWE)
-    add_edge(16, 3, conflictGraph);
-    add_edge(16, 4, conflictGraph);
-    add_edge(16, 9, conflictGraph);
-    add_edge(16, 13, conflictGraph);
-    add_edge(16, 14, conflictGraph);
-    add_edge(16, 1, conflictGraph);
-    add_edge(16, 11, conflictGraph);
-    add_edge(16, 21, conflictGraph);
-    add_edge(16, 23, conflictGraph);
-
-    // Add edges for link 20 (pedN)
-    add_edge(20, 3, conflictGraph);
-    add_edge(20, 4, conflictGraph);
-    add_edge(20, 13, conflictGraph);
-    add_edge(20, 19, conflictGraph);
-    add_edge(20, 1, conflictGraph);
-    add_edge(20, 11, conflictGraph);
-
-    // Add edges for link 21 (pedE)
-    add_edge(21, 4, conflictGraph);
-    add_edge(21, 8, conflictGraph);
-    add_edge(21, 9, conflictGraph);
-    add_edge(21, 18, conflictGraph);
-    add_edge(21, 6, conflictGraph);
-    add_edge(21, 16, conflictGraph);
-
-    // Add edges for link 22 (pedS)
-    add_edge(22, 3, conflictGraph);
-    add_edge(22, 9, conflictGraph);
-    add_edge(22, 13, conflictGraph);
-    add_edge(22, 14, conflictGraph);
-    add_edge(22, 1, conflictGraph);
-    add_edge(22, 11, conflictGraph);
-
-    // Add edges for link 23 (pedW)
-    add_edge(23, 8, conflictGraph);
-    add_edge(23, 14, conflictGraph);
-    add_edge(23, 18, conflictGraph);
-    add_edge(23, 19, conflictGraph);
-    add_edge(23, 6, conflictGraph);
-    add_edge(23, 16, conflictGraph);
-
-    LOG_INFO << "\nGenerating all possible non-conflicting movements (out of 2^" << LINKSIZE << ") ... " << std::flush;
-
-    // generate truth table from all links
-    // check here: http://stackoverflow.com/questions/3504642/generate-a-truth-table-given-an-input
-    std::vector< std::vector<int> > truthTable(LINKSIZE, std::vector<int>(1 << LINKSIZE));
-    unsigned num_to_fill = 1U << (LINKSIZE - 1);
-    for(int col = 0; col < LINKSIZE; ++col, num_to_fill >>= 1U)
+    std::shared_ptr<const SumoNet> model = TraCI->getNetModel();
+
+    int tl = model->getTLIndex(TLid);
+    if(tl == -1)
     {
-        for(unsigned row = num_to_fill; row < (1U << LINKSIZE); row += (num_to_fill * 2))
-            std::fill_n(&truthTable[col][row], num_to_fill, 1);
+        defaultConflicts(TLid);
+        return;
     }
 
-    std::vector<int> temp;
+    LINKSIZE = model->tlLogics[tl].linkCount;
 
-    // iterate over each row of the truth table (skip the first row which is all-zero)
-    for(int x = 1; x < (1 << LINKSIZE); ++x)   // row
+    if(LINKSIZE == 0)
+        throw omnetpp::cRuntimeError("LINKSIZE can not be zero for this TL!");
+
+    if(LINKSIZE > 64)
+        throw omnetpp::cRuntimeError("TL '%s' has %d links. At most 64 links are supported", TLid.c_str(), LINKSIZE);
+
+    int junction = model->getJunctionIndex(TLid);
+    if(junction == -1 || (int)model->junctions[junction].foes.size() != LINKSIZE)
+        throw omnetpp::cRuntimeError("Can not find the junction logic of TL '%s' in the net file", TLid.c_str());
+
+    rightTurnMask = 0;
+    for(auto &conn : model->connections)
+        if(conn.tl == tl && conn.dir == 'r' && conn.linkIndex >= 0 && conn.linkIndex < LINKSIZE)
+            rightTurnMask |= (uint64_t)1 << conn.linkIndex;
+
+    conflicts.assign(LINKSIZE, 0);
+    for(int i = 0; i < LINKSIZE; i++)
     {
-        bool conflictFound = false;
-        temp.clear();
+        const std::string &foes = model->junctions[junction].foes[i];
+        if((int)foes.size() != LINKSIZE)
+            throw omnetpp::cRuntimeError("Junction logic of TL '%s' is malformed", TLid.c_str());
 
-        for(int y = 0; y < LINKSIZE; ++y)  // column
+        for(int j = 0; j < LINKSIZE; j++)
         {
-            temp.push_back(truthTable[y][x]);
-
-            if( truthTable[y][x] != 1 )
+            if(i == j || isRightTurn(i) || isRightTurn(j))
                 continue;
 
-            for(int z=y+1; z < LINKSIZE; ++z)
+            // SUMO does not always list both directions (e.g. a bike lane
+            // and the vehicle lane next to it), so the graph is made undirected
+            if(foes[LINKSIZE - 1 - j] == '1')
             {
-                if( truthTable[z][x] != 1 )
-                    continue;
-
-                // check if link y and link z are in conflict
-                if( edge(y, z, conflictGraph).second )
-                {
-                    conflictFound = true;
-                    temp.clear();
-                    break;
-                }
+                conflicts[i] |= (uint64_t)1 << j;
+                conflicts[j] |= (uint64_t)1 << i;
             }
-
-            if(conflictFound)
-                break;
         }
+    }
+}
+
+
+// the number of links is asked from SUMO, and the conflicts are those of the
+// 24-link intersection (see allMovementBatch for the link names). This is what
+// was used for every TL before the junction logic was read from the net file
+void TrafficLightAllowedMoves::defaultConflicts(std::string TLid)
+{
+    LOG_WARNING << boost::format("WARNING: TL '%1%' is not found in the net file. Using the conflicts of the 24-link intersection. \n") % TLid << std::flush;
+
+    LINKSIZE = TraCI->TLGetControlledLinks(TLid).size();
+
+    if(LINKSIZE == 0)
+        throw omnetpp::cRuntimeError("LINKSIZE can not be zero for this TL!");
+
+    if(LINKSIZE > 64)
+        throw omnetpp::cRuntimeError("TL '%s' has %d links. At most 64 links are supported", TLid.c_str(), LINKSIZE);
+
+    static const std::map<int, std::vector<int>> conflictList =
+    {
+            {1, {8, 9, 14, 18, 19, 6, 16, 20, 22}},
+            {3, {8, 9, 14, 18, 19, 6, 16, 20, 22}},
+            {4, {8, 9, 13, 18, 19, 6, 11, 16, 20, 21}},
+            {6, {3, 4, 13, 14, 19, 1, 11, 21, 23}},
+            {8, {3, 4, 13, 14, 19, 1, 11, 21, 23}},
+            {9, {3, 4, 13, 14, 18, 1, 11, 16, 21, 22}},
+            {11, {4, 8, 9, 18, 19, 6, 16, 20, 22}},
+            {13, {4, 8, 9, 18, 19, 6, 16, 20, 22}},
+            {14, {3, 8, 9, 18, 19, 1, 6, 16, 22, 23}},
+            {16, {3, 4, 9, 13, 14, 1, 11, 21, 23}},
+            {18, {3, 4, 9, 13, 14, 1, 11, 21, 23}},
+            {19, {3, 4, 8, 13, 14, 1, 6, 11, 20, 23}},
+            {20, {3, 4, 13, 19, 1, 11}},
+            {21, {4, 8, 9, 18, 6, 16}},
+            {22, {3, 9, 13, 14, 1, 11}},
+            {23, {8, 14, 18, 19, 6, 16}},
+    };
+
+    uint64_t linkMask = (LINKSIZE == 64) ? ~(uint64_t)0 : ((uint64_t)1 << LINKSIZE) - 1;
+    rightTurnMask = 0x294a5 & linkMask;
+
+    conflicts.assign(LINKSIZE, 0);
+    for(auto &entry : conflictList)
+    {
+        int i = entry.first;
+        if(i >= LINKSIZE)
+            continue;
 
-        // if this row contains no conflicts
-        if(!conflictFound)
+        for(int j : entry.second)
         {
-            // now we check if this row covers all the right turns
-            // note that right turns are all permissive
-            bool coversRightTurns = true;
-            for(int j = 0; j < 8; ++j)
-            {
-                // if not a right turn
-                if ( temp[rightTurns[j]] == 0 )
-                {
-                    coversRightTurns = false;
-                    break;
-                }
-            }
+            if(j >= LINKSIZE)
+                continue;
 
-            // store this row as a non-conflicting movement
-            if(coversRightTurns)
-                allMovements.push_back(temp);
+            conflicts[i] |= (uint64_t)1 << j;
+            conflicts[j] |= (uint64_t)1 << i;
         }
     }
+}
+
+
+// FNV-1a hash of the conflict graph
+std::string TrafficLightAllowedMoves::conflictsKey()
+{
+    uint64_t hash = 14695981039346656037ULL;
+    auto mix = [&hash](uint64_t val) {
+        for(int b = 0; b < 8; b++)
+        {
+            hash ^= (val >> (8 * b)) & 0xff;
+            hash *= 1099511628211ULL;
+        }
+    };
+
+    mix(LINKSIZE);
+    mix(rightTurnMask);
+    for(uint64_t c : conflicts)
+        mix(c);
+
+    std::ostringstream str;
+    str << std::hex << std::setw(16) << std::setfill('0') << hash;
+    return str.str();
+}
 
-    std::cout << allMovements.size() << " movements found!" << std::endl;
 
-    // write allMovements to file
-    std::cout << "Writing to file ... " << std::flush;
-    FILE *filePtr = fopen (movementsFilePath.string().c_str(), "w");
-    for(auto &it : allMovements)
+// all sets of pairwise non-conflicting links that contain every right turn. The
+// sets are enumerated with a depth-first search over the links. A link is only
+// added if it does not conflict with the links chosen so far, so no conflicting
+// set is ever visited. Movements are ordered as the rows of a truth table with
+// link 0 as the most significant bit
+void TrafficLightAllowedMoves::generateAllAllowedMovements()
+{
+    LOG_INFO << "\nGenerating all possible non-conflicting movements of " << LINKSIZE << " links ... " << std::flush;
+
+    allMovements.clear();
+
+    std::vector<int> row(LINKSIZE, 0);
+    for(int i = 0; i < LINKSIZE; i++)
+        if(isRightTurn(i))
+            row[i] = 1;
+
+    enumerateMovements(0, rightTurnMask, row);
+
+    LOG_INFO << allMovements.size() << " movements found! \n" << std::flush;
+}
+
+
+void TrafficLightAllowedMoves::enumerateMovements(int link, uint64_t chosen, std::vector<int> &row)
+{
+    if(link == LINKSIZE)
     {
-        for(auto &it2 : it)
-            fprintf(filePtr, "%d", it2);
+        // skip the empty movement
+        if(chosen != 0)
+            allMovements.push_back(row);
 
-        fprintf (filePtr, "\n");
+        return;
     }
 
-    fclose(filePtr);
-    std::cout << "Done!" << std::endl << std::endl;
+    // right turns are always part of the movement
+    if(isRightTurn(link))
+    {
+        enumerateMovements(link + 1, chosen, row);
+        return;
+    }
+
+    // without this link
+    enumerateMovements(link + 1, chosen, row);
+
+    // with this link
+    if((conflicts[link] & chosen) == 0)
+    {
+        row[link] = 1;
+        enumerateMovements(link + 1, chosen | ((uint64_t)1 << link), row);
+        row[link] = 0;
+    }
 }
 
 
@@ -476,9 +367,7 @@ void TrafficLightAllowedMoves::allMovementBatch(unsigned int linkNumber)
         linkName.clear();
         for(unsigned int j = 0; j < row.size(); j++)
         {
-            bool rightTurn = std::find(std::begin(rightTurns), std::end(rightTurns), j) != std::end(rightTurns);
-
-            if(rightTurn)
+            if(isRightTurn(j))
                 std::cout << "* ";
             else
             {
@@ -503,12 +392,7 @@ void TrafficLightAllowedMoves::allMovementBatch(unsigned int linkNumber)
 
 bool TrafficLightAllowedMoves::isRightTurn(unsigned int linkNumber)
 {
-    auto it = std::find(std::begin(rightTurns), std::end(rightTurns), linkNumber);
-
-    if(it != std::end(rightTurns))
-        return true;
-
-    return false;
+    return linkNumber < 64 && ((rightTurnMask >> linkNumber) & 1);
 }
 
 }
@@ -40,9 +40,13 @@ private:
     typedef IntersectionDelay super;
 
     int LINKSIZE;
-    boost::filesystem::path movementsFilePath;
 
-    int rightTurns[8] = {0, 2, 5, 7, 10, 12, 15, 17};
+    // right turns are permissive. They are part of every movement and conflict with nothing.
+    // Initially the right turns of the 24-link intersection (links 0, 2, 5, 7, 10, 12, 15, 17)
+    uint64_t rightTurnMask = 0x294a5;
+
+    // bit j of conflicts[i] is set if links i and j can not be green at the same time
+    std::vector<uint64_t> conflicts;
 
     std::vector< std::vector<int> > allMovements;
 
@@ -59,7 +63,11 @@ protected:
     bool isRightTurn(unsigned int);
 
 private:
+    void buildConflicts(std::string TLid);
+    void defaultConflicts(std::string TLid);
+    std::string conflictsKey();
     void generateAllAllowedMovements();
+    void enumerateMovements(int link, uint64_t chosen, std::vector<int> &row);
     void allMovementBatch(unsigned int linkNumber);
 };
 
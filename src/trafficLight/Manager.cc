@@ -43,6 +43,8 @@ void TrafficLightManager::initialize(int stage)
 
     if(stage == 0)
     {
+        record_controllerLatency_stat = par("record_controllerLatency_stat").boolValue();
+
         Signal_initialize_withTraCI = registerSignal("initializeWithTraCISignal");
         omnetpp::getSimulation()->getSystemModule()->subscribe("initializeWithTraCISignal", this);
 
@@ -59,12 +61,29 @@ void TrafficLightManager::finish()
     // unsubscribe
     omnetpp::getSimulation()->getSystemModule()->unsubscribe("initializeWithTraCISignal", this);
     omnetpp::getSimulation()->getSystemModule()->unsubscribe("executeEachTimeStepSignal", this);
+
+    saveControllerLatency();
 }
 
 
+// self-messages are the interval changes of the TSCs. The TL set commands
+// issued while handling one are sent to SUMO in a single message
 void TrafficLightManager::handleMessage(omnetpp::cMessage *msg)
 {
-    super::handleMessage(msg);
+    if(!msg->isSelfMessage())
+    {
+        super::handleMessage(msg);
+        return;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    {
+        TraCIBatch batch(TraCI);
+        super::handleMessage(msg);
+    }
+
+    recordLatency(start);
 }
 
 
@@ -89,9 +108,85 @@ void TrafficLightManager::initialize_withTraCI()
 }
 
 
+// the TSCs that decide in every time step (e.g. traffic actuated) loop over
+// all TLs here. Their set commands are sent to SUMO in a single message
 void TrafficLightManager::executeEachTimeStep()
 {
-    super::executeEachTimeStep();
+    auto start = std::chrono::steady_clock::now();
+
+    {
+        TraCIBatch batch(TraCI);
+        super::executeEachTimeStep();
+    }
+
+    recordLatency(start);
+}
+
+
+void TrafficLightManager::recordLatency(std::chrono::steady_clock::time_point start)
+{
+    if(!record_controllerLatency_stat)
+        return;
+
+    double latency = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    double now = omnetpp::simTime().dbl();
+
+    // all controller events in the same time step share one entry
+    if(!controllerLatency.empty() && controllerLatency.back().time == now)
+    {
+        controllerLatency.back().events++;
+        controllerLatency.back().latency += latency;
+    }
+    else
+        controllerLatency.push_back({now, 1, latency});
+}
+
+
+void TrafficLightManager::saveControllerLatency()
+{
+    if(controllerLatency.empty())
+        return;
+
+    int currentRun = omnetpp::getEnvir()->getConfigEx()->getActiveRunNumber();
+
+    std::ostringstream fileName;
+    fileName << boost::format("%03d_TLControllerLatency.txt") % currentRun;
+
+    boost::filesystem::path filePath ("results");
+    filePath /= fileName.str();
+
+    FILE *filePtr = fopen (filePath.c_str(), "w");
+    if (!filePtr)
+        throw omnetpp::cRuntimeError("Cannot create file '%s'", filePath.c_str());
+
+    double totalLatency = 0;
+    double maxLatency = 0;
+    for(auto &entry : controllerLatency)
+    {
+        totalLatency += entry.latency;
+        maxLatency = std::max(maxLatency, entry.latency);
+    }
+
+    // write a summary at the beginning of the file
+    fprintf (filePtr, "TLControlMode   %d\n", TLControlMode);
+    fprintf (filePtr, "timeSteps       %lu\n", controllerLatency.size());
+    fprintf (filePtr, "totalLatency    %.3f ms\n", totalLatency);
+    fprintf (filePtr, "meanLatency     %.3f ms\n", totalLatency / controllerLatency.size());
+    fprintf (filePtr, "maxLatency      %.3f ms\n\n\n", maxLatency);
+
+    // write header
+    fprintf (filePtr, "%-10s", "timeStep");
+    fprintf (filePtr, "%-10s", "events");
+    fprintf (filePtr, "%-15s\n\n", "latency(ms)");
+
+    for(auto &entry : controllerLatency)
+    {
+        fprintf (filePtr, "%-10.2f", entry.time);
+        fprintf (filePtr, "%-10d", entry.events);
+        fprintf (filePtr, "%-15.3f\n", entry.latency);
+    }
+
+    fclose(filePtr);
 }
 
 }
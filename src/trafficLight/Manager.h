@@ -27,10 +27,19 @@
 #ifndef TRAFFICLIGHTMANAGER_H
 #define TRAFFICLIGHTMANAGER_H
 
+#include <chrono>
+
 #include "trafficLight/TSC/09_Router.h"
 
 namespace VENTOS {
 
+typedef struct controllerLatency
+{
+    double time;
+    int events;         // controller events (interval changes, time steps) in this time step
+    double latency;     // wall-clock time spent in the controller in this time step (ms)
+} controllerLatency_t;
+
 class TrafficLightManager : public TrafficLightRouter
 {
 private:
@@ -39,6 +48,11 @@ private:
     omnetpp::simsignal_t Signal_initialize_withTraCI;
     omnetpp::simsignal_t Signal_executeEachTS;
 
+    // NED variables
+    bool record_controllerLatency_stat;
+
+    std::vector<controllerLatency_t> controllerLatency;
+
 public:
     virtual ~TrafficLightManager();
     virtual void initialize(int);
@@ -49,6 +63,10 @@ public:
 protected:
     void virtual initialize_withTraCI();
     void virtual executeEachTimeStep();
+
+private:
+    void recordLatency(std::chrono::steady_clock::time_point start);
+    void saveControllerLatency();
 };
 
 }
@@ -0,0 +1,79 @@
+/****************************************************************************/
+/// @file    PhasingConvert.cc
+/// @author  Mani Amoozadeh <maniam@ucdavis.edu>
+/// @author  second author name
+/// @date    October 2017
+///
+/****************************************************************************/
+// VENTOS, Vehicular Network Open Simulator; see http:?
+// Copyright (C) 2013-2015
+/****************************************************************************/
+//
+// This file is part of VENTOS.
+// VENTOS is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+// Converts a binary TL phasing log (results/*_TLphasingData.bin) to the text
+// table of results/*_TLphasingData.txt, without the simulation parameters at the
+// beginning of the file. Works on the log of a crashed or still running simulation.
+//
+// usage: PhasingConvert binFile [txtFile]
+//
+// Without txtFile, the table is written to stdout.
+
+#include <cstdio>
+#include <stdexcept>
+
+#include "trafficLight/TSC/PhasingLog.h"
+
+
+int main(int argc, char *argv[])
+{
+    using namespace VENTOS;
+
+    if(argc != 2 && argc != 3)
+    {
+        fprintf(stderr, "usage: %s binFile [txtFile] \n", argv[0]);
+        return 1;
+    }
+
+    FILE *filePtr = stdout;
+    if(argc == 3)
+    {
+        filePtr = fopen (argv[2], "w");
+        if (!filePtr)
+        {
+            fprintf(stderr, "Cannot create file '%s' \n", argv[2]);
+            return 1;
+        }
+    }
+
+    int ret = 0;
+    try
+    {
+        if(PhasingLog::convert(argv[1], filePtr))
+            fprintf(stderr, "WARNING: '%s' ends in an incomplete entry. It is skipped. \n", argv[1]);
+    }
+    catch(std::exception &e)
+    {
+        fprintf(stderr, "%s \n", e.what());
+        ret = 1;
+    }
+
+    if(filePtr != stdout)
+        fclose(filePtr);
+
+    return ret;
+}
@@ -26,6 +26,7 @@
 //
 
 #include <iomanip>
+#include <algorithm>
 
 #include "00_TLStateRecord.h"
 
@@ -35,7 +36,8 @@ Define_Module(VENTOS::TLStateRecord);
 
 TLStateRecord::~TLStateRecord()
 {
-
+    if(phasingFilePtr)
+        fclose(phasingFilePtr);
 }
 
 
@@ -95,11 +97,21 @@ void TLStateRecord::updateTLstate(std::string TLid, std::string stage, std::stri
 {
     if(stage == "init")
     {
+        auto it = TLIndex.find(TLid);
+        if(it == TLIndex.end())
+        {
+            it = TLIndex.insert(std::make_pair(TLid, (int)TLNames.size())).first;
+            TLNames.push_back(TLid);
+            PhasingLog::appendString(phasingChunk, PhasingLog::TL_NAME, it->second, TLid);
+            phaseTL.push_back(0);
+            statusTL.push_back(currentStatusTL_t());
+        }
+
         // initialize phase number in this TL
-        phaseTL[TLid] = 1;
+        phaseTL[it->second] = 1;
 
         // initialize status in this TL
-        currentStatusTL_t entry = {};
+        currentStatusTL_t &entry = statusTL[it->second];
 
         entry.cycle = 1;
         entry.allowedMovements = currentInterval;
@@ -108,23 +120,14 @@ void TLStateRecord::updateTLstate(std::string TLid, std::string stage, std::stri
         entry.yellowStart = -1;
         entry.redStart = -1;
         entry.phaseEnd = -1;
-
-        statusTL.insert( std::make_pair(std::make_pair(TLid,1), entry) );
     }
     else
     {
-        auto it = phaseTL.find(TLid);
-        if(it == phaseTL.end())
+        auto it = TLIndex.find(TLid);
+        if(it == TLIndex.end())
             throw omnetpp::cRuntimeError("Cannot find the current phase in TL '%s'", TLid.c_str());
 
-        // get the current phase
-        int currentPhase = it->second;
-
-        auto it2 = statusTL.find(std::make_pair(TLid,currentPhase));
-        if(it2 == statusTL.end())
-            throw omnetpp::cRuntimeError("Cannot find status for TL '%s' at phase '%d'", TLid.c_str(), currentPhase);
-
-        currentStatusTL_t &status = it2->second;
+        currentStatusTL_t &status = statusTL[it->second];
 
         if(stage == "yellow")
         {
@@ -165,6 +168,9 @@ void TLStateRecord::updateTLstate(std::string TLid, std::string stage, std::stri
             // if(red_duration - redTime != 0)
             //     throw omnetpp::cRuntimeError("red interval is not %0.3f", redTime);
 
+            // this phase is complete
+            appendPhasingRecord(it->second);
+
             // get the current cycle number
             int cycleNumber = status.cycle;
 
@@ -181,49 +187,116 @@ void TLStateRecord::updateTLstate(std::string TLid, std::string stage, std::stri
             }
 
             // increase phase number by 1
-            auto location2 = phaseTL.find(TLid);
-            location2->second = location2->second + 1;
+            phaseTL[it->second]++;
 
             // update status for the new phase
-            currentStatusTL_t entry = {};
-
-            entry.cycle = cycleNumber;
-            entry.allowedMovements = currentInterval;
-            entry.greenLength = -1;
-            entry.greenStart = omnetpp::simTime().dbl();
-            entry.yellowStart = -1;
-            entry.redStart = -1;
-            entry.phaseEnd = -1;
-
-            statusTL.insert( std::make_pair(std::make_pair(TLid,location2->second), entry) );
+            status.cycle = cycleNumber;
+            status.allowedMovements = currentInterval;
+            status.greenLength = -1;
+            status.greenStart = omnetpp::simTime().dbl();
+            status.yellowStart = -1;
+            status.redStart = -1;
+            status.phaseEnd = -1;
         }
         else throw omnetpp::cRuntimeError("stage is not recognized!");
     }
 }
 
 
-const TLStateRecord::currentStatusTL_t TLStateRecord::TLGetStatus(std::string TLid)
+const TLStateRecord::currentStatusTL_t & TLStateRecord::TLGetStatus(const std::string &TLid)
 {
-    auto it = phaseTL.find(TLid);
-    if(it == phaseTL.end())
+    auto it = TLIndex.find(TLid);
+    if(it == TLIndex.end())
         throw omnetpp::cRuntimeError("Cannot find the current phase in TL '%s'", TLid.c_str());
 
-    // get the current phase
-    int currentPhase = it->second;
+    return statusTL[it->second];
+}
+
+
+int TLStateRecord::internInterval(const std::string &interval)
+{
+    auto it = intervalIndex.find(interval);
+    if(it != intervalIndex.end())
+        return it->second;
+
+    int index = intervalNames.size();
+    intervalNames.push_back(interval);
+    intervalIndex[interval] = index;
 
-    auto it2 = statusTL.find(std::make_pair(TLid,currentPhase));
-    if(it2 == statusTL.end())
-        throw omnetpp::cRuntimeError("Cannot find status for TL '%s' at phase '%d'", TLid.c_str(), currentPhase);
+    PhasingLog::appendString(phasingChunk, PhasingLog::INTERVAL_NAME, index, interval);
 
-    return it2->second;
+    return index;
+}
+
+
+void TLStateRecord::appendPhasingRecord(int TL)
+{
+    const currentStatusTL_t &status = statusTL[TL];
+
+    phasingRecord_t record;
+
+    record.TL = TL;
+    record.phase = phaseTL[TL];
+    record.cycle = status.cycle;
+    record.allowedMovements = internInterval(status.allowedMovements);
+    record.greenLength = status.greenLength;
+    record.greenStart = status.greenStart;
+    record.yellowStart = status.yellowStart;
+    record.redStart = status.redStart;
+    record.phaseEnd = status.phaseEnd;
+
+    PhasingLog::appendRecord(phasingChunk, record);
+
+    if(phasingChunk.size() >= phasingChunkSize * sizeof(phasingRecord_t))
+        flushPhasingData();
+}
+
+
+// the phasing log starts with a small header, followed by the entries (see PhasingLog)
+void TLStateRecord::flushPhasingData()
+{
+    if(phasingChunk.empty())
+        return;
+
+    if(!phasingFilePtr)
+    {
+        int currentRun = omnetpp::getEnvir()->getConfigEx()->getActiveRunNumber();
+
+        std::ostringstream fileName;
+        fileName << boost::format("%03d_TLphasingData.bin") % currentRun;
+
+        phasingFilePath = "results";
+        phasingFilePath /= fileName.str();
+
+        phasingFilePtr = fopen (phasingFilePath.c_str(), "wb");
+        if (!phasingFilePtr)
+            throw omnetpp::cRuntimeError("Cannot create file '%s'", phasingFilePath.c_str());
+
+        PhasingLog::writeHeader(phasingFilePtr);
+    }
+
+    if(fwrite(phasingChunk.data(), 1, phasingChunk.size(), phasingFilePtr) != phasingChunk.size())
+        throw omnetpp::cRuntimeError("Cannot write to file '%s'", phasingFilePath.c_str());
+
+    fflush(phasingFilePtr);
+    phasingChunk.clear();
 }
 
 
 void TLStateRecord::saveTLPhasingData()
 {
-    if(statusTL.empty())
+    if(TLNames.empty())
         return;
 
+    // the current phase of each TL is not complete, but is logged as well
+    for(unsigned int TL = 0; TL < TLNames.size(); TL++)
+        appendPhasingRecord(TL);
+
+    flushPhasingData();
+
+    fclose(phasingFilePtr);
+    phasingFilePtr = NULL;
+
     int currentRun = omnetpp::getEnvir()->getConfigEx()->getActiveRunNumber();
 
     std::ostringstream fileName;
@@ -273,31 +346,14 @@ void TLStateRecord::saveTLPhasingData()
         fprintf (filePtr, "duration        %s\n\n\n", TraCI->simulationGetDuration_str().c_str());
     }
 
-    // write header
-    fprintf (filePtr, "%-12s", "TLid");
-    fprintf (filePtr, "%-12s", "phase");
-    fprintf (filePtr, "%-12s", "cycle");
-    fprintf (filePtr, "%-35s", "allowedMovements");
-    fprintf (filePtr, "%-15s", "greenLength");
-    fprintf (filePtr, "%-15s", "greenStart");
-    fprintf (filePtr, "%-15s", "yellowStart");
-    fprintf (filePtr, "%-15s", "redStart");
-    fprintf (filePtr, "%-15s \n\n", "phaseEnd");
-
-    // write body
-    for(auto &y : statusTL)
+    try
+    {
+        PhasingLog::convert(phasingFilePath.string(), filePtr);
+    }
+    catch(std::exception &e)
     {
-        currentStatusTL status = y.second;
-
-        fprintf (filePtr, "%-12s", y.first.first.c_str());
-        fprintf (filePtr, "%-12d", y.first.second);
-        fprintf (filePtr, "%-12d", status.cycle);
-        fprintf (filePtr, "%-35s", status.allowedMovements.c_str());
-        fprintf (filePtr, "%-15.2f", status.greenLength);
-        fprintf (filePtr, "%-15.2f", status.greenStart);
-        fprintf (filePtr, "%-15.2f", status.yellowStart);
-        fprintf (filePtr, "%-15.2f", status.redStart);
-        fprintf (filePtr, "%-15.2f \n", status.phaseEnd);
+        fclose(filePtr);
+        throw omnetpp::cRuntimeError("%s", e.what());
     }
 
     fclose(filePtr);
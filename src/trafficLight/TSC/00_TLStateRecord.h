@@ -29,6 +29,7 @@
 #define TLSTATERECORD_H
 
 #include "trafficLight/05_AllowedMoves.h"
+#include "trafficLight/TSC/PhasingLog.h"
 
 namespace VENTOS {
 
@@ -77,11 +78,21 @@ protected:
 private:
     typedef TrafficLightAllowedMoves super;
 
-    // current phase in each TL
-    std::unordered_map<std::string /*TLid*/, int /*phase number*/> phaseTL;
+    // current phase number and status of each TL, indexed by TLIndex
+    std::unordered_map<std::string /*TLid*/, int /*TL index*/> TLIndex;
+    std::vector<std::string> TLNames;
+    std::vector<int> phaseTL;
+    std::vector<currentStatusTL_t> statusTL;
 
-    // current status of each TL in each phase
-    std::map<std::pair<std::string /*TLid*/, int /*phase number*/>, currentStatusTL_t> statusTL;
+    std::unordered_map<std::string /*interval*/, int> intervalIndex;
+    std::vector<std::string> intervalNames;
+
+    // finished phases and newly interned strings are appended to the binary
+    // phasing log in chunks of about phasingChunkSize records
+    static const unsigned int phasingChunkSize = 4096;
+    std::vector<char> phasingChunk;
+    FILE *phasingFilePtr = NULL;
+    boost::filesystem::path phasingFilePath;
 
 public:
     virtual ~TLStateRecord();
@@ -94,9 +105,12 @@ protected:
     void virtual executeEachTimeStep();
 
     void updateTLstate(std::string, std::string, std::string = "", bool = false);
-    const currentStatusTL_t TLGetStatus(std::string TLid);
+    const currentStatusTL_t & TLGetStatus(const std::string &TLid);
 
 private:
+    int internInterval(const std::string &);
+    void appendPhasingRecord(int TL);
+    void flushPhasingData();
     void saveTLPhasingData();
 };
 
@@ -98,7 +98,7 @@ void TrafficLightFixed::executeEachTimeStep()
 
     // get current interval (SUMO calls it phase!) -- interval starts at index 0
     int intervalNumber = TraCI->TLGetPhase("C");
-    currentStatusTL_t status = TLGetStatus("C");
+    const currentStatusTL_t &status = TLGetStatus("C");
 
     // current phase is ended. Green interval starts
     if(intervalNumber % 3 == 0 && status.redStart != -1)
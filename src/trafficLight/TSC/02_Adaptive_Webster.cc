@@ -27,6 +27,7 @@
 #include <algorithm>
 
 #include "trafficLight/TSC/02_Adaptive_Webster.h"
+#include "trafficLight/TSC/PhaseScoring.h"
 
 
 namespace VENTOS {
@@ -57,6 +58,9 @@ void TrafficLightWebster::initialize(int stage)
             throw omnetpp::cRuntimeError("alpha value should be [0,1]");
 
         intervalChangeEVT = new omnetpp::cMessage("intervalChangeEVT", 1);
+
+        // IntersectionDemand keeps the moving average of TD with this weight
+        TDalpha = alpha;
     }
 }
 
@@ -93,6 +97,10 @@ void TrafficLightWebster::initialize_withTraCI()
 
     LOG_INFO << "\nAdaptive Webster traffic signal control ...  \n" << std::flush;
 
+    auto TLList = TraCI->TLGetIDList();
+    for (auto &TL : TLList)
+        initPhaseLinks(TL);
+
     // run Webster at the beginning of the cycle
     calculateGreenSplits("C");
 
@@ -102,7 +110,6 @@ void TrafficLightWebster::initialize_withTraCI()
 
     scheduleAt(omnetpp::simTime().dbl() + intervalDuration, intervalChangeEVT);
 
-    auto TLList = TraCI->TLGetIDList();
     for (auto &TL : TLList)
     {
         TraCI->TLSetProgram(TL, "adaptive-time");
@@ -219,142 +226,103 @@ void TrafficLightWebster::calculateGreenSplits(std::string TLid)
     {
         LOG_DEBUG << "\n    Measured traffic demands at the beginning of this cycle: ";
 
-        for(auto &y : TD_perLane)
+        for(auto &y : demandLanes)
         {
-            std::string lane = y.first;
-            std::string TLid = y.second.first;
-            boost::circular_buffer<std::vector<double>> buf = y.second.second;
-
-            double aveTD = 0;
-
-            if(!buf.empty())
-            {
-                // calculate 'exponential moving average' of TD for link i
-                aveTD = buf[0].at(0);  // get the oldest value (queue front)
-                for (boost::circular_buffer<std::vector<double>>::iterator it = buf.begin()+1; it != buf.end(); ++it)
-                {
-                    double nextTD = (*it).at(0);
-                    aveTD = alpha*nextTD + (1-alpha)*aveTD;
-                }
-
-                if(aveTD != 0)
-                    LOG_DEBUG << lane << ": " << aveTD << " | ";
-            }
+            // 'exponential moving average' of TD for lane i
+            double aveTD = getAverageTD(y.TD, y.TDave);
+
+            if(aveTD != 0)
+                LOG_DEBUG << y.lane << ": " << aveTD << " | ";
         }
 
         LOG_DEBUG << "\n \n" << std::flush;
     }
 
-    std::vector<double> critical;
-    critical.clear();
+    auto loc = phaseLinks.find(TLid);
+    if(loc == phaseLinks.end())
+        throw omnetpp::cRuntimeError("cannot find TL '%s' in phaseLinks", TLid.c_str());
 
-    double Y = 0;
-    for (std::string prog : phases)
+    std::vector<double> critical;
+    for (auto &links : loc->second)
     {
         double Y_i = -1;  // critical volume-to-capacity ratio for this movement batch
-        // for each link in this batch
-        for(unsigned int i = 0; i < prog.size(); ++i)
+        // for each active link in this batch
+        for(int link : links)
         {
-            // if link i is active
-            if(prog[i] == 'g' || prog[i] == 'G')
-            {
-                // if link i is not a right-turn (right turns are all permissive)
-                if(!isRightTurn(i))
-                {
-                    // get all TD measurements so far for link i
-                    auto buffer = TD_perLink[std::make_pair(TLid,i)];
-
-                    double aveTD = 0;
-
-                    if(!buffer.empty())
-                    {
-                        // calculate 'exponential moving average' of TD for link i
-                        aveTD = buffer[0].at(0);  // get the oldest value (queue front)
-                        for (boost::circular_buffer<std::vector<double>>::iterator it = buffer.begin()+1; it != buffer.end(); ++it)
-                        {
-                            double nextTD = (*it).at(0);
-                            aveTD = alpha*nextTD + (1-alpha)*aveTD;
-                        }
-                    }
-
-                    Y_i = std::max(Y_i, aveTD / saturationTD);
-                }
-            }
+            // 'exponential moving average' of TD for this link
+            double aveTD = (link == -1) ? 0 : getAverageTD(demandLinks[link].TD, demandLinks[link].TDave);
+
+            Y_i = std::max(Y_i, aveTD / saturationTD);
         }
 
         critical.push_back(Y_i);
-        Y = Y + Y_i;
     }
 
     // print Y_i for each phase
     LOG_DEBUG << "    critical v/c for each phase: ";
-    int activePhases = 0;
     for(double y : critical)
-    {
         LOG_DEBUG << y << ", ";
-        if(y != 0) activePhases++;
-    }
     LOG_DEBUG << "\n\n";
 
-    if(Y < 0)
+    websterPlan_t plan = PhaseScoring::webster(critical, yellowTime + redTime, maxCycleLength, minGreenTime, maxGreenTime);
+
+    if(plan.Y < 0)
     {
         throw omnetpp::cRuntimeError("WTH! total critical v/c is negative!");
     }
     // no TD in any directions. Give G_min to each phase
-    else if(Y == 0)
+    else if(plan.Y == 0)
     {
         LOG_DEBUG << boost::format("    Total critical v/c is zero! Set green split for each phase to G_min=%1% \n") % minGreenTime << std::flush;
-
-        // green split for each phase
-        for (std::string prog : phases)
-            greenSplit[prog] = minGreenTime;
     }
-    else if(Y > 0 && Y < 1)
+    else if(plan.Y >= 1)
+    {
+        throw omnetpp::cRuntimeError("total critical v/c >= 1. Saturation flow might be low ?!");
+    }
+    else
     {
-        double startupLoss_i = 1.0;
-        double changeInterval_i = yellowTime + redTime;
-        double clearanceLoss_i = (1-0.8)*changeInterval_i;
-        double totalLoss_i = startupLoss_i + clearanceLoss_i;   // total loss time per phase
-        double totalLoss = totalLoss_i * activePhases;  // total loss time for all phases
-
-        double cycle = ((1.5*totalLoss) + 5) / (1 - Y);  // cycle length
-
         LOG_DEBUG << boost::format("    Webster Calculation: \n");
-        LOG_DEBUG << boost::format("        total critical v/c=%1% \n") % Y;
-        LOG_DEBUG << boost::format("        total loss time=%1% \n") % totalLoss;
-        LOG_DEBUG << boost::format("        cycle length=%1% \n") % cycle;
+        LOG_DEBUG << boost::format("        total critical v/c=%1% \n") % plan.Y;
+        LOG_DEBUG << boost::format("        total loss time=%1% \n") % plan.totalLoss;
+        LOG_DEBUG << boost::format("        cycle length=%1% \n") % plan.cycle;
         LOG_DEBUG << "\n" << std::flush;
 
-        // make sure that cycle length is not too big.
         // this happens when Y is too close to 1
-        if(cycle > maxCycleLength)
-        {
+        if(plan.capped)
             LOG_WARNING << "    WARNING: cycle length exceeds max C_y=" << maxCycleLength << "\n";
-            cycle = maxCycleLength;
-        }
+    }
 
-        double effectiveG = cycle - totalLoss;   // total effective green time
+    // green split for each phase
+    for(unsigned int phaseNumber = 0; phaseNumber < phases.size(); ++phaseNumber)
+        greenSplit[phases[phaseNumber]] = plan.greenSplit[phaseNumber];
 
-        // green split for each phase
-        int phaseNumber = 0;
-        for (std::string prog : phases)
-        {
-            double GS = (critical[phaseNumber] / Y) * effectiveG;
-            greenSplit[prog] = std::min(std::max(minGreenTime, GS), maxGreenTime);
-            phaseNumber++;
-        }
+    if(LOG_ACTIVE(DEBUG_LOG_VAL) && plan.Y > 0)
+    {
+        LOG_DEBUG << "    Updating green splits for each phase: ";
+        for(auto &y : greenSplit)
+            LOG_DEBUG << y.second << ", ";
+        LOG_DEBUG << "\n" << std::flush;
+    }
+}
 
-        if(LOG_ACTIVE(DEBUG_LOG_VAL))
+
+// active links of each phase that are not right-turns (right turns are all permissive).
+// Links without traffic demand measurement are kept as -1
+void TrafficLightWebster::initPhaseLinks(std::string TLid)
+{
+    std::vector<std::vector<int>> &links = phaseLinks[TLid];
+    links.clear();
+
+    for (std::string prog : phases)
+    {
+        std::vector<int> batch;
+        for(unsigned int i = 0; i < prog.size(); ++i)
         {
-            LOG_DEBUG << "    Updating green splits for each phase: ";
-            for(auto &y : greenSplit)
-                LOG_DEBUG << y.second << ", ";
-            LOG_DEBUG << "\n" << std::flush;
+            if((prog[i] == 'g' || prog[i] == 'G') && !isRightTurn(i))
+                batch.push_back(linkGetIndex(TLid, i));
         }
-    }
-    else if(Y >= 1)
-    {
-        throw omnetpp::cRuntimeError("total critical v/c >= 1. Saturation flow might be low ?!");
+
+        links.push_back(batch);
     }
 }
 
@@ -50,6 +50,9 @@ private:
 
     std::map<std::string /*phase*/, double /*green split*/> greenSplit;
 
+    // non right-turn links (indices into demandLinks) that are green in each phase
+    std::map<std::string /*TLid*/, std::vector<std::vector<int>> /*per phase*/> phaseLinks;
+
 public:
     virtual ~TrafficLightWebster();
     virtual void initialize(int);
@@ -64,6 +67,7 @@ private:
     void chooseNextInterval(std::string);
     void chooseNextGreenInterval(std::string);
     void calculateGreenSplits(std::string);
+    void initPhaseLinks(std::string);
 };
 
 }
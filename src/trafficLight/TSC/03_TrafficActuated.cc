@@ -26,6 +26,7 @@
 //
 
 #include <iomanip>
+#include <algorithm>
 
 #include "trafficLight/TSC/03_TrafficActuated.h"
 
@@ -113,37 +114,58 @@ void TrafficLightActuated::initialize_withTraCI()
 
     checkLoopDetectors();
 
-    // passageTime calculation per incoming lane
-    if(passageTime == -1)
+    if(passageTime != -1 && (passageTime < 0 || passageTime > minGreenTime))
+        throw omnetpp::cRuntimeError("passageTime value is not set correctly!");
+
+    // actuated LDs are updated from the loop detector subscription
+    TraCI->LDSubscribe();
+
+    actuatedLDs.clear();
+    actuatedLDs.reserve(LD_actuated.size());
+    LDindex2actuated.assign(TraCI->LDGetIDList().size(), NULL);
+    // (*LD).first is 'lane id' and (*LD).second is detector id
+    for (auto &LD : LD_actuated)
     {
-        // (*LD).first is 'lane id' and (*LD).second is detector id
-        for (auto &LD : LD_actuated)
+        int index = TraCI->LDGetIndex(LD.second);
+        if(index == -1)
+            throw omnetpp::cRuntimeError("Loop detector '%s' is not subscribed", LD.second.c_str());
+
+        actuatedLD_t entry;
+        entry.lane = LD.first;
+        entry.LDid = LD.second;
+        entry.LDindex = index;
+        // get position of the loop detector from end of lane
+        entry.LDPos = TraCI->laneGetLength(LD.first) - TraCI->LDGetPosition(LD.second);
+
+        // passageTime calculation per incoming lane
+        if(passageTime == -1)
         {
             // get the max speed on this lane
             double maxV = TraCI->laneGetMaxSpeed(LD.first);
-            // get position of the loop detector from end of lane
-            double LDPos = TraCI->laneGetLength(LD.first) - TraCI->LDGetPosition(LD.second);
             // calculate passageTime for this lane
-            double pass = std::fabs(LDPos) / maxV;
+            double pass = std::fabs(entry.LDPos) / maxV;
             // check if not greater than Gmin
             if(pass > minGreenTime)
             {
                 LOG_WARNING << "WARNING: loop detector (" << LD.second << ") is far away! Passage time is greater than Gmin." << std::endl;
                 pass = minGreenTime;
             }
-            // set it for each lane
-            passageTimePerLane[LD.first] = pass;
+            // set it for this lane
+            entry.passageTime = pass;
         }
+        // user set the passage time
+        else
+            entry.passageTime = passageTime;
+
+        auto loc = std::find(actuatedLaneNames.begin(), actuatedLaneNames.end(), LD.first);
+        entry.slot = (loc == actuatedLaneNames.end()) ? -1 : loc - actuatedLaneNames.begin();
+
+        actuatedLDs.push_back(entry);
+        LDindex2actuated[index] = &actuatedLDs.back();
     }
-    // user set the passage time
-    else if(passageTime >=0 && passageTime <= minGreenTime)
-    {
-        // (*LD).first is 'lane id' and (*LD).second is detector id
-        for (auto &LD : LD_actuated)
-            passageTimePerLane[LD.first] = passageTime;
-    }
-    else
-        throw omnetpp::cRuntimeError("passageTime value is not set correctly!");
+
+    std::fill(passage, passage + actuatedLaneCount, 0.);
+    std::fill(lastActuated, lastActuated + actuatedLaneCount, 0.);
 
     LOG_DEBUG << boost::format("\nSimTime: %1% | Planned interval: %2% | Start time: %1% | End time: %3% \n")
     % omnetpp::simTime().dbl() % currentInterval % (omnetpp::simTime().dbl() + intervalDuration) << std::flush;
@@ -161,24 +183,25 @@ void TrafficLightActuated::executeEachTimeStep()
     // update passage time if necessary
     if(passageTime == -1)
     {
-        // (*LD).first is 'lane id' and (*LD).second is detector id
-        for (auto &LD : LD_actuated)
+        // only loop detectors with a vehicle in the last time step have a mean speed
+        for (int index : TraCI->LDGetActive())
         {
-            double approachSpeed = TraCI->LDGetLastStepMeanVehicleSpeed(LD.second);
+            actuatedLD_t *LD = LDindex2actuated[index];
+            if(!LD)
+                continue;
+
+            double approachSpeed = TraCI->LDGetState(index).meanSpeed;
             // update passage time for this lane
             if(approachSpeed > 0)
             {
-                // get position of the loop detector from end of lane
-                double LDPos = TraCI->laneGetLength(LD.first) - TraCI->LDGetPosition(LD.second);
                 // calculate passageTime for this lane
-                double pass = std::fabs(LDPos) / approachSpeed;
+                double pass = std::fabs(LD->LDPos) / approachSpeed;
                 // check if not greater than Gmin
                 if(pass > minGreenTime)
                     pass = minGreenTime;
 
-                // update passage time value in passageTimePerLane
-                auto location = passageTimePerLane.find(LD.first);
-                location->second = pass;
+                // update passage time value of this lane
+                LD->passageTime = pass;
             }
         }
     }
@@ -287,30 +310,30 @@ void TrafficLightActuated::chooseNextGreenInterval(std::string TLid)
     LOG_DEBUG << ">>> Check for actuation in the last green interval ... \n" << std::flush;
 
     // get loop detector information
-    std::map<std::string,double> LastActuatedTime;
-
-    // (*LD).first is 'lane id' and (*LD).second is detector id
-    for (auto &LD : LD_actuated)
+    for (auto &LD : actuatedLDs)
     {
-        double elapsedT = TraCI->LDGetElapsedTimeLastDetection(LD.second);
-        LastActuatedTime[LD.first] = elapsedT;
+        if(LD.slot == -1)
+            continue;
+
+        passage[LD.slot] = LD.passageTime;
+        lastActuated[LD.slot] = TraCI->LDGetState(LD.LDindex).elapsedTime;
     }
 
     if(LOG_ACTIVE(DEBUG_LOG_VAL))
     {
         LOG_DEBUG << "\n    Passage time value per lane: ";
-        for (auto &LD : passageTimePerLane)
-            LOG_DEBUG << LD.first << " (" << LD.second << ") | ";
+        for (auto &LD : actuatedLDs)
+            LOG_DEBUG << LD.lane << " (" << LD.passageTime << ") | ";
 
         LOG_DEBUG << "\n";
 
         LOG_DEBUG << "    Actuated LDs (lane, elapsed time): ";
-        for (auto &LD : LD_actuated)
+        for (auto &LD : actuatedLDs)
         {
-            double elapsedT = TraCI->LDGetElapsedTimeLastDetection(LD.second);
+            double elapsedT = TraCI->LDGetState(LD.LDindex).elapsedTime;
 
             if(abs(omnetpp::simTime().dbl() - (elapsedT + updateInterval)) >= updateInterval)
-                LOG_DEBUG << LD.first << " (" << elapsedT << ") | " << std::flush;
+                LOG_DEBUG << LD.lane << " (" << elapsedT << ") | " << std::flush;
         }
 
         LOG_DEBUG << "\n" << std::flush;
@@ -323,19 +346,19 @@ void TrafficLightActuated::chooseNextGreenInterval(std::string TLid)
     if (currentInterval == phase1_5)
     {
         if (greenExtension && intervalElapseTime < maxGreenTime &&
-                LastActuatedTime["NC_4"] < passageTimePerLane["NC_4"] &&
-                LastActuatedTime["SC_4"] < passageTimePerLane["SC_4"])
+                lastActuated[NC_4] < passage[NC_4] &&
+                lastActuated[SC_4] < passage[SC_4])
         {
-            intervalDuration = std::max(passageTimePerLane["NC_4"]-LastActuatedTime["NC_4"], passageTimePerLane["SC_4"]-LastActuatedTime["SC_4"]);
+            intervalDuration = std::max(passage[NC_4]-lastActuated[NC_4], passage[SC_4]-lastActuated[SC_4]);
             extend = true;
         }
-        else if (LastActuatedTime["NC_4"] < passageTimePerLane["NC_4"])
+        else if (lastActuated[NC_4] < passage[NC_4])
         {
             nextGreenInterval = phase2_5;
             nextInterval = "grgrGgrgrrgrgrygrgrrrrrr";
             extend = false;
         }
-        else if (LastActuatedTime["SC_4"] < passageTimePerLane["SC_4"])
+        else if (lastActuated[SC_4] < passage[SC_4])
         {
             nextGreenInterval = phase1_6;
             nextInterval = "grgrygrgrrgrgrGgrgrrrrrr";
@@ -351,9 +374,9 @@ void TrafficLightActuated::chooseNextGreenInterval(std::string TLid)
     else if (currentInterval == phase2_5)
     {
         if (greenExtension && intervalElapseTime < maxGreenTime &&
-                LastActuatedTime["NC_4"] < passageTimePerLane["NC_4"])
+                lastActuated[NC_4] < passage[NC_4])
         {
-            intervalDuration = passageTimePerLane["NC_4"] - LastActuatedTime["NC_4"];
+            intervalDuration = passage[NC_4] - lastActuated[NC_4];
             extend = true;
         }
         else
@@ -366,9 +389,9 @@ void TrafficLightActuated::chooseNextGreenInterval(std::string TLid)
     else if (currentInterval == phase1_6)
     {
         if (greenExtension && intervalElapseTime < maxGreenTime &&
-                LastActuatedTime["SC_4"] < passageTimePerLane["SC_4"])
+                lastActuated[SC_4] < passage[SC_4])
         {
-            intervalDuration = passageTimePerLane["SC_4"] - LastActuatedTime["SC_4"];
+            intervalDuration = passage[SC_4] - lastActuated[SC_4];
             extend = true;
         }
         else
@@ -381,13 +404,13 @@ void TrafficLightActuated::chooseNextGreenInterval(std::string TLid)
     else if (currentInterval == phase2_6)
     {
         if (greenExtension && intervalElapseTime < maxGreenTime &&
-                (LastActuatedTime["NC_2"] < passageTimePerLane["NC_2"] ||
-                        LastActuatedTime["NC_3"] < passageTimePerLane["NC_3"] ||
-                        LastActuatedTime["SC_2"] < passageTimePerLane["SC_2"] ||
-                        LastActuatedTime["SC_3"] < passageTimePerLane["SC_3"]))
+                (lastActuated[NC_2] < passage[NC_2] ||
+                        lastActuated[NC_3] < passage[NC_3] ||
+                        lastActuated[SC_2] < passage[SC_2] ||
+                        lastActuated[SC_3] < passage[SC_3]))
         {
-            double biggest1 = std::max(passageTimePerLane["NC_2"]-LastActuatedTime["NC_2"], passageTimePerLane["SC_2"]-LastActuatedTime["SC_2"]);
-            double biggest2 = std::max(passageTimePerLane["NC_3"]-LastActuatedTime["NC_3"], passageTimePerLane["SC_3"]-LastActuatedTime["SC_3"]);
+            double biggest1 = std::max(passage[NC_2]-lastActuated[NC_2], passage[SC_2]-lastActuated[SC_2]);
+            double biggest2 = std::max(passage[NC_3]-lastActuated[NC_3], passage[SC_3]-lastActuated[SC_3]);
             intervalDuration = std::max(biggest1, biggest2);
             extend = true;
         }
@@ -401,19 +424,19 @@ void TrafficLightActuated::chooseNextGreenInterval(std::string TLid)
     else if (currentInterval == phase3_7)
     {
         if (greenExtension && intervalElapseTime < maxGreenTime &&
-                LastActuatedTime["WC_4"] < passageTimePerLane["WC_4"] &&
-                LastActuatedTime["EC_4"] < passageTimePerLane["EC_4"])
+                lastActuated[WC_4] < passage[WC_4] &&
+                lastActuated[EC_4] < passage[EC_4])
         {
-            intervalDuration = std::max(passageTimePerLane["WC_4"]-LastActuatedTime["WC_4"], passageTimePerLane["EC_4"]-LastActuatedTime["EC_4"]);
+            intervalDuration = std::max(passage[WC_4]-lastActuated[WC_4], passage[EC_4]-lastActuated[EC_4]);
             extend = true;
         }
-        else if (LastActuatedTime["WC_4"] < passageTimePerLane["WC_4"])
+        else if (lastActuated[WC_4] < passage[WC_4])
         {
             nextGreenInterval = phase3_8;
             nextInterval = "grgrrgrgrygrgrrgrgrGrrrr";
             extend = false;
         }
-        else if (LastActuatedTime["EC_4"] < passageTimePerLane["EC_4"])
+        else if (lastActuated[EC_4] < passage[EC_4])
         {
             nextGreenInterval = phase4_7;
             nextInterval = "grgrrgrgrGgrgrrgrgryrrrr";
@@ -429,9 +452,9 @@ void TrafficLightActuated::chooseNextGreenInterval(std::string TLid)
     else if (currentInterval == phase3_8)
     {
         if (greenExtension && intervalElapseTime < maxGreenTime &&
-                LastActuatedTime["WC_4"] < passageTimePerLane["WC_4"])
+                lastActuated[WC_4] < passage[WC_4])
         {
-            intervalDuration = passageTimePerLane["WC_4"] - LastActuatedTime["WC_4"];
+            intervalDuration = passage[WC_4] - lastActuated[WC_4];
             extend = true;
         }
         else
@@ -444,9 +467,9 @@ void TrafficLightActuated::chooseNextGreenInterval(std::string TLid)
     else if (currentInterval == phase4_7)
     {
         if (greenExtension && intervalElapseTime < maxGreenTime &&
-                LastActuatedTime["EC_4"] < passageTimePerLane["EC_4"])
+                lastActuated[EC_4] < passage[EC_4])
         {
-            intervalDuration = passageTimePerLane["EC_4"] - LastActuatedTime["EC_4"];
+            intervalDuration = passage[EC_4] - lastActuated[EC_4];
             extend = true;
         }
         else
@@ -459,13 +482,13 @@ void TrafficLightActuated::chooseNextGreenInterval(std::string TLid)
     else if (currentInterval == phase4_8)
     {
         if (greenExtension && intervalElapseTime < maxGreenTime &&
-                (LastActuatedTime["WC_2"] < passageTimePerLane["WC_2"] ||
-                        LastActuatedTime["WC_3"] < passageTimePerLane["WC_3"] ||
-                        LastActuatedTime["EC_2"] < passageTimePerLane["EC_2"] ||
-                        LastActuatedTime["EC_3"] < passageTimePerLane["EC_3"]))
+                (lastActuated[WC_2] < passage[WC_2] ||
+                        lastActuated[WC_3] < passage[WC_3] ||
+                        lastActuated[EC_2] < passage[EC_2] ||
+                        lastActuated[EC_3] < passage[EC_3]))
         {
-            double biggest1 = std::max(passageTimePerLane["WC_2"]-LastActuatedTime["WC_2"], passageTimePerLane["EC_2"]-LastActuatedTime["EC_2"]);
-            double biggest2 = std::max(passageTimePerLane["WC_3"]-LastActuatedTime["WC_3"], passageTimePerLane["EC_3"]-LastActuatedTime["EC_3"]);
+            double biggest1 = std::max(passage[WC_2]-lastActuated[WC_2], passage[EC_2]-lastActuated[EC_2]);
+            double biggest2 = std::max(passage[WC_3]-lastActuated[WC_3], passage[EC_3]-lastActuated[EC_3]);
             intervalDuration = std::max(biggest1, biggest2);
             extend = true;
         }
@@ -48,9 +48,6 @@ private:
 
     omnetpp::cMessage* intervalChangeEVT = NULL;
 
-    // class variables
-    std::map<std::string,double> passageTimePerLane;
-
     // list of all traffic lights in the network
     std::vector<std::string> TLList;
 
@@ -59,6 +56,29 @@ private:
     // loop detector ids used for actuated-time signal control
     std::unordered_map<std::string /*lane*/, std::string /*LD id*/> LD_actuated;
 
+    // incoming lanes that appear in the actuation rules of chooseNextGreenInterval
+    enum actuatedLane { NC_2, NC_3, NC_4, EC_2, EC_3, EC_4, SC_2, SC_3, SC_4, WC_2, WC_3, WC_4, actuatedLaneCount };
+    std::vector<std::string> actuatedLaneNames = {"NC_2", "NC_3", "NC_4", "EC_2", "EC_3", "EC_4", "SC_2", "SC_3", "SC_4", "WC_2", "WC_3", "WC_4"};
+
+    typedef struct actuatedLD
+    {
+        std::string lane;
+        std::string LDid;
+        int LDindex;
+        double LDPos;           // position of the loop detector from end of lane
+        double passageTime;     // updated as vehicles pass the loop detector
+        int slot;               // actuatedLane of this lane, -1 if it is not used in the actuation rules
+    } actuatedLD_t;
+
+    // indexed by the loop detector index in TraCI, NULL if not an actuated LD
+    std::vector<actuatedLD_t *> LDindex2actuated;
+    std::vector<actuatedLD_t> actuatedLDs;
+
+    // passage time and elapsed time since the last actuation per actuatedLane.
+    // Both stay 0 on lanes without an actuated LD
+    double passage[actuatedLaneCount];
+    double lastActuated[actuatedLaneCount];
+
 public:
     virtual ~TrafficLightActuated();
     virtual void initialize(int);
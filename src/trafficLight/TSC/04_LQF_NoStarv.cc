@@ -24,8 +24,6 @@
 // Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 //
 
-#include <queue>
-
 #include "trafficLight/TSC/04_LQF_NoStarv.h"
 
 namespace VENTOS {
@@ -104,23 +102,29 @@ void TrafficLightLQF_NoStarv::initialize_withTraCI()
 
         incomingLanes_perTL[TL] = lan;
 
-        // get all links controlled by this TL
-        auto result = TraCI->TLGetControlledLinks(TL);
-
-        // for each link in this TLid
-        for(auto &it : result)
-        {
-            int linkNumber = it.first;
-            std::vector<std::string> link = it.second;
-            std::string incommingLane = link[0];
-
-            link2Lane.insert( std::make_pair(std::make_pair(TL,linkNumber), incommingLane) );
-        }
     }
 
     // get all non-conflicting movements in allMovements vector
     allMovements = TrafficLightAllowedMoves::getMovements("C");
 
+    movementStates.clear();
+    for(auto &row : allMovements)
+    {
+        std::string state = "";
+        for(unsigned int linkNumber = 0; linkNumber < row.size(); ++linkNumber)
+            state += (row[linkNumber] == 0) ? 'r' : (isRightTurn(linkNumber) ? 'g' : 'G');
+
+        movementStates.push_back(state);
+    }
+
+    for (auto &TL : TLList)
+    {
+        PhaseScoring &scoring = queueScoring[TL];
+        initPhaseScoring(scoring, TL);
+        for(auto &row : allMovements)
+            scoring.addPhase(row);
+    }
+
     // calculate phases at the beginning of the cycle
     calculatePhases("C");
 
@@ -247,6 +251,24 @@ void TrafficLightLQF_NoStarv::chooseNextGreenInterval(std::string TLid)
 }
 
 
+void TrafficLightLQF_NoStarv::initPhaseScoring(PhaseScoring &scoring, const std::string &TLid)
+{
+    uint64_t rightTurns = 0;
+    for(unsigned int linkNumber = 0; linkNumber < 64; ++linkNumber)
+        if(isRightTurn(linkNumber))
+            rightTurns |= (uint64_t)1 << linkNumber;
+
+    try
+    {
+        scoring.build(TraCI->TLGetControlledLinks(TLid), rightTurns);
+    }
+    catch(std::exception &e)
+    {
+        throw omnetpp::cRuntimeError("TL '%s': %s", TLid.c_str(), e.what());
+    }
+}
+
+
 // calculate all phases (up to 4)
 void TrafficLightLQF_NoStarv::calculatePhases(std::string TLid)
 {
@@ -269,133 +291,40 @@ void TrafficLightLQF_NoStarv::calculatePhases(std::string TLid)
         LOG_DEBUG << "\n";
     }
 
-    priorityQ sortedMovements;
+    auto it = queueScoring.find(TLid);
+    if(it == queueScoring.end())
+        throw omnetpp::cRuntimeError("cannot find TL '%s' in queueScoring", TLid.c_str());
+    PhaseScoring &scoring = it->second;
 
-    for(unsigned int i = 0; i < allMovements.size(); ++i)  // row
+    // the load of a lane is its queue size
+    const std::vector<std::string> &lanes = scoring.getLanes();
+    std::vector<laneLoad_t> &loads = scoring.getLoads();
+    for(unsigned int i = 0; i < lanes.size(); ++i)
     {
-        int totalQueueRow = 0;  // total queue size for this batch of movements
-        int oneCount = 0;
-
-        // for each batch of movement get
-        // - 'total queue size' : total queue size
-        // - 'one count'        : # of allowed movements (except right turns)
-        // - 'maxVehCount'      : max queue size
-        int maxVehCount = 0;
-        for(unsigned int j = 0; j < allMovements[i].size(); ++j)  // column (link number)
-        {
-            if(allMovements[i][j] == 1 && !isRightTurn(j))
-            {
-                std::string lane = link2Lane[std::make_pair(TLid,j)];
-                auto queueSize = laneGetQueue(lane).queueSize;
-
-                totalQueueRow += queueSize;
-                oneCount++;
-                maxVehCount = std::max(maxVehCount, queueSize);
-            }
-        }
-
-        // add this batch of movements to priority_queue
-        sortedEntry_t entry = {oneCount, totalQueueRow, maxVehCount, allMovements[i]};
-        sortedMovements.push(entry);
+        loads[i] = laneLoad_t();
+        loads[i].count = laneGetQueue(lanes[i]).queueSize;
     }
 
-    // copy sortedMovements to a vector for iteration:
-    std::vector<sortedEntry_t> batchMovementVector;
-    while(!sortedMovements.empty())
-    {
-        batchMovementVector.push_back(sortedMovements.top());
-        sortedMovements.pop();
-    }
+    const std::vector<phaseScore_t> &scores = scoring.score();
 
-    // Select only the necessary phases for the new cycle:
-    while(!batchMovementVector.empty())
-    {
-        // Always select the first movement because it will be the best(?):
-        std::vector<int> bestMovement = batchMovementVector.front().batchMovements;
-
-        // calculate the next green interval.
-        // right-turns are all permissive and are given 'g'
-        std::string nextInterval = "";
-        for(unsigned linkNumber = 0; linkNumber < bestMovement.size(); ++linkNumber)
-        {
-            if(bestMovement[linkNumber] == 0)
-                nextInterval += 'r';
-            else if(bestMovement[linkNumber] == 1)
-            {
-                if(isRightTurn(linkNumber))
-                    nextInterval += 'g';
-                else
-                    nextInterval += 'G';
-            }
-        }
-
-        // todo: is this necessary?
-        // Avoid pushing "only permissive right turns" phase:
-        if (nextInterval == "grgrrgrgrrgrgrrgrgrrrrrr")
-        {
-            batchMovementVector.erase(batchMovementVector.begin());
-            continue;
-        }
-
-        greenIntervalEntry_t entry = {batchMovementVector.front().maxVehCount, 0.0, nextInterval};
-        greenInterval.push_back(entry);
-
-        // Now delete these movements because they should never occur again:
-        auto new_end = std::remove_if(batchMovementVector.begin(), batchMovementVector.end(), [bestMovement](const sortedEntry_t v) {
-            for (unsigned int linkNumber = 0; linkNumber < v.batchMovements.size(); linkNumber++)
-            {
-                // Ignore all permissive right turns since these are always green:
-                int rightTurns[8] = {0, 2, 5, 7, 10, 12, 15, 17};
-                bool rightTurn = std::find(std::begin(rightTurns), std::end(rightTurns), linkNumber) != std::end(rightTurns);
-
-                // Want to remove movements that have already been done:
-                if (!rightTurn && v.batchMovements[linkNumber] == 1 && bestMovement[linkNumber] == 1)
-                    return true;
-            }
+    // Select only the necessary phases for the new cycle. The batch of movements with the
+    // longest total queue is always selected, and the batches that share a green movement
+    // with it should never occur again
+    std::vector<int> cycle = scoring.cycleByQueue();
 
-            return false;
-        });
-
-        batchMovementVector.erase(new_end, batchMovementVector.end());
-    }
-
-    // calculate number of vehicles in the intersection
-    int vehCountIntersection = 0;
-    for (auto &i : greenInterval)
-        vehCountIntersection += i.maxVehCount;
-
-    // If intersection is empty, then run each green interval with minGreenTime:
-    if (vehCountIntersection == 0)
+    // phases with an empty queue get no green time, unless the intersection is empty
+    for(auto &green : scoring.cycleGreenTimes(cycle, minGreenTime, maxGreenTime))
     {
-        for (auto &i : greenInterval)
-            i.greenTime = minGreenTime;
-    }
-    else
-    {
-        for (auto &i : greenInterval)
-            i.greenTime = (double)i.maxVehCount * (minGreenTime / 5.);
+        greenIntervalEntry_t entry = {scores[green.first].maxVehCount, green.second, movementStates[green.first]};
+        greenInterval.push_back(entry);
     }
 
-    // If no green time (0s) is given to a phase, then this queue is empty and useless:
-    int oldSize = greenInterval.size();
-    auto rme = std::remove_if(greenInterval.begin(), greenInterval.end(), [](const greenIntervalEntry_t v) {
-        if (v.greenTime == 0.0)
-            return true;
-        else
-            return false; });
-    greenInterval.erase( rme, greenInterval.end() );
-
     // throw error if cycle contains more than 4 phases:
     if (greenInterval.size() > 4)
         throw omnetpp::cRuntimeError("cycle contains %d phases which is more than 4!", greenInterval.size());
 
-    int newSize = greenInterval.size();
-    if(oldSize != newSize)
-        LOG_DEBUG << "\n    " << oldSize - newSize << " phase(s) removed due to zero queue size! \n" << std::flush;
-
-    // make sure the green splits are bounded
-    for (auto &i : greenInterval)
-        i.greenTime = std::min(std::max(i.greenTime, minGreenTime), maxGreenTime);
+    if(cycle.size() != greenInterval.size())
+        LOG_DEBUG << "\n    " << cycle.size() - greenInterval.size() << " phase(s) removed due to zero queue size! \n" << std::flush;
 
     if(LOG_ACTIVE(DEBUG_LOG_VAL))
     {
@@ -28,6 +28,7 @@
 #define TRAFFICLIGHTLQFNOSTARV_H
 
 #include "trafficLight/TSC/03_TrafficActuated.h"
+#include "trafficLight/TSC/PhaseScoring.h"
 
 namespace VENTOS {
 
@@ -56,33 +57,13 @@ private:
     // list of all 'incoming lanes' in each TL
     std::unordered_map< std::string /*TLid*/, std::vector<std::string> > incomingLanes_perTL;
 
-    std::map<std::pair<std::string /*TLid*/, int /*link number*/>, std::string /*lane*/> link2Lane;
-
     std::vector< std::vector<int> > allMovements;
 
-    typedef struct sortedEntry
-    {
-        int oneCount;
-        int totalQueue;
-        int maxVehCount;
-        std::vector<int> batchMovements;
-    } sortedEntry_t;
+    // TL state of each row of allMovements. Right turns are permissive and are given 'g'
+    std::vector<std::string> movementStates;
 
-    typedef struct sortFunc
-    {
-        bool operator()(sortedEntry_t p1, sortedEntry_t p2)
-        {
-            if(p1.totalQueue < p2.totalQueue)
-                return true;
-            else if(p1.totalQueue == p2.totalQueue && p1.oneCount < p2.oneCount)
-                return true;
-            else
-                return false;
-        }
-    } sortFunc_t;
-
-    // batch of all non-conflicting movements, sorted by total queue size per batch
-    typedef std::priority_queue< sortedEntry_t /*type of each element*/, std::vector<sortedEntry_t> /*container*/, sortFunc_t > priorityQ;
+    // one row of allMovements per phase
+    std::map<std::string /*TLid*/, PhaseScoring> queueScoring;
 
 public:
     virtual ~TrafficLightLQF_NoStarv();
@@ -94,6 +75,9 @@ protected:
     void virtual initialize_withTraCI();
     void virtual executeEachTimeStep();
 
+    // shared by the queue-based TSCs
+    void initPhaseScoring(PhaseScoring &, const std::string &TLid);
+
 private:
     void chooseNextInterval(std::string);
     void chooseNextGreenInterval(std::string);
@@ -26,7 +26,6 @@
 
 #include <algorithm>
 #include <iomanip>
-#include <queue>
 
 #include "trafficLight/TSC/05_OJF.h"
 
@@ -101,19 +100,6 @@ void TrafficLightOJF::initialize_withTraCI()
         lan.erase( unique( lan.begin(), lan.end() ), lan.end() );
 
         incomingLanes_perTL[TL] = lan;
-
-        // get all links controlled by this TL
-        auto result = TraCI->TLGetControlledLinks(TL);
-
-        // for each link in this TLid
-        for(auto &it : result)
-        {
-            int linkNumber = it.first;
-            std::vector<std::string> link = it.second;
-            std::string incommingLane = link[0];
-
-            link2Lane.insert( std::make_pair(std::make_pair(TL,linkNumber), incommingLane) );
-        }
     }
 
     // set initial values
@@ -127,6 +113,11 @@ void TrafficLightOJF::initialize_withTraCI()
 
     for (auto &TL : TLList)
     {
+        PhaseScoring &scoring = phaseScoring[TL];
+        initPhaseScoring(scoring, TL);
+        for(auto &row : allMovements)
+            scoring.addPhase(row);
+
         TraCI->TLSetProgram(TL, "adaptive-time");
         TraCI->TLSetState(TL, currentInterval);
 
@@ -217,7 +208,7 @@ void TrafficLightOJF::chooseNextGreenInterval(std::string TLid)
             double totalDelay = 0;
             for(auto &veh : vehs)
             {
-                delayEntry_t *vehDelay = vehicleGetDelay(veh,TLid);
+                const delayEntry_t *vehDelay = vehicleGetDelay(veh,TLid);
                 if(vehDelay)
                     totalDelay += vehDelay->totalDelay;
             }
@@ -228,68 +219,43 @@ void TrafficLightOJF::chooseNextGreenInterval(std::string TLid)
         LOG_FLUSH;
     }
 
-    priorityQ sortedMovements;
+    auto it = phaseScoring.find(TLid);
+    if(it == phaseScoring.end())
+        throw omnetpp::cRuntimeError("cannot find TL '%s' in phaseScoring", TLid.c_str());
+    PhaseScoring &scoring = it->second;
 
-    // Calculate totalDelay and vehCount for each movement batch
-    for(unsigned int i = 0; i < allMovements.size(); ++i)  // row
+    // total delay and number of delayed vehicles on each incoming lane
+    const std::vector<std::string> &lanes = scoring.getLanes();
+    std::vector<laneLoad_t> &loads = scoring.getLoads();
+    for(unsigned int i = 0; i < lanes.size(); ++i)
     {
-        double totalDelayRow = 0;
-        int oneCount = 0;
-        int maxVehCount = 0;
+        laneLoad_t &load = loads[i];
+        load = laneLoad_t();
 
-        for(unsigned int linkNumber = 0; linkNumber < allMovements[i].size(); ++linkNumber)  // column (link number)
+        for(auto &veh : TraCI->laneGetLastStepVehicleIDs(lanes[i]))
         {
-            int vehCount = 0;
-            if(allMovements[i][linkNumber] == 1)
+            const delayEntry_t *vehDelay = vehicleGetDelay(veh,TLid);
+            if(vehDelay)
             {
-                // ignore this link if right turn
-                if(!isRightTurn(linkNumber))
-                {
-                    // get the corresponding lane for this link
-                    auto itt = link2Lane.find(std::make_pair(TLid,linkNumber));
-                    if(itt == link2Lane.end())
-                        throw omnetpp::cRuntimeError("linkNumber %s is not found in TL %s", linkNumber, TLid.c_str());
-                    std::string lane = itt->second;
-
-                    // get all vehicles on this lane
-                    auto vehs = TraCI->laneGetLastStepVehicleIDs(lane);
-
-                    for(auto &veh :vehs)
-                    {
-                        // total delay in this lane
-                        delayEntry_t *vehDelay = vehicleGetDelay(veh,TLid);
-                        if(vehDelay)
-                        {
-                            totalDelayRow += vehDelay->totalDelay;
-
-                            if(vehDelay->totalDelay > 0)
-                                vehCount++;
-                        }
-                    }
-                }
-
-                oneCount++;
-            }
+                load.delay += vehDelay->totalDelay;
 
-            maxVehCount = std::max(maxVehCount, vehCount);
+                if(vehDelay->totalDelay > 0)
+                    load.count++;
+            }
         }
-
-        // add this movement batch to priority_queue
-        sortedEntry_t entry = {oneCount, maxVehCount, totalDelayRow, allMovements[i]};
-        sortedMovements.push(entry);
     }
 
-    // get the movement batch with the highest delay
-    sortedEntry_t entry = sortedMovements.top();
+    // get the movement batch with the highest delay (ties are broken by oneCount)
+    const std::vector<phaseScore_t> &scores = scoring.score();
+    int best = scoring.bestByDelay();
 
     // allocate enough green time to move all delayed vehicle
-    int maxVehCount = entry.maxVehCount;
+    int maxVehCount = scores[best].maxVehCount;
     LOG_DEBUG << "\n    Maximum of " << maxVehCount << " vehicle(s) are waiting. \n" << std::flush;
 
-    double greenTime = (double)maxVehCount * (minGreenTime / 5.);
-    nextGreenTime = std::min(std::max(greenTime, minGreenTime), maxGreenTime);  // bound green time
+    nextGreenTime = PhaseScoring::boundedGreen(maxVehCount, minGreenTime, maxGreenTime);
 
-    std::vector<int> batchMovements = entry.batchMovements;
+    const std::vector<int> &batchMovements = allMovements[best];
 
     // calculate the next green interval.
     // right-turns are all permissive and are given 'g'
@@ -342,4 +308,52 @@ void TrafficLightOJF::chooseNextGreenInterval(std::string TLid)
     LOG_DEBUG << "------------------------------------------------------------------------------- \n" << std::flush;
 }
 
+
+// fills the lane loads from the queues of IntersectionQueue. The weight of a lane
+// comes from its per-class vehicle count, which is kept up to date as vehicles join
+// and leave the queue. Delays change every time step and are summed here
+void TrafficLightOJF::loadQueues(PhaseScoring &scoring, const std::string &TLid, bool withDelay)
+{
+    for(int c = classWeightById.size(); c < vehicleClassCount(); ++c)
+    {
+        auto loc = classWeight.find(vehicleClassName(c));
+        classWeightById.push_back(loc == classWeight.end() ? -1 : loc->second);
+    }
+
+    const std::vector<std::string> &lanes = scoring.getLanes();
+    std::vector<laneLoad_t> &loads = scoring.getLoads();
+    for(unsigned int i = 0; i < lanes.size(); ++i)
+    {
+        const queueInfoLane_t &queue = laneGetQueue(lanes[i]);
+
+        laneLoad_t &load = loads[i];
+        load = laneLoad_t();
+        load.count = queue.queueSize;
+
+        for(unsigned int c = 0; c < queue.classCount.size(); ++c)
+        {
+            if(queue.classCount[c] == 0)
+                continue;
+
+            if(classWeightById[c] < 0)
+                throw omnetpp::cRuntimeError("vehicle type %s does not have a weight in classWeight map!", vehicleClassName(c).c_str());
+
+            load.weight += queue.classCount[c] * classWeightById[c];
+        }
+
+        if(!withDelay)
+            continue;
+
+        for(int v : queue.vehs)
+        {
+            const delayEntry_t *vehDelay = vehicleGetDelay(queuedVehicle(v).id,TLid);
+            if(vehDelay)
+            {
+                load.delay += vehDelay->totalDelay;
+                load.maxDelay = std::max(load.maxDelay, vehDelay->waitingDelay);  // todo: should we consider waiting time only?
+            }
+        }
+    }
+}
+
 }
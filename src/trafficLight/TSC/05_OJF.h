@@ -28,6 +28,7 @@
 #define TRAFFICLIGHTOJF_H
 
 #include "trafficLight/TSC/04_LQF_NoStarv.h"
+#include "trafficLight/TSC/PhaseScoring.h"
 
 namespace VENTOS {
 
@@ -45,36 +46,16 @@ private:
 
     std::map<std::string /*TLid*/, std::string /*first green interval*/> firstGreen;
 
-    std::map<std::pair<std::string /*TLid*/, int /*link*/>, std::string /*lane*/> link2Lane;
-
     // list of all 'incoming lanes' in each TL
     std::unordered_map< std::string /*TLid*/, std::vector<std::string> > incomingLanes_perTL;
 
     std::vector< std::vector<int> > allMovements;
 
-    typedef struct sortedEntry
-    {
-        int oneCount;
-        int maxVehCount;
-        double totalDelay;
-        std::vector<int> batchMovements;
-    } sortedEntry_t;
-
-    typedef struct sortFunc
-    {
-        bool operator()(sortedEntry_t p1, sortedEntry_t p2)
-        {
-            if( p1.totalDelay < p2.totalDelay )
-                return true;
-            else if( p1.totalDelay == p2.totalDelay && p1.oneCount < p2.oneCount)
-                return true;
-            else
-                return false;
-        }
-    } sortFunc_t;
-
-    // batch of all non-conflicting movements, sorted by total vehicle delay per batch
-    typedef std::priority_queue< sortedEntry_t /*type of each element*/, std::vector<sortedEntry_t> /*container*/, sortFunc_t > priorityQ;
+    // one row of allMovements per phase
+    std::map<std::string /*TLid*/, PhaseScoring> phaseScoring;
+
+    // weight of each vehicle class (see IntersectionQueue::vehicleClassName), -1 if not in classWeight
+    std::vector<double> classWeightById;
 
 public:
     virtual ~TrafficLightOJF();
@@ -86,6 +67,9 @@ protected:
     void virtual initialize_withTraCI();
     void virtual executeEachTimeStep();
 
+    // shared by the max-weight TSCs
+    void loadQueues(PhaseScoring &, const std::string &TLid, bool withDelay);
+
 private:
     void chooseNextInterval(std::string);
     void chooseNextGreenInterval(std::string);
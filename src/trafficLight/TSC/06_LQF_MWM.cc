@@ -24,8 +24,6 @@
 // Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 //
 
-#include <queue>
-
 #include "trafficLight/TSC/06_LQF_MWM.h"
 
 namespace VENTOS {
@@ -103,18 +101,10 @@ void TrafficLight_LQF_MWM::initialize_withTraCI()
 
         incomingLanes_perTL[TLid] = lan;
 
-        // get all links controlled by this TL
-        auto result = TraCI->TLGetControlledLinks(TLid);
-
-        // for each link in this TLid
-        for(auto &it2 : result)
-        {
-            int linkNumber = it2.first;
-            std::vector<std::string> link = it2.second;
-            std::string incommingLane = link[0];
-
-            link2Lane.insert( std::make_pair(std::make_pair(TLid,linkNumber), incommingLane) );
-        }
+        PhaseScoring &scoring = phaseScoring[TLid];
+        initPhaseScoring(scoring, TLid);
+        for(auto &phase : phases)
+            scoring.addPhase(phase);
     }
 
     // set initial values
@@ -215,65 +205,24 @@ void TrafficLight_LQF_MWM::chooseNextGreenInterval(std::string TLid)
         LOG_DEBUG << "\n";
     }
 
-    priorityQ sortedMovements;
+    auto it = phaseScoring.find(TLid);
+    if(it == phaseScoring.end())
+        throw omnetpp::cRuntimeError("cannot find TL '%s' in phaseScoring", TLid.c_str());
+    PhaseScoring &scoring = it->second;
 
-    for(std::string phase : phases)
-    {
-        double totalWeight = 0;  // total weight for each batch
-        int oneCount = 0;
-        int maxVehCount = 0;
+    loadQueues(scoring, TLid, false);
 
-        for(unsigned int linkNumber = 0; linkNumber < phase.size(); ++linkNumber)
-        {
-            int vehCount = 0;
-            if(phase[linkNumber] == 'G')
-            {
-                // ignore this link if right turn
-                if(!isRightTurn(linkNumber))
-                {
-                    // get the corresponding lane for this link
-                    auto itt = link2Lane.find(std::make_pair(TLid,linkNumber));
-                    if(itt == link2Lane.end())
-                        throw omnetpp::cRuntimeError("linkNumber %d is not found in TL %s", linkNumber, TLid.c_str());
-                    std::string lane = itt->second;
-
-                    auto queuedVehs = laneGetQueue(lane).vehs;
-
-                    // for each vehicle
-                    for(auto &veh : queuedVehs)
-                    {
-                        // total weight of entities on this lane
-                        auto loc = classWeight.find(veh.type);
-                        if(loc == classWeight.end())
-                            throw omnetpp::cRuntimeError("entity %s with type %s does not have a weight in classWeight map!", veh.id.c_str(), veh.type.c_str());
-
-                        totalWeight += loc->second;
-                        vehCount++;
-                    }
-                }
-
-                // number of movements in this phase (including right turns)
-                oneCount++;
-            }
-
-            maxVehCount = std::max(maxVehCount, vehCount);
-        }
-
-        // add this batch of movements to priority_queue
-        sortedEntry_t entry = {totalWeight, oneCount, maxVehCount, phase};
-        sortedMovements.push(entry);
-    }
+    // get the phase with the highest total weight (ties are broken by oneCount)
+    const std::vector<phaseScore_t> &scores = scoring.score();
+    int best = scoring.bestByWeight();
 
-    // get the movement batch with the highest weight + delay + oneCount
-    sortedEntry_t entry = sortedMovements.top();
+    const phaseScore_t &entry = scores[best];
 
     // allocate enough green time to move all vehicles
-    int maxVehCount = entry.maxVehCount;
-    double greenTime = (double)maxVehCount * (minGreenTime / 5.);
-    nextGreenTime = std::min(std::max(greenTime, minGreenTime), maxGreenTime);  // bound green time
+    nextGreenTime = PhaseScoring::boundedGreen(entry.maxVehCount, minGreenTime, maxGreenTime);
 
     // this will be the next green interval
-    nextGreenInterval = entry.phase;
+    nextGreenInterval = phases[best];
 
     // calculate 'next interval'
     std::string nextInterval = "";
@@ -300,7 +249,7 @@ void TrafficLight_LQF_MWM::chooseNextGreenInterval(std::string TLid)
         updateTLstate(TLid, "yellow");
 
         LOG_DEBUG << boost::format("\n    The following phase has the highest totalWeight out of %1% phases: \n") % phases.size();
-        LOG_DEBUG << "        phase= " << entry.phase.c_str();
+        LOG_DEBUG << "        phase= " << phases[best];
         LOG_DEBUG << ", maxVehCount= " << entry.maxVehCount;
         LOG_DEBUG << ", totalWeight= " << entry.totalWeight;
         LOG_DEBUG << ", oneCount= " << entry.oneCount;
@@ -103,18 +103,10 @@ void TrafficLight_LQF_MWM_Aging::initialize_withTraCI()
 
         incomingLanes_perTL[TLid] = lan;
 
-        // get all links controlled by this TL
-        auto result = TraCI->TLGetControlledLinks(TLid);
-
-        // for each link in this TLid
-        for(auto &it2 : result)
-        {
-            int linkNumber = it2.first;
-            std::vector<std::string> link = it2.second;
-            std::string incommingLane = link[0];
-
-            link2Lane.insert( std::make_pair(std::make_pair(TLid,linkNumber), incommingLane) );
-        }
+        PhaseScoring &scoring = phaseScoring[TLid];
+        initPhaseScoring(scoring, TLid);
+        for(auto &phase : phases)
+            scoring.addPhase(phase);
     }
 
     // set initial values
@@ -215,12 +207,11 @@ void TrafficLight_LQF_MWM_Aging::chooseNextGreenInterval(std::string TLid)
         LOG_DEBUG << "\n\n    Total delay of vehicles on each lane: \n";
         for(auto &lane : it->second)
         {
-            auto vehs = laneGetQueue(lane).vehs;
-
             double totalDelay = 0;
-            for(auto &veh : vehs)
+            for(int v : laneGetQueue(lane).vehs)
             {
-                delayEntry_t *vehDelay = vehicleGetDelay(veh.id,TLid);
+                const vehInfo_t &veh = queuedVehicle(v);
+                const delayEntry_t *vehDelay = vehicleGetDelay(veh.id,TLid);
                 if(vehDelay)
                     totalDelay += vehDelay->totalDelay;
             }
@@ -232,100 +223,28 @@ void TrafficLight_LQF_MWM_Aging::chooseNextGreenInterval(std::string TLid)
         LOG_FLUSH;
     }
 
-    priorityQ_weight sortedMovements;
-    priorityQ_delay maxDelayPerPhase;
-
-    for(std::string phase : phases)
-    {
-        double totalWeight = 0;  // total weight for each batch
-        int oneCount = 0;
-        int maxVehCount = 0;
-        double maxDelay = 0;
-
-        for(unsigned int linkNumber = 0; linkNumber < phase.size(); ++linkNumber)
-        {
-            int vehCount = 0;
-            if(phase[linkNumber] == 'G')
-            {
-                // ignore this link if right turn
-                if(!isRightTurn(linkNumber))
-                {
-                    // get the corresponding lane for this link
-                    auto itt = link2Lane.find(std::make_pair(TLid,linkNumber));
-                    if(itt == link2Lane.end())
-                        throw omnetpp::cRuntimeError("linkNumber %d is not found in TL %s", linkNumber, TLid.c_str());
-                    std::string lane = itt->second;
-
-                    auto queuedVehs = laneGetQueue(lane).vehs;
-
-                    for(auto &veh : queuedVehs)
-                    {
-                        // total weight of entities on this lane
-                        auto loc = classWeight.find(veh.type);
-                        if(loc == classWeight.end())
-                            throw omnetpp::cRuntimeError("entity %s with type %s does not have a weight in classWeight map!", veh.id.c_str(), veh.type.c_str());
-
-                        totalWeight += loc->second;
-
-                        // max delay in this movement
-                        delayEntry_t *vehDelay = vehicleGetDelay(veh.id,TLid);
-                        if(vehDelay)
-                            maxDelay = std::max(maxDelay, vehDelay->waitingDelay);  // todo: should we consider waiting time only?
-
-                        vehCount++;
-                    }
-                }
-
-                // number of movements in this phase (including right turns)
-                oneCount++;
-            }
-
-            maxVehCount = std::max(maxVehCount, vehCount);
-        }
+    auto it = phaseScoring.find(TLid);
+    if(it == phaseScoring.end())
+        throw omnetpp::cRuntimeError("cannot find TL '%s' in phaseScoring", TLid.c_str());
+    PhaseScoring &scoring = it->second;
 
-        // add this batch of movements to sortedMovements
-        sortedEntry_weight_t entry = {totalWeight, oneCount, maxVehCount, phase};
-        sortedMovements.push(entry);
+    loadQueues(scoring, TLid, true);
 
-        // add this batch of movements to maxDelayPerPhase
-        sortedEntry_delay_t entry2 = {totalWeight, oneCount, maxVehCount, maxDelay, phase};
-        maxDelayPerPhase.push(entry2);
-    }
+    const std::vector<phaseScore_t> &scores = scoring.score();
 
-    // get the movement batch with the highest weight + delay + oneCount
-    sortedEntry_weight_t bestChoice = sortedMovements.top();
+    // get the movement batch with the highest weight + oneCount
+    int bestChoice = scoring.bestByWeight();
 
     // bestChoice is the phase with the highest total weight, but not necessarily the longest delay.
-    // We need to check the max delay in each phase too!
-    sortedEntry_weight_t finalChoice = bestChoice;
-    double maxDelay = 0;
-    while(!maxDelayPerPhase.empty())
-    {
-        maxDelay = maxDelayPerPhase.top().maxDelay;
-
-        // do we exceed the 'max delay = 20s' in a phase?
-        if(maxDelay + yellowTime + redTime > 20)
-        {
-            sortedEntry_delay_t delayChoice = maxDelayPerPhase.top();
-
-            finalChoice.totalWeight = delayChoice.totalWeight;
-            finalChoice.oneCount = delayChoice.oneCount;
-            finalChoice.maxVehCount = delayChoice.maxVehCount;
-            finalChoice.phase = delayChoice.phase;
-
-            break;
-        }
-
-        maxDelayPerPhase.pop();
-    }
+    // The phase with the longest delay is chosen if we exceed 'max delay' in it
+    int finalChoice = scoring.bestByWeightAging(yellowTime + redTime);
+    double maxDelay = scores[finalChoice].maxDelay;
 
     // allocate enough green time to move all vehicles
-    int maxVehCount = finalChoice.maxVehCount;
-    double greenTime = (double)maxVehCount * (minGreenTime / 5.);
-    nextGreenTime = std::min(std::max(greenTime, minGreenTime), maxGreenTime);  // bound green time
+    nextGreenTime = PhaseScoring::boundedGreen(scores[finalChoice].maxVehCount, minGreenTime, maxGreenTime);
 
     // this will be the next green interval
-    nextGreenInterval = finalChoice.phase;
+    nextGreenInterval = phases[finalChoice];
 
     // calculate 'next interval'
     std::string nextInterval = "";
@@ -356,12 +275,12 @@ void TrafficLight_LQF_MWM_Aging::chooseNextGreenInterval(std::string TLid)
             LOG_DEBUG << boost::format("\n    The following phase has the highest totalWeight out of %1% phases: \n") % phases.size();
 
             LOG_DEBUG << boost::format("        phase= %1%, maxVehCount= %2%, totalWeight= %3%, oneCount= %4%, green= %5% \n")
-            % bestChoice.phase % bestChoice.maxVehCount % bestChoice.totalWeight % bestChoice.oneCount % nextGreenTime;
+            % phases[bestChoice] % scores[bestChoice].maxVehCount % scores[bestChoice].totalWeight % scores[bestChoice].oneCount % nextGreenTime;
 
-            if(bestChoice.phase != finalChoice.phase)
+            if(bestChoice != finalChoice)
             {
                 LOG_DEBUG << boost::format("\n    But it will not be scheduled! ");
-                LOG_DEBUG << boost::format("\n    Because max delay in phase %1% (= %2%) will exceed %3%s \n") % finalChoice.phase % maxDelay % 20;
+                LOG_DEBUG << boost::format("\n    Because max delay in phase %1% (= %2%) will exceed %3%s \n") % phases[finalChoice] % maxDelay % PhaseScoring::maxWaitingTime;
             }
 
             LOG_FLUSH;
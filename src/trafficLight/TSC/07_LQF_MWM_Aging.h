@@ -27,8 +27,6 @@
 #ifndef TRAFFICLIGHTLQFMWMAGING_H
 #define TRAFFICLIGHTLQFMWMAGING_H
 
-#include <queue>
-
 #include "trafficLight/TSC/06_LQF_MWM.h"
 
 namespace VENTOS {
@@ -50,62 +48,12 @@ private:
 
     std::map<std::string /*TLid*/, std::string /*first green interval*/> firstGreen;
 
-    std::map<std::pair<std::string /*TLid*/, int /*link*/>, std::string /*lane*/> link2Lane;
+    // one entry of 'phases' per phase
+    std::map<std::string /*TLid*/, PhaseScoring> phaseScoring;
 
     // list of all 'incoming lanes' in each TL
     std::unordered_map< std::string /*TLid*/, std::vector<std::string> > incomingLanes_perTL;
 
-    typedef struct sortedEntry_weight
-    {
-        double totalWeight;
-        int oneCount;
-        int maxVehCount;
-        std::string phase;
-    } sortedEntry_weight_t;
-
-    typedef struct sortFunc_weight
-    {
-        bool operator()(sortedEntry_weight_t p1, sortedEntry_weight_t p2)
-        {
-            if( p1.totalWeight < p2.totalWeight )
-                return true;
-            else if( p1.totalWeight == p2.totalWeight && p1.oneCount < p2.oneCount)
-                return true;
-            else
-                return false;
-        }
-    } sortFunc_weight_t;
-
-    // batch of all non-conflicting movements, sorted by total weight + oneCount per batch
-    typedef std::priority_queue< sortedEntry_weight_t /*type of each element*/, std::vector<sortedEntry_weight_t> /*container*/, sortFunc_weight_t > priorityQ_weight;
-
-    typedef struct sortedEntry_delay
-    {
-        double totalWeight;
-        int oneCount;
-        int maxVehCount;
-        double maxDelay;
-        std::string phase;
-    } sortedEntry_delay_t;
-
-    typedef struct sortFunc_delay
-    {
-        bool operator()(sortedEntry_delay_t n1, sortedEntry_delay_t n2)
-        {
-            if (n1.maxDelay < n2.maxDelay)
-                return true;
-            else if (n1.maxDelay == n2.maxDelay && n1.totalWeight < n2.totalWeight)
-                return true;
-            else if (n1.maxDelay == n2.maxDelay && n1.totalWeight == n2.totalWeight && n1.oneCount < n2.oneCount)
-                return true;
-            else
-                return false;
-        }
-    } sortFunc_delay_t;
-
-    // second priority queue to sort the maximum delay in each phase
-    typedef std::priority_queue< sortedEntry_delay_t, std::vector<sortedEntry_delay_t>, sortFunc_delay_t > priorityQ_delay;
-
 public:
     virtual ~TrafficLight_LQF_MWM_Aging();
     virtual void initialize(int);
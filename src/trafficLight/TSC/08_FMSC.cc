@@ -24,8 +24,6 @@
 // Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 //
 
-#include <queue>
-
 #include <trafficLight/TSC/08_FMSC.h>
 
 namespace VENTOS {
@@ -110,18 +108,10 @@ void TrafficLight_FMSC::initialize_withTraCI()
 
         incomingLanes_perTL[TLid] = lan;
 
-        // get all links controlled by this TL
-        auto result = TraCI->TLGetControlledLinks(TLid);
-
-        // for each link in this TLid
-        for(auto &it2 : result)
-        {
-            int linkNumber = it2.first;
-            std::vector<std::string> link = it2.second;
-            std::string incommingLane = link[0];
-
-            link2Lane.insert( std::make_pair(std::make_pair(TLid,linkNumber), incommingLane) );
-        }
+        PhaseScoring &scoring = phaseScoring[TLid];
+        initPhaseScoring(scoring, TLid);
+        for(auto &phase : phases)
+            scoring.addPhase(phase);
     }
 
     // calculate phases at the beginning of the cycle
@@ -262,12 +252,11 @@ void TrafficLight_FMSC::calculatePhases(std::string TLid)
         LOG_DEBUG << "\n\n    Total delay of vehicles on each lane: \n";
         for(auto &lane : it->second)
         {
-            auto vehs = laneGetQueue(lane).vehs;
-
             double totalDelay = 0;
-            for(auto &veh : vehs)
+            for(int v : laneGetQueue(lane).vehs)
             {
-                delayEntry_t *vehDelay = vehicleGetDelay(veh.id,TLid);
+                const vehInfo_t &veh = queuedVehicle(v);
+                const delayEntry_t *vehDelay = vehicleGetDelay(veh.id,TLid);
                 if(vehDelay)
                     totalDelay += vehDelay->totalDelay;
             }
@@ -279,132 +268,30 @@ void TrafficLight_FMSC::calculatePhases(std::string TLid)
         LOG_FLUSH;
     }
 
-    priorityQ sortedMovements;
-
-    for(std::string phase : phases)
-    {
-        double totalWeight = 0;  // total weight of all waiting entities in all movements in this phase
-        double totalDelay = 0;  // total delay of all waiting entities in all movements in this phase
-        int oneCount = 0;
-        int maxVehCount = 0;
-
-        for(unsigned int linkNumber = 0; linkNumber < phase.size(); ++linkNumber)
-        {
-            int vehCount = 0;
-            if(phase[linkNumber] == 'G')
-            {
-                // ignore this link if right turn
-                if(!isRightTurn(linkNumber))
-                {
-                    // get the corresponding lane for this link
-                    auto itt = link2Lane.find(std::make_pair(TLid,linkNumber));
-                    if(itt == link2Lane.end())
-                        throw omnetpp::cRuntimeError("linkNumber %s is not found in TL %s", linkNumber, TLid.c_str());
-                    std::string lane = itt->second;
-
-                    auto queuedVehs = laneGetQueue(lane).vehs;
-
-                    for(auto &veh : queuedVehs)
-                    {
-                        // total weight of entities on this lane
-                        auto loc = classWeight.find(veh.type);
-                        if(loc == classWeight.end())
-                            throw omnetpp::cRuntimeError("entity %s with type %s does not have a weight in classWeight map!", veh.id.c_str(), veh.type.c_str());
-
-                        totalWeight += loc->second;
-
-                        // total delay in this lane
-                        delayEntry_t *vehDelay = vehicleGetDelay(veh.id,TLid);
-                        if(vehDelay)
-                            totalDelay += vehDelay->totalDelay;
-
-                        vehCount++;
-                    }
-                }
-
-                // number of movements in this phase (including right turns)
-                oneCount++;
-            }
+    auto it = phaseScoring.find(TLid);
+    if(it == phaseScoring.end())
+        throw omnetpp::cRuntimeError("cannot find TL '%s' in phaseScoring", TLid.c_str());
+    PhaseScoring &scoring = it->second;
 
-            maxVehCount = std::max(maxVehCount, vehCount);
-        }
+    loadQueues(scoring, TLid, true);
 
-        // add this batch of movements to priority_queue
-        sortedEntry_t entry = {totalWeight, totalDelay, oneCount, maxVehCount, phase};
-        sortedMovements.push(entry);
-    }
+    const std::vector<phaseScore_t> &scores = scoring.score();
 
-    // copy sortedMovements to a vector for iteration:
-    std::vector<sortedEntry_t> batchMovementVector;
-    while(!sortedMovements.empty())
-    {
-        batchMovementVector.push_back(sortedMovements.top());
-        sortedMovements.pop();
-    }
+    // Select only the necessary phases for the new cycle. The best phase is always
+    // selected, and the phases that share a green movement with it should never occur again
+    std::vector<int> cycle = scoring.cycleByWeight();
 
-    // Select only the necessary phases for the new cycle:
-    while(!batchMovementVector.empty())
+    // phases with an empty queue get no green time, unless the intersection is empty
+    for(auto &green : scoring.cycleGreenTimes(cycle, minGreenTime, maxGreenTime))
     {
-        // Always select the first movement because it will be the best(?):
-        sortedEntry_t entry = batchMovementVector.front();
-        std::string nextInterval = entry.phase;
+        const phaseScore_t &entry = scores[green.first];
 
-        greenIntervalEntry_t entry2 = {entry.maxVehCount, entry.totalWeight, entry.oneCount, 0.0, entry.phase};
+        greenIntervalEntry_t entry2 = {entry.maxVehCount, entry.totalWeight, entry.oneCount, green.second, phases[green.first]};
         greenInterval.push_back(entry2);
-
-        // Now delete these movements because they should never occur again:
-        auto new_end = std::remove_if(batchMovementVector.begin(), batchMovementVector.end(), [nextInterval](const sortedEntry_t v) {
-
-            std::string phase = v.phase;
-
-            for(unsigned int i = 0; i < phase.size(); i++)
-            {
-                if (phase[i] == 'G' && nextInterval[i] == 'G')
-                    return true;
-            }
-
-            return false;
-        });
-
-        batchMovementVector.erase(new_end, batchMovementVector.end());
-    }
-
-    // calculate number of vehicles in the intersection
-    int vehCountIntersection = 0;
-    for (auto &i : greenInterval)
-        vehCountIntersection += i.maxVehCount;
-
-    // If intersection is empty, then run each green interval with minGreenTime:
-    if (vehCountIntersection == 0)
-    {
-        for (auto &i : greenInterval)
-            i.greenTime = minGreenTime;
-    }
-    else
-    {
-        for (auto &i : greenInterval)
-            i.greenTime = (double)i.maxVehCount * (minGreenTime / 5.);
     }
 
-    // If no green time (0s) is given to a phase, then this queue is empty and useless:
-    int oldSize = greenInterval.size();
-    auto rme = std::remove_if(greenInterval.begin(), greenInterval.end(),
-            [](const greenIntervalEntry_t v) {
-        if (v.greenTime == 0.0)
-            return true;
-        else
-            return false;
-    });
-
-    greenInterval.erase(rme, greenInterval.end());
-
-    int newSize = greenInterval.size();
-    if(oldSize != newSize)
-        LOG_DEBUG << "\n    " << oldSize - newSize << " phase(s) removed due to zero queue size! \n" << std::flush;
-
-    // make sure the green splits are bounded
-    for (auto &i : greenInterval)
-        i.greenTime = std::min(std::max(i.greenTime, minGreenTime), maxGreenTime);
+    if(cycle.size() != greenInterval.size())
+        LOG_DEBUG << "\n    " << cycle.size() - greenInterval.size() << " phase(s) removed due to zero queue size! \n" << std::flush;
 
     if(LOG_ACTIVE(DEBUG_LOG_VAL))
     {
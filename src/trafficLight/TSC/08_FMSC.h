@@ -59,38 +59,12 @@ private:
 
     std::map<std::string /*TLid*/, std::string /*first green interval*/> firstGreen;
 
-    std::map<std::pair<std::string /*TLid*/, int /*link*/>, std::string /*lane*/> link2Lane;
+    // one entry of 'phases' per phase
+    std::map<std::string /*TLid*/, PhaseScoring> phaseScoring;
 
     // list of all 'incoming lanes' in each TL
     std::unordered_map< std::string /*TLid*/, std::vector<std::string> > incomingLanes_perTL;
 
-    typedef struct sortedEntry
-    {
-        double totalWeight;
-        double totalDelay;
-        int oneCount;
-        int maxVehCount;
-        std::string phase;
-    } sortedEntry_t;
-
-    typedef struct sortFunc
-    {
-        bool operator()(sortedEntry_t p1, sortedEntry_t p2)
-        {
-            if( p1.totalWeight < p2.totalWeight )
-                return true;
-            else if( p1.totalWeight == p2.totalWeight && p1.totalDelay < p2.totalDelay)
-                return true;
-            else if( p1.totalWeight == p2.totalWeight && p1.totalDelay == p2.totalDelay && p1.oneCount < p2.oneCount)
-                return true;
-            else
-                return false;
-        }
-    } sortFunc_t;
-
-    // batch of all non-conflicting movements, sorted by total weight + oneCount per batch
-    typedef std::priority_queue< sortedEntry_t /*type of each element*/, std::vector<sortedEntry_t> /*container*/, sortFunc_t > priorityQ;
-
 public:
     virtual ~TrafficLight_FMSC();
     virtual void initialize(int);
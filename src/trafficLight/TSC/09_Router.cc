@@ -168,6 +168,7 @@ void TrafficLightRouter::build(std::string id, std::string type, std::string pro
     done = false;
     currentPhase = 0;
     lastSwitchTime = 0;
+    currentDuration = phases.empty() ? 0 : phases[0]->duration;
     cycleDuration = 0;
     //isTransitionPhase = false;
     nonTransitionalCycleDuration = 0;
@@ -178,6 +179,8 @@ void TrafficLightRouter::build(std::string id, std::string type, std::string pro
         if(i % 2 == 0)
             nonTransitionalCycleDuration += phases[i]->duration;
     }
+
+    updateTiming();
 }
 
 void TrafficLightRouter::initialize(int stage)
@@ -223,6 +226,7 @@ void TrafficLightRouter::initialize(int stage)
         }
 
         currentPhase = 0;
+        updateTiming();
     }
 }
 
@@ -306,6 +310,8 @@ void TrafficLightRouter::handleMessage(omnetpp::cMessage* msg)
             }
 
             lastSwitchTime = omnetpp::simTime().dbl();
+            currentDuration = nextDuration;
+            updateTiming();
 
             TraCI->TLSetPhaseDuration(id, 10000000);
 
@@ -402,6 +408,8 @@ void TrafficLightRouter::HighDensityRecalculate()
                 phases[i]->duration = duration; //Update durations. These will take affect starting with the next phase
             }
         }
+
+        updateTiming();
     }
 }
 
@@ -635,18 +643,28 @@ void TrafficLightRouter::print() // Print a node
 
 int TrafficLightRouter::currentPhaseAtTime(double time, double* timeRemaining)
 {
-    int phase = currentPhase;
-    int curTime = lastSwitchTime + phases[phase]->duration; //Start at the next switch
-    while(time >= curTime)  //While the time requested is less than curTime. When this breaks, our phase is set to the current phase
-    {
-        phase = (phase + 1) % phases.size();  //Move to the next phase
-        curTime += phases[phase]->duration; //And add that duration to curTime
-    }
+    return Net::phaseAtTime(timing, time, timeRemaining);
+}
+
+
+//Rebuilds the timeline. Its version only changes if the new timeline predicts other
+//phases, so that a regular switch to the next phase does not invalidate any hypertree
+void TrafficLightRouter::updateTiming()
+{
+    TLTiming_t updated;
+    updated.currentPhase = currentPhase;
+    updated.lastSwitchTime = lastSwitchTime;
+    updated.currentDuration = currentDuration;
+    for(auto &phase : phases)
+        updated.durations.push_back(phase->duration);
+
+    Net::compileTiming(updated);
 
-    if(timeRemaining != NULL)   //If timeRemaining was passed in
-        *timeRemaining = curTime - time;
+    updated.version = timing.version;
+    if(!timing.durations.empty() && !Net::samePlan(timing, updated))
+        updated.version++;
 
-    return phase;
+    timing = updated;
 }
 
 }
@@ -77,8 +77,10 @@ public:
 
     //Routing
     double lastSwitchTime;
+    double currentDuration; //Duration of the current phase (see switchToPhase)
     int currentPhase;
     int currentPhaseAtTime(double time, double* timeRemaining = NULL);
+    const TLTiming_t& getTiming() const { return timing; }
 
     //TL Control
     bool done;
@@ -105,6 +107,9 @@ private:
     Router* router;
     int nextDuration;
     int nextPhase;
+
+    TLTiming_t timing;  //Timeline of phases, rebuilt when currentPhase, lastSwitchTime or a duration changes
+    void updateTiming();
 };
 
 }
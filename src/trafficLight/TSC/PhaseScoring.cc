@@ -0,0 +1,349 @@
+/****************************************************************************/
+/// @file    PhaseScoring.cc
+/// @author  Mani Amoozadeh <maniam@ucdavis.edu>
+/// @author  second author name
+/// @date    October 2017
+///
+/****************************************************************************/
+// VENTOS, Vehicular Network Open Simulator; see http:?
+// Copyright (C) 2013-2015
+/****************************************************************************/
+//
+// This file is part of VENTOS.
+// VENTOS is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#include <stdexcept>
+#include <algorithm>
+#include <queue>
+
+#include "trafficLight/TSC/PhaseScoring.h"
+
+namespace VENTOS {
+
+constexpr double PhaseScoring::maxWaitingTime;
+
+
+void PhaseScoring::build(const std::map<int, std::vector<std::string>> &controlledLinks, uint64_t rightTurnMask)
+{
+    this->rightTurnMask = rightTurnMask;
+
+    numLinks = controlledLinks.empty() ? 0 : controlledLinks.rbegin()->first + 1;
+    if(numLinks > 64)
+        throw std::runtime_error("PhaseScoring: at most 64 links per TL are supported");
+
+    linkLane.assign(numLinks, -1);
+    lanes.clear();
+    phaseMasks.clear();
+
+    std::unordered_map<std::string, int> laneIndex;
+    for(auto &entry : controlledLinks)
+    {
+        if(entry.first < 0 || entry.second.empty())
+            continue;
+
+        const std::string &lane = entry.second[0];
+        auto it = laneIndex.find(lane);
+        if(it == laneIndex.end())
+        {
+            it = laneIndex.insert(std::make_pair(lane, (int)lanes.size())).first;
+            lanes.push_back(lane);
+        }
+
+        linkLane[entry.first] = it->second;
+    }
+
+    loads.assign(lanes.size(), laneLoad_t());
+    linkLoads.assign(numLinks, laneLoad_t());
+}
+
+
+int PhaseScoring::addPhase(const std::string &state)
+{
+    uint64_t mask = 0;
+    for(unsigned int linkNumber = 0; linkNumber < state.size() && (int)linkNumber < numLinks; ++linkNumber)
+        if(state[linkNumber] == 'G')
+            mask |= (uint64_t)1 << linkNumber;
+
+    return addPhaseMask(mask);
+}
+
+
+int PhaseScoring::addPhase(const std::vector<int> &movement)
+{
+    uint64_t mask = 0;
+    for(unsigned int linkNumber = 0; linkNumber < movement.size() && (int)linkNumber < numLinks; ++linkNumber)
+        if(movement[linkNumber] == 1)
+            mask |= (uint64_t)1 << linkNumber;
+
+    return addPhaseMask(mask);
+}
+
+
+int PhaseScoring::addPhaseMask(uint64_t mask)
+{
+    // every green link that carries load needs an incoming lane
+    for(uint64_t m = mask & ~rightTurnMask; m; m &= m - 1)
+    {
+        int linkNumber = __builtin_ctzll(m);
+        if(linkLane[linkNumber] == -1)
+            throw std::runtime_error("PhaseScoring: link " + std::to_string(linkNumber) + " has no incoming lane");
+    }
+
+    phaseMasks.push_back(mask);
+    scores.resize(phaseMasks.size());
+
+    return phaseMasks.size() - 1;
+}
+
+
+// The scores are the product of the (phases x links) green matrix and the link
+// loads. The matrix is sparse and stored as bitmasks, so we only visit the green links
+const std::vector<phaseScore_t> & PhaseScoring::score()
+{
+    for(int linkNumber = 0; linkNumber < numLinks; ++linkNumber)
+    {
+        int lane = linkLane[linkNumber];
+        bool rightTurn = (rightTurnMask >> linkNumber) & 1;
+        linkLoads[linkNumber] = (lane == -1 || rightTurn) ? laneLoad_t() : loads[lane];
+    }
+
+    for(unsigned int i = 0; i < phaseMasks.size(); ++i)
+    {
+        phaseScore_t &s = scores[i];
+        s = phaseScore_t();
+        s.oneCount = __builtin_popcountll(phaseMasks[i]);
+
+        for(uint64_t m = phaseMasks[i]; m; m &= m - 1)
+        {
+            const laneLoad_t &load = linkLoads[__builtin_ctzll(m)];
+
+            s.totalWeight += load.weight;
+            s.totalDelay += load.delay;
+            s.maxDelay = std::max(s.maxDelay, load.maxDelay);
+            s.maxVehCount = std::max(s.maxVehCount, load.count);
+            s.totalCount += load.count;
+        }
+    }
+
+    return scores;
+}
+
+
+
+int PhaseScoring::bestByWeight() const
+{
+    int best = 0;
+    for(unsigned int i = 1; i < scores.size(); ++i)
+    {
+        if( scores[best].totalWeight < scores[i].totalWeight ||
+                (scores[best].totalWeight == scores[i].totalWeight && scores[best].oneCount < scores[i].oneCount) )
+            best = i;
+    }
+
+    return best;
+}
+
+
+int PhaseScoring::bestByDelay() const
+{
+    int best = 0;
+    for(unsigned int i = 1; i < scores.size(); ++i)
+    {
+        if( scores[best].totalDelay < scores[i].totalDelay ||
+                (scores[best].totalDelay == scores[i].totalDelay && scores[best].oneCount < scores[i].oneCount) )
+            best = i;
+    }
+
+    return best;
+}
+
+
+int PhaseScoring::bestByMaxDelay() const
+{
+    int best = 0;
+    for(unsigned int i = 1; i < scores.size(); ++i)
+    {
+        const phaseScore_t &b = scores[best];
+        const phaseScore_t &s = scores[i];
+
+        if( b.maxDelay < s.maxDelay ||
+                (b.maxDelay == s.maxDelay && b.totalWeight < s.totalWeight) ||
+                (b.maxDelay == s.maxDelay && b.totalWeight == s.totalWeight && b.oneCount < s.oneCount) )
+            best = i;
+    }
+
+    return best;
+}
+
+
+int PhaseScoring::bestByWeightAging(double clearanceTime) const
+{
+    int delayChoice = bestByMaxDelay();
+    if(scores[delayChoice].maxDelay + clearanceTime > maxWaitingTime)
+        return delayChoice;
+
+    return bestByWeight();
+}
+
+
+// the order of equal phases is the order in which a std::priority_queue pops them
+std::vector<int> PhaseScoring::cycleByWeight() const
+{
+    auto comp = [this](int p1, int p2) {
+        const phaseScore_t &s1 = scores[p1];
+        const phaseScore_t &s2 = scores[p2];
+
+        if( s1.totalWeight < s2.totalWeight )
+            return true;
+        else if( s1.totalWeight == s2.totalWeight && s1.totalDelay < s2.totalDelay)
+            return true;
+        else if( s1.totalWeight == s2.totalWeight && s1.totalDelay == s2.totalDelay && s1.oneCount < s2.oneCount)
+            return true;
+        else
+            return false;
+    };
+
+    std::priority_queue<int, std::vector<int>, decltype(comp)> sorted(comp);
+    for(unsigned int i = 0; i < scores.size(); ++i)
+        sorted.push(i);
+
+    std::vector<int> cycle;
+    uint64_t chosen = 0;
+    while(!sorted.empty())
+    {
+        int phase = sorted.top();
+        sorted.pop();
+
+        // right turns are green in many phases
+        uint64_t mask = phaseMasks[phase] & ~rightTurnMask;
+        if(mask & chosen)
+            continue;
+
+        cycle.push_back(phase);
+        chosen |= mask;
+    }
+
+    return cycle;
+}
+
+
+std::vector<int> PhaseScoring::cycleByQueue() const
+{
+    auto comp = [this](int p1, int p2) {
+        const phaseScore_t &s1 = scores[p1];
+        const phaseScore_t &s2 = scores[p2];
+
+        if( s1.totalCount < s2.totalCount )
+            return true;
+        else if( s1.totalCount == s2.totalCount && s1.oneCount < s2.oneCount)
+            return true;
+        else
+            return false;
+    };
+
+    std::priority_queue<int, std::vector<int>, decltype(comp)> sorted(comp);
+    for(unsigned int i = 0; i < scores.size(); ++i)
+        sorted.push(i);
+
+    std::vector<int> cycle;
+    uint64_t chosen = 0;
+    while(!sorted.empty())
+    {
+        int phase = sorted.top();
+        sorted.pop();
+
+        uint64_t mask = phaseMasks[phase] & ~rightTurnMask;
+        if(mask == 0 || (mask & chosen))
+            continue;
+
+        cycle.push_back(phase);
+        chosen |= mask;
+    }
+
+    return cycle;
+}
+
+
+std::vector<std::pair<int, double>> PhaseScoring::cycleGreenTimes(const std::vector<int> &cycle, double minGreen, double maxGreen) const
+{
+    int vehCountIntersection = 0;
+    for(int phase : cycle)
+        vehCountIntersection += scores[phase].maxVehCount;
+
+    std::vector<std::pair<int, double>> greenTimes;
+    for(int phase : cycle)
+    {
+        if(vehCountIntersection == 0)
+            greenTimes.push_back(std::make_pair(phase, minGreen));
+        else if(scores[phase].maxVehCount != 0)
+            greenTimes.push_back(std::make_pair(phase, boundedGreen(scores[phase].maxVehCount, minGreen, maxGreen)));
+    }
+
+    return greenTimes;
+}
+
+
+double PhaseScoring::boundedGreen(int maxVehCount, double minGreen, double maxGreen)
+{
+    double greenTime = (double)maxVehCount * (minGreen / 5.);
+    return std::min(std::max(greenTime, minGreen), maxGreen);
+}
+
+
+// the lost time of a phase is 1s of startup loss and 20% of its yellow and red intervals.
+// Only phases with demand are counted
+websterPlan_t PhaseScoring::webster(const std::vector<double> &critical, double changeInterval, double maxCycleLength, double minGreen, double maxGreen)
+{
+    websterPlan_t plan = websterPlan_t();
+
+    int activePhases = 0;
+    for(double y : critical)
+    {
+        plan.Y += y;
+        if(y != 0) activePhases++;
+    }
+
+    double totalLoss_i = 1.0 + (1 - 0.8) * changeInterval;
+    plan.totalLoss = totalLoss_i * activePhases;
+
+    // no demand in any direction. Give minGreen to each phase
+    if(plan.Y == 0)
+    {
+        plan.greenSplit.assign(critical.size(), minGreen);
+        return plan;
+    }
+
+    if(plan.Y < 0 || plan.Y >= 1)
+        return plan;
+
+    plan.cycle = ((1.5 * plan.totalLoss) + 5) / (1 - plan.Y);
+
+    // this happens when Y is too close to 1
+    if(plan.cycle > maxCycleLength)
+    {
+        plan.cycle = maxCycleLength;
+        plan.capped = true;
+    }
+
+    double effectiveG = plan.cycle - plan.totalLoss;   // total effective green time
+
+    for(double y : critical)
+        plan.greenSplit.push_back(std::min(std::max(minGreen, (y / plan.Y) * effectiveG), maxGreen));
+
+    return plan;
+}
+
+}
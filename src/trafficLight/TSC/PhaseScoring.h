@@ -0,0 +1,136 @@
+/****************************************************************************/
+/// @file    PhaseScoring.h
+/// @author  Mani Amoozadeh <maniam@ucdavis.edu>
+/// @author  second author name
+/// @date    October 2017
+///
+/****************************************************************************/
+// VENTOS, Vehicular Network Open Simulator; see http:?
+// Copyright (C) 2013-2015
+/****************************************************************************/
+//
+// This file is part of VENTOS.
+// VENTOS is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#ifndef PHASESCORING_H
+#define PHASESCORING_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <stdint.h>
+
+namespace VENTOS {
+
+// load of an incoming lane, filled by the TSC before each decision
+typedef struct laneLoad
+{
+    double weight;      // total class weight of the queued vehicles
+    double delay;       // total delay of the vehicles
+    double maxDelay;    // maximum (waiting) delay of the vehicles
+    int count;          // number of vehicles
+} laneLoad_t;
+
+// score of one phase (set of green links)
+typedef struct phaseScore
+{
+    double totalWeight;
+    double totalDelay;
+    double maxDelay;
+    int oneCount;       // number of green links, including right turns
+    int maxVehCount;    // largest lane count over the green links
+    int totalCount;     // lane count summed over the green links
+} phaseScore_t;
+
+// result of the Webster method for one cycle
+typedef struct websterPlan
+{
+    double Y;                           // total critical flow ratio
+    double totalLoss;                   // lost time in the cycle
+    double cycle;                       // cycle length, 0 if there is no demand
+    bool capped;                        // the cycle length is limited to maxCycleLength
+    std::vector<double> greenSplit;     // green time of each phase, empty if Y is not in [0,1)
+} websterPlan_t;
+
+// Scoring kernel shared by the queue-based TSCs (LQF_NoStarv, OJF, LQF_MWM, LQF_MWM_Aging, FMSC).
+// Each phase is stored as a bitmask of its green links, and each link points to
+// the index of its incoming lane. A decision fills the lane loads once and then
+// scores all phases in O(phases x links) without any lookup by name or allocation.
+class PhaseScoring
+{
+private:
+    int numLinks = 0;
+    uint64_t rightTurnMask = 0;             // right turns are permissive and carry no load
+    std::vector<int> linkLane;              // link -> lane index, -1 if the link has no incoming lane
+    std::vector<std::string> lanes;         // lane index -> lane id
+    std::vector<uint64_t> phaseMasks;
+
+    std::vector<laneLoad_t> loads;          // indexed by lane index
+    std::vector<laneLoad_t> linkLoads;      // indexed by link number
+    std::vector<phaseScore_t> scores;       // indexed by phase
+
+public:
+    // controlledLinks is the result of TraCI->TLGetControlledLinks (the incoming lane comes first)
+    void build(const std::map<int, std::vector<std::string>> &controlledLinks, uint64_t rightTurnMask);
+    bool isBuilt() const { return numLinks > 0; }
+
+    // a phase is either a TL state (only 'G' is green) or a row of allMovements (1 is green)
+    int addPhase(const std::string &state);
+    int addPhase(const std::vector<int> &movement);
+    int getPhaseCount() const { return phaseMasks.size(); }
+
+    const std::vector<std::string> & getLanes() const { return lanes; }
+    std::vector<laneLoad_t> & getLoads() { return loads; }
+
+    // scores all phases with the current lane loads
+    const std::vector<phaseScore_t> & score();
+
+    // phase selection rules of the TSCs. They read the scores of the last call to score().
+    // Ties are broken in favor of the phase that was added first
+    int bestByWeight() const;       // LQF_MWM: totalWeight, then oneCount
+    int bestByDelay() const;        // OJF: totalDelay, then oneCount
+    int bestByMaxDelay() const;     // LQF_MWM_Aging: maxDelay, then totalWeight, then oneCount
+    // LQF_MWM_Aging: bestByWeight, unless a vehicle would wait longer than maxWaitingTime
+    // by the end of the yellow and red intervals (clearanceTime). Then bestByMaxDelay
+    int bestByWeightAging(double clearanceTime) const;
+    // FMSC: phases in the order of totalWeight, totalDelay and oneCount. A phase
+    // is skipped if it shares a green link with a phase that is already chosen
+    std::vector<int> cycleByWeight() const;
+    // LQF_NoStarv: same as cycleByWeight, in the order of totalCount and oneCount.
+    // Phases with only right turns are skipped too
+    std::vector<int> cycleByQueue() const;
+
+    // green time of each phase of a cycle (FMSC, LQF_NoStarv). A phase with empty queues
+    // is dropped, unless the whole intersection is empty. Then each phase gets minGreen
+    std::vector<std::pair<int /*phase*/, double /*green time*/>> cycleGreenTimes(const std::vector<int> &cycle, double minGreen, double maxGreen) const;
+
+    // the longest waiting time that LQF_MWM_Aging tolerates
+    static constexpr double maxWaitingTime = 20;
+
+    // enough green time to move maxVehCount vehicles (5 vehicles in minGreen), bounded by [minGreen, maxGreen]
+    static double boundedGreen(int maxVehCount, double minGreen, double maxGreen);
+
+    // Webster: cycle length and green splits from the critical flow ratio (demand / saturation) of each phase
+    static websterPlan_t webster(const std::vector<double> &critical, double changeInterval, double maxCycleLength, double minGreen, double maxGreen);
+
+private:
+    int addPhaseMask(uint64_t mask);
+};
+
+}
+
+#endif
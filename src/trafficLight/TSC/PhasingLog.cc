@@ -0,0 +1,184 @@
+/****************************************************************************/
+/// @file    PhasingLog.cc
+/// @author  Mani Amoozadeh <maniam@ucdavis.edu>
+/// @author  second author name
+/// @date    October 2017
+///
+/****************************************************************************/
+// VENTOS, Vehicular Network Open Simulator; see http:?
+// Copyright (C) 2013-2015
+/****************************************************************************/
+//
+// This file is part of VENTOS.
+// VENTOS is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+
+#include "trafficLight/TSC/PhasingLog.h"
+
+namespace VENTOS {
+
+static const uint32_t phasingMagic = 0x48504c54;  // TLPH
+static const uint32_t phasingVersion = 2;
+
+
+void PhasingLog::writeHeader(FILE *filePtr)
+{
+    uint32_t header[3] = {phasingMagic, phasingVersion, sizeof(phasingRecord_t)};
+    fwrite(header, sizeof(header), 1, filePtr);
+}
+
+
+static void appendBytes(std::vector<char> &chunk, const void *data, size_t len)
+{
+    const char *bytes = static_cast<const char *>(data);
+    chunk.insert(chunk.end(), bytes, bytes + len);
+}
+
+
+void PhasingLog::appendString(std::vector<char> &chunk, entryTag tag, uint32_t index, const std::string &str)
+{
+    uint32_t entry[3] = {tag, index, (uint32_t)str.size()};
+    appendBytes(chunk, entry, sizeof(entry));
+    appendBytes(chunk, str.data(), str.size());
+}
+
+
+void PhasingLog::appendRecord(std::vector<char> &chunk, const phasingRecord_t &record)
+{
+    uint32_t tag = PHASE;
+    appendBytes(chunk, &tag, sizeof(tag));
+    appendBytes(chunk, &record, sizeof(record));
+}
+
+
+bool PhasingLog::convert(const std::string &binFile, FILE *filePtr)
+{
+    FILE *binPtr = fopen (binFile.c_str(), "rb");
+    if (!binPtr)
+        throw std::runtime_error("Cannot open file '" + binFile + "'");
+
+    uint32_t header[3];
+    if(fread(header, sizeof(header), 1, binPtr) != 1 || header[0] != phasingMagic || header[1] != phasingVersion || header[2] != sizeof(phasingRecord_t))
+    {
+        fclose(binPtr);
+        throw std::runtime_error("'" + binFile + "' is not a phasing log of this version");
+    }
+
+    std::vector<phasingRecord_t> records;
+    std::vector<std::string> TLs, intervals;
+    bool truncated = false;
+    bool corrupted = false;
+
+    fseek(binPtr, 0, SEEK_END);
+    long fileSize = ftell(binPtr);
+    fseek(binPtr, sizeof(header), SEEK_SET);
+
+    uint32_t tag;
+    long entryStart = sizeof(header);
+    while(!corrupted && fread(&tag, sizeof(tag), 1, binPtr) == 1)
+    {
+        if(tag == PHASE)
+        {
+            phasingRecord_t record;
+            if(fread(&record, sizeof(record), 1, binPtr) != 1)
+            {
+                truncated = true;
+                break;
+            }
+
+            // strings are defined before they are used
+            if(record.TL >= TLs.size() || record.allowedMovements >= intervals.size())
+                corrupted = true;
+            else
+                records.push_back(record);
+        }
+        else if(tag == TL_NAME || tag == INTERVAL_NAME)
+        {
+            std::vector<std::string> &table = (tag == TL_NAME) ? TLs : intervals;
+
+            uint32_t entry[2];  // index, length
+            if(fread(entry, sizeof(entry), 1, binPtr) != 1)
+            {
+                truncated = true;
+                break;
+            }
+
+            std::string str(entry[1], '\0');
+            if(entry[1] != 0 && fread(&str[0], 1, entry[1], binPtr) != entry[1])
+            {
+                truncated = true;
+                break;
+            }
+
+            // strings are interned in order
+            if(entry[0] != table.size())
+                corrupted = true;
+            else
+                table.push_back(str);
+        }
+        else
+            corrupted = true;
+
+        entryStart = ftell(binPtr);
+    }
+
+    // a tag cut off at the end of the file
+    if(!corrupted && !truncated)
+        truncated = (entryStart != fileSize);
+
+    fclose(binPtr);
+
+    if(corrupted)
+        throw std::runtime_error("Phasing log '" + binFile + "' is corrupted");
+
+    std::stable_sort(records.begin(), records.end(), [&TLs](const phasingRecord_t &a, const phasingRecord_t &b) {
+        if(a.TL != b.TL)
+            return TLs[a.TL] < TLs[b.TL];
+        return a.phase < b.phase;
+    });
+
+    // write header
+    fprintf (filePtr, "%-12s", "TLid");
+    fprintf (filePtr, "%-12s", "phase");
+    fprintf (filePtr, "%-12s", "cycle");
+    fprintf (filePtr, "%-35s", "allowedMovements");
+    fprintf (filePtr, "%-15s", "greenLength");
+    fprintf (filePtr, "%-15s", "greenStart");
+    fprintf (filePtr, "%-15s", "yellowStart");
+    fprintf (filePtr, "%-15s", "redStart");
+    fprintf (filePtr, "%-15s \n\n", "phaseEnd");
+
+    // write body
+    for(auto &record : records)
+    {
+        fprintf (filePtr, "%-12s", TLs[record.TL].c_str());
+        fprintf (filePtr, "%-12d", (int)record.phase);
+        fprintf (filePtr, "%-12d", (int)record.cycle);
+        fprintf (filePtr, "%-35s", intervals[record.allowedMovements].c_str());
+        fprintf (filePtr, "%-15.2f", record.greenLength);
+        fprintf (filePtr, "%-15.2f", record.greenStart);
+        fprintf (filePtr, "%-15.2f", record.yellowStart);
+        fprintf (filePtr, "%-15.2f", record.redStart);
+        fprintf (filePtr, "%-15.2f \n", record.phaseEnd);
+    }
+
+    return truncated;
+}
+
+}
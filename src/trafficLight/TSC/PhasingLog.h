@@ -0,0 +1,77 @@
+/****************************************************************************/
+/// @file    PhasingLog.h
+/// @author  Mani Amoozadeh <maniam@ucdavis.edu>
+/// @author  second author name
+/// @date    October 2017
+///
+/****************************************************************************/
+// VENTOS, Vehicular Network Open Simulator; see http:?
+// Copyright (C) 2013-2015
+/****************************************************************************/
+//
+// This file is part of VENTOS.
+// VENTOS is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#ifndef PHASINGLOG_H
+#define PHASINGLOG_H
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+namespace VENTOS {
+
+// one fixed-width record per phase in the phasing log. Strings are
+// interned and stored as indices into the TL and interval tables
+typedef struct phasingRecord
+{
+    uint32_t TL;
+    uint32_t phase;
+    uint32_t cycle;
+    uint32_t allowedMovements;
+    double greenLength;
+    double greenStart;
+    double yellowStart;
+    double redStart;
+    double phaseEnd;
+} phasingRecord_t;
+
+// Binary TL phasing log (results/*_TLphasingData.bin). The file starts with a
+// header and is followed by tagged entries. A string is defined by an entry
+// before the first record that uses it, so any prefix of the file can be decoded.
+// Used by TLStateRecord and the standalone converter in trafficLight/PhasingConvert
+class PhasingLog
+{
+public:
+    enum entryTag : uint32_t { TL_NAME = 1, INTERVAL_NAME = 2, PHASE = 3 };
+
+    static void writeHeader(FILE *filePtr);
+
+    // entries are appended to a chunk that is written to the file as a whole
+    static void appendString(std::vector<char> &chunk, entryTag tag, uint32_t index, const std::string &str);
+    static void appendRecord(std::vector<char> &chunk, const phasingRecord_t &record);
+
+    // writes the phasing log as the text table of results/*_TLphasingData.txt. Rows
+    // are sorted by TL id and phase number, as in the text output of older versions.
+    // An entry cut off at the end of the file (a crashed or running simulation) is
+    // dropped and true is returned. Throws std::runtime_error on malformed logs
+    static bool convert(const std::string &binFile, FILE *txtFile);
+};
+
+}
+
+#endif
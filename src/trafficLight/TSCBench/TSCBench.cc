@@ -0,0 +1,1061 @@
+/****************************************************************************/
+/// @file    TSCBench.cc
+/// @author  Mani Amoozadeh <maniam@ucdavis.edu>
+/// @author  second author name
+/// @date    October 2017
+///
+/****************************************************************************/
+// VENTOS, Vehicular Network Open Simulator; see http:?
+// Copyright (C) 2013-2015
+/****************************************************************************/
+//
+// This file is part of VENTOS.
+// VENTOS is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+// Offline evaluation of the TSC decision rules without SUMO and OMNeT++.
+//
+// The intersection of examples/traffic_intersection (TL 'C', 24 links) is
+// modeled as a set of point queues, one per incoming lane. Vehicles arrive from
+// a synthetic (Poisson) or a recorded trace, wait in FIFO order and leave with
+// a saturation headway when the link of the first vehicle is green. All
+// controllers see the same arrivals.
+//
+// The adaptive controllers (Webster, LQF_NoStarv, OJF, LQF_MWM, LQF_MWM_Aging,
+// FMSC) make their decisions with the same PhaseScoring rules as the TSC modules.
+// LQF_NoStarv and OJF choose from all non-conflicting movements, like the modules.
+// TrafficActuated runs the phase transitions of TrafficLightActuated on detector
+// actuations taken from the arrivals. Fixed-time control is the baseline.
+//
+// usage: TSCBench [-d duration] [-s seed] [-f demand factor] [-t trace file] [-c controller,...]
+//
+// A trace file has one arrival per line: 'time lane vehicleType [linkIndex]'
+// (e.g. '12.5 NC_3 passenger 3'). Lines starting with '#' are ignored.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <memory>
+#include <random>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+#include "trafficLight/TSC/PhaseScoring.h"
+
+namespace VENTOS {
+
+// same as TLStateRecord
+const int LINKSIZE = 24;
+
+// same as TLStateRecord
+const std::vector<std::string> phases = {
+        "grgrGgrgrrgrgrGgrgrrrrrr",  // phase1_5
+        "gGgGrgrgrrgGgGrgrgrrrGrG",  // phase2_6
+        "grgrrgrgrGgrgrrgrgrGrrrr",  // phase3_7
+        "grgrrgGgGrgrgrrgGgGrGrGr"   // phase4_8
+};
+
+// same as TLStateRecord. The phases of TrafficActuated
+const std::string phase1_5 = "grgrGgrgrrgrgrGgrgrrrrrr";
+const std::string phase2_5 = "gGgGGgrgrrgrgrrgrgrrrrrG";
+const std::string phase1_6 = "grgrrgrgrrgGgGGgrgrrrGrr";
+const std::string phase2_6 = "gGgGrgrgrrgGgGrgrgrrrGrG";
+
+const std::string phase3_7 = "grgrrgrgrGgrgrrgrgrGrrrr";
+const std::string phase3_8 = "grgrrgrgrrgrgrrgGgGGrrGr";
+const std::string phase4_7 = "grgrrgGgGGgrgrrgrgrrGrrr";
+const std::string phase4_8 = "grgrrgGgGrgrgrrgGgGrGrGr";
+
+// same as TLStateRecord
+const std::map<std::string, double> classWeight = {
+        {"emergency", 50},
+        {"bicycle", 40},
+        {"pedestrian", 30},
+        {"passenger", 20},
+        {"bus", 10},
+        {"truck", 1}
+};
+
+// default values of the TL module in trafficLight/modules.ned
+typedef struct timing
+{
+    double minGreenTime = 8.3;
+    double maxGreenTime = 20.0;
+    double yellowTime = 4.0;
+    double redTime = 2.0;
+    double fixedGreenTime = 20.0;   // green of each phase in the fix-time program
+    double maxCycleLength = 120.0;
+    double alpha = 0.125;           // weight of a new traffic demand sample in its moving average
+    double saturationTD = 2000.0;   // veh/h (see IntersectionDemand)
+    double updateInterval = 1.0;    // the time step of the bench
+    bool greenExtension = true;
+} timing_t;
+
+typedef struct arrival
+{
+    double time;
+    int lane;
+    int link;
+    std::string vehType;
+} arrival_t;
+
+typedef struct queuedVeh
+{
+    double arrivalTime;
+    int link;
+    double weight;
+    double headway;     // saturation headway of this vehicle
+} queuedVeh_t;
+
+typedef struct laneDef
+{
+    std::string id;
+    std::vector<int> links;
+    std::vector<double> linkShare;      // share of the arrivals on each link
+    double flow;                        // veh/h in the synthetic demand
+    double LDPos;                       // distance of the actuated loop detector to the stop line (m)
+    std::vector<std::pair<std::string, double>> mix;   // vehicle types and their shares
+} laneDef_t;
+
+
+// incoming lanes of TL 'C' (see examples/traffic_intersection/sumocfg/04.plain.net.xml).
+// The actuated loop detectors are in sumocfg/07.loopDetector.xml
+std::vector<laneDef_t> buildLanes()
+{
+    std::vector<laneDef_t> lanes;
+
+    std::vector<std::pair<std::string, double>> vehMix = {{"passenger", 0.90}, {"bus", 0.05}, {"truck", 0.04}, {"emergency", 0.01}};
+    std::vector<std::pair<std::string, double>> bikeMix = {{"bicycle", 1.}};
+
+    const char *approaches[] = {"NC", "EC", "SC", "WC"};
+    for(int a = 0; a < 4; a++)
+    {
+        int k = 5 * a;
+        std::string edge = approaches[a];
+
+        lanes.push_back({edge + "_2", {k, k+1}, {0.3, 0.7}, 60, 15, bikeMix});     // bike lane: right, straight
+        lanes.push_back({edge + "_3", {k+2, k+3}, {0.3, 0.7}, 500, 35, vehMix});   // right, straight
+        lanes.push_back({edge + "_4", {k+4}, {1.}, 150, 35, vehMix});              // left
+    }
+
+    // pedestrian crossings
+    for(int c = 0; c < 4; c++)
+        lanes.push_back({":C_w" + std::to_string(c) + "_0", {20 + c}, {1.}, 0, 0, {}});
+
+    return lanes;
+}
+
+
+// right turns are permissive ('g' in all phases)
+uint64_t rightTurnMask()
+{
+    uint64_t mask = 0;
+    for(int a = 0; a < 4; a++)
+        mask |= ((uint64_t)1 << (5 * a)) | ((uint64_t)1 << (5 * a + 2));
+
+    return mask;
+}
+
+
+// conflicting links of TL 'C' (see TrafficLightAllowedMoves::defaultConflicts)
+std::vector<uint64_t> conflicts()
+{
+    const std::map<int, std::vector<int>> conflictList =
+    {
+            {1, {8, 9, 14, 18, 19, 6, 16, 20, 22}},
+            {3, {8, 9, 14, 18, 19, 6, 16, 20, 22}},
+            {4, {8, 9, 13, 18, 19, 6, 11, 16, 20, 21}},
+            {6, {3, 4, 13, 14, 19, 1, 11, 21, 23}},
+            {8, {3, 4, 13, 14, 19, 1, 11, 21, 23}},
+            {9, {3, 4, 13, 14, 18, 1, 11, 16, 21, 22}},
+            {11, {4, 8, 9, 18, 19, 6, 16, 20, 22}},
+            {13, {4, 8, 9, 18, 19, 6, 16, 20, 22}},
+            {14, {3, 8, 9, 18, 19, 1, 6, 16, 22, 23}},
+            {16, {3, 4, 9, 13, 14, 1, 11, 21, 23}},
+            {18, {3, 4, 9, 13, 14, 1, 11, 21, 23}},
+            {19, {3, 4, 8, 13, 14, 1, 6, 11, 20, 23}},
+            {20, {3, 4, 13, 19, 1, 11}},
+            {21, {4, 8, 9, 18, 6, 16}},
+            {22, {3, 9, 13, 14, 1, 11}},
+            {23, {8, 14, 18, 19, 6, 16}},
+    };
+
+    std::vector<uint64_t> conflicts(LINKSIZE, 0);
+    for(auto &entry : conflictList)
+    {
+        for(int j : entry.second)
+        {
+            conflicts[entry.first] |= (uint64_t)1 << j;
+            conflicts[j] |= (uint64_t)1 << entry.first;
+        }
+    }
+
+    return conflicts;
+}
+
+
+// all non-conflicting movements in the order of TrafficLightAllowedMoves::getMovements
+void enumerateMovements(int link, uint64_t chosen, const std::vector<uint64_t> &conflicts, std::vector<int> &row, std::vector<std::vector<int>> &movements)
+{
+    if(link == LINKSIZE)
+    {
+        if(chosen != 0)
+            movements.push_back(row);
+
+        return;
+    }
+
+    if((rightTurnMask() >> link) & 1)
+    {
+        enumerateMovements(link + 1, chosen, conflicts, row, movements);
+        return;
+    }
+
+    enumerateMovements(link + 1, chosen, conflicts, row, movements);
+
+    if((conflicts[link] & chosen) == 0)
+    {
+        row[link] = 1;
+        enumerateMovements(link + 1, chosen | ((uint64_t)1 << link), conflicts, row, movements);
+        row[link] = 0;
+    }
+}
+
+
+std::vector<std::vector<int>> allMovements()
+{
+    std::vector<int> row(LINKSIZE, 0);
+    for(int i = 0; i < LINKSIZE; i++)
+        if((rightTurnMask() >> i) & 1)
+            row[i] = 1;
+
+    std::vector<std::vector<int>> movements;
+    enumerateMovements(0, rightTurnMask(), conflicts(), row, movements);
+
+    return movements;
+}
+
+
+// right turns are given 'g'
+std::string movementState(const std::vector<int> &row)
+{
+    std::string state = "";
+    for(unsigned int link = 0; link < row.size(); link++)
+        state += (row[link] == 0) ? 'r' : (((rightTurnMask() >> link) & 1) ? 'g' : 'G');
+
+    return state;
+}
+
+
+class Intersection
+{
+public:
+    std::vector<laneDef_t> lanes;
+    std::vector<std::deque<queuedVeh_t>> queues;
+    std::vector<double> nextDeparture;
+
+    PhaseScoring scoring;           // one phase per entry of 'phases'
+    PhaseScoring movementScoring;   // one phase per non-conflicting movement
+    std::vector<std::string> movementStates;
+
+    // arrivals on each link, used to measure the traffic demand
+    std::vector<long> linkArrivals;
+
+    // last time a vehicle passed the actuated loop detector of each lane. A vehicle
+    // passes the detector when it arrives
+    std::vector<double> lastDetection;
+
+    // statistics
+    long served = 0;
+    double totalDelay = 0;
+    double maxDelay = 0;
+
+    Intersection()
+    {
+        lanes = buildLanes();
+        queues.resize(lanes.size());
+        nextDeparture.assign(lanes.size(), 0);
+
+        std::map<int, std::vector<std::string>> controlledLinks;
+        for(auto &lane : lanes)
+            for(int link : lane.links)
+                controlledLinks[link] = {lane.id};
+
+        scoring.build(controlledLinks, rightTurnMask());
+        for(auto &phase : phases)
+            scoring.addPhase(phase);
+
+        movementScoring.build(controlledLinks, rightTurnMask());
+        for(auto &row : allMovements())
+        {
+            movementScoring.addPhase(row);
+            movementStates.push_back(movementState(row));
+        }
+
+        linkArrivals.assign(LINKSIZE, 0);
+        lastDetection.assign(lanes.size(), -std::numeric_limits<double>::infinity());
+    }
+
+    int laneIndex(const std::string &id) const
+    {
+        for(unsigned int i = 0; i < lanes.size(); i++)
+            if(lanes[i].id == id)
+                return i;
+
+        return -1;
+    }
+
+    // fills the lane loads of a scoring kernel. Every vehicle in a point queue is
+    // waiting, so the load of a lane is computed over all of its vehicles
+    void loadQueues(PhaseScoring &scoring, double now)
+    {
+        const std::vector<std::string> &scoringLanes = scoring.getLanes();
+        std::vector<laneLoad_t> &loads = scoring.getLoads();
+
+        for(unsigned int i = 0; i < scoringLanes.size(); i++)
+        {
+            laneLoad_t &load = loads[i];
+            load = laneLoad_t();
+
+            int lane = laneIndex(scoringLanes[i]);
+            for(auto &veh : queues[lane])
+            {
+                double delay = now - veh.arrivalTime;
+
+                load.weight += veh.weight;
+                load.delay += delay;
+                load.maxDelay = std::max(load.maxDelay, delay);
+                load.count++;
+            }
+        }
+    }
+
+    int vehCount() const
+    {
+        int count = 0;
+        for(auto &q : queues)
+            count += q.size();
+
+        return count;
+    }
+};
+
+
+// a controller is asked for the next green interval at the end of each green interval.
+// The next green interval is the current one if the green interval is extended
+class Controller
+{
+public:
+    virtual ~Controller() {}
+    virtual std::string name() const = 0;
+    virtual void decide(Intersection &, double now, const std::string &current, std::string &next, double &greenTime) = 0;
+
+protected:
+    timing_t timing;
+
+public:
+    void setTiming(const timing_t &t) { timing = t; }
+};
+
+
+class Fixed : public Controller
+{
+    unsigned int phase = 0;
+
+public:
+    std::string name() const { return "Fixed"; }
+
+    void decide(Intersection &, double, const std::string &, std::string &next, double &greenTime)
+    {
+        phase = (phase + 1) % phases.size();
+
+        next = phases[phase];
+        greenTime = timing.fixedGreenTime;
+    }
+};
+
+
+// the phases are run in order. The green splits are calculated at the beginning of each cycle.
+// The traffic demand of a link is its arrival rate in the last cycle (trafficDemandMode 2 of
+// IntersectionDemand), averaged over the cycles with alpha
+class Webster : public Controller
+{
+    unsigned int phase = 0;
+    std::vector<double> greenSplit;
+
+    double lastCycle = 0;
+    std::vector<long> lastArrivals = std::vector<long>(LINKSIZE, 0);
+    std::vector<double> linkTD = std::vector<double>(LINKSIZE, 0);
+
+public:
+    std::string name() const { return "Webster"; }
+
+    void decide(Intersection &I, double now, const std::string &, std::string &next, double &greenTime)
+    {
+        phase = (phase + 1) % phases.size();
+        if(phase == 0 || greenSplit.empty())
+        {
+            measureDemand(I, now);
+            calculateGreenSplits(I);
+        }
+
+        next = phases[phase];
+        greenTime = greenSplit[phase];
+    }
+
+private:
+    void measureDemand(Intersection &I, double now)
+    {
+        if(now <= lastCycle)
+            return;
+
+        for(int link = 0; link < LINKSIZE; link++)
+        {
+            double TD = 3600. * (I.linkArrivals[link] - lastArrivals[link]) / (now - lastCycle);
+            TD = std::min(TD, timing.saturationTD);
+
+            linkTD[link] = timing.alpha * TD + (1 - timing.alpha) * linkTD[link];
+            lastArrivals[link] = I.linkArrivals[link];
+        }
+
+        lastCycle = now;
+    }
+
+    void calculateGreenSplits(Intersection &)
+    {
+        // critical volume-to-capacity ratio of each phase over its active links that are not right turns
+        std::vector<double> critical;
+        for(auto &state : phases)
+        {
+            double Y_i = -1;
+            for(int link = 0; link < LINKSIZE; link++)
+                if((state[link] == 'g' || state[link] == 'G') && !((rightTurnMask() >> link) & 1))
+                    Y_i = std::max(Y_i, linkTD[link] / timing.saturationTD);
+
+            critical.push_back(Y_i);
+        }
+
+        websterPlan_t plan = PhaseScoring::webster(critical, timing.yellowTime + timing.redTime, timing.maxCycleLength, timing.minGreenTime, timing.maxGreenTime);
+        if(plan.greenSplit.empty())
+            throw std::runtime_error("Webster: total critical v/c is " + std::to_string(plan.Y) + ". Saturation flow might be low ?!");
+
+        greenSplit = plan.greenSplit;
+    }
+};
+
+
+// the phase transitions of TrafficLightActuated. The passage time of a lane is the distance
+// of its detector to the stop line over the speed limit (30 m/s), like passageTime = -1 in the
+// module before any vehicle passes the detector
+class TrafficActuated : public Controller
+{
+    std::string green = "";
+    double greenElapsed = 0;
+
+public:
+    std::string name() const { return "TrafficActuated"; }
+
+    void decide(Intersection &I, double now, const std::string &current, std::string &next, double &greenTime)
+    {
+        // a new green interval starts with minGreenTime
+        if(current != green)
+        {
+            green = current;
+            greenElapsed = timing.minGreenTime;
+        }
+
+        bool extend = chooseNextGreenInterval(I, now, timing.greenExtension && greenElapsed < timing.maxGreenTime, next, greenTime);
+        if(extend)
+        {
+            // give a lower bound
+            greenTime = std::max(timing.updateInterval, greenTime);
+
+            // never extend past maxGreenTime
+            greenTime = std::min(greenTime, timing.maxGreenTime - greenElapsed);
+
+            // offset can not be too small. Terminate the current phase
+            if(greenTime < timing.updateInterval)
+                extend = chooseNextGreenInterval(I, now, false, next, greenTime);
+        }
+
+        if(extend)
+            greenElapsed += greenTime;
+        else
+            greenTime = timing.minGreenTime;
+    }
+
+private:
+    // returns true if the current green interval is extended by greenTime
+    bool chooseNextGreenInterval(Intersection &I, double now, bool extension, std::string &next, double &greenTime)
+    {
+        auto gap = [&](const char *lane) {
+            const laneDef_t &def = I.lanes[I.laneIndex(lane)];
+            double passage = def.LDPos / 30.;
+            double lastActuated = now - I.lastDetection[I.laneIndex(lane)];
+            return passage - lastActuated;
+        };
+
+        auto actuated = [&](const char *lane) { return gap(lane) > 0; };
+
+        next = green;
+
+        if(green == phase1_5)
+        {
+            if(extension && actuated("NC_4") && actuated("SC_4"))
+            {
+                greenTime = std::max(gap("NC_4"), gap("SC_4"));
+                return true;
+            }
+            else if(actuated("NC_4"))
+                next = phase2_5;
+            else if(actuated("SC_4"))
+                next = phase1_6;
+            else
+                next = phase2_6;
+        }
+        else if(green == phase2_5)
+        {
+            if(extension && actuated("NC_4"))
+            {
+                greenTime = gap("NC_4");
+                return true;
+            }
+            else
+                next = phase2_6;
+        }
+        else if(green == phase1_6)
+        {
+            if(extension && actuated("SC_4"))
+            {
+                greenTime = gap("SC_4");
+                return true;
+            }
+            else
+                next = phase2_6;
+        }
+        else if(green == phase2_6)
+        {
+            if(extension && (actuated("NC_2") || actuated("NC_3") || actuated("SC_2") || actuated("SC_3")))
+            {
+                greenTime = std::max(std::max(gap("NC_2"), gap("SC_2")), std::max(gap("NC_3"), gap("SC_3")));
+                return true;
+            }
+            else
+                next = phase3_7;
+        }
+        else if(green == phase3_7)
+        {
+            if(extension && actuated("WC_4") && actuated("EC_4"))
+            {
+                greenTime = std::max(gap("WC_4"), gap("EC_4"));
+                return true;
+            }
+            else if(actuated("WC_4"))
+                next = phase3_8;
+            else if(actuated("EC_4"))
+                next = phase4_7;
+            else
+                next = phase4_8;
+        }
+        else if(green == phase3_8)
+        {
+            if(extension && actuated("WC_4"))
+            {
+                greenTime = gap("WC_4");
+                return true;
+            }
+            else
+                next = phase4_8;
+        }
+        else if(green == phase4_7)
+        {
+            if(extension && actuated("EC_4"))
+            {
+                greenTime = gap("EC_4");
+                return true;
+            }
+            else
+                next = phase4_8;
+        }
+        else if(green == phase4_8)
+        {
+            if(extension && (actuated("WC_2") || actuated("WC_3") || actuated("EC_2") || actuated("EC_3")))
+            {
+                greenTime = std::max(std::max(gap("WC_2"), gap("EC_2")), std::max(gap("WC_3"), gap("EC_3")));
+                return true;
+            }
+            else
+                next = phase1_5;
+        }
+        else
+            throw std::runtime_error("TrafficActuated: unknown green interval '" + green + "'");
+
+        return false;
+    }
+};
+
+
+// the cycle is re-calculated when all of its phases are done
+class LQF_NoStarv : public Controller
+{
+    std::deque<std::pair<int, double>> greenInterval;
+
+public:
+    std::string name() const { return "LQF_NoStarv"; }
+
+    void decide(Intersection &I, double now, const std::string &, std::string &next, double &greenTime)
+    {
+        if(greenInterval.empty())
+            calculatePhases(I, now);
+
+        next = I.movementStates[greenInterval.front().first];
+        greenTime = greenInterval.front().second;
+        greenInterval.pop_front();
+    }
+
+private:
+    void calculatePhases(Intersection &I, double now)
+    {
+        I.loadQueues(I.movementScoring, now);
+        I.movementScoring.score();
+
+        std::vector<int> cycle = I.movementScoring.cycleByQueue();
+        for(auto &green : I.movementScoring.cycleGreenTimes(cycle, timing.minGreenTime, timing.maxGreenTime))
+            greenInterval.push_back(green);
+    }
+};
+
+
+class OJF : public Controller
+{
+public:
+    std::string name() const { return "OJF"; }
+
+    void decide(Intersection &I, double now, const std::string &, std::string &next, double &greenTime)
+    {
+        I.loadQueues(I.movementScoring, now);
+        const std::vector<phaseScore_t> &scores = I.movementScoring.score();
+
+        int best = I.movementScoring.bestByDelay();
+        next = I.movementStates[best];
+        greenTime = PhaseScoring::boundedGreen(scores[best].maxVehCount, timing.minGreenTime, timing.maxGreenTime);
+    }
+};
+
+
+class LQF_MWM : public Controller
+{
+public:
+    std::string name() const { return "LQF_MWM"; }
+
+    void decide(Intersection &I, double now, const std::string &, std::string &next, double &greenTime)
+    {
+        I.loadQueues(I.scoring, now);
+        const std::vector<phaseScore_t> &scores = I.scoring.score();
+
+        int best = I.scoring.bestByWeight();
+        next = phases[best];
+        greenTime = PhaseScoring::boundedGreen(scores[best].maxVehCount, timing.minGreenTime, timing.maxGreenTime);
+    }
+};
+
+
+class LQF_MWM_Aging : public Controller
+{
+public:
+    std::string name() const { return "LQF_MWM_Aging"; }
+
+    void decide(Intersection &I, double now, const std::string &, std::string &next, double &greenTime)
+    {
+        I.loadQueues(I.scoring, now);
+        const std::vector<phaseScore_t> &scores = I.scoring.score();
+
+        int best = I.scoring.bestByWeightAging(timing.yellowTime + timing.redTime);
+        next = phases[best];
+        greenTime = PhaseScoring::boundedGreen(scores[best].maxVehCount, timing.minGreenTime, timing.maxGreenTime);
+    }
+};
+
+
+class FMSC : public Controller
+{
+    std::deque<std::pair<int, double>> greenInterval;
+
+public:
+    std::string name() const { return "FMSC"; }
+
+    void decide(Intersection &I, double now, const std::string &, std::string &next, double &greenTime)
+    {
+        if(greenInterval.empty())
+            calculatePhases(I, now);
+
+        next = phases[greenInterval.front().first];
+        greenTime = greenInterval.front().second;
+        greenInterval.pop_front();
+    }
+
+private:
+    void calculatePhases(Intersection &I, double now)
+    {
+        I.loadQueues(I.scoring, now);
+        I.scoring.score();
+
+        std::vector<int> cycle = I.scoring.cycleByWeight();
+        for(auto &green : I.scoring.cycleGreenTimes(cycle, timing.minGreenTime, timing.maxGreenTime))
+            greenInterval.push_back(green);
+    }
+};
+
+
+typedef struct benchResult
+{
+    std::string name;
+    long decisions;
+    double meanLatency;     // us
+    double maxLatency;      // us
+    long arrived;
+    long served;
+    double throughput;      // veh/h
+    double meanDelay;       // s
+    double maxDelay;        // s
+    int leftInQueue;
+} benchResult_t;
+
+
+bool isGreen(char c)
+{
+    return c == 'G' || c == 'g';
+}
+
+
+// runs one controller over the arrivals with a time step of one second
+benchResult_t run(Controller &controller, const std::vector<arrival_t> &arrivals, double duration)
+{
+    const double step = 1.0;
+
+    Intersection I;
+    timing_t timing;
+
+    enum { GREEN, YELLOW, RED } interval = GREEN;
+    std::string current = phases[0];
+    std::string next = current;
+    double nextGreenTime = 0;
+    double intervalEnd = timing.minGreenTime;
+
+    long decisions = 0;
+    double totalLatency = 0;
+    double maxLatency = 0;
+
+    unsigned int nextArrival = 0;
+    long arrived = 0;
+
+    for(double now = 0; now < duration; now += step)
+    {
+        // arrivals up to now
+        while(nextArrival < arrivals.size() && arrivals[nextArrival].time <= now)
+        {
+            const arrival_t &a = arrivals[nextArrival++];
+
+            auto w = classWeight.find(a.vehType);
+            double weight = (w == classWeight.end()) ? 1 : w->second;
+            double headway = (a.vehType == "bicycle") ? 1.0 : 2.0;
+
+            I.queues[a.lane].push_back({a.time, a.link, weight, headway});
+            I.linkArrivals[a.link]++;
+            I.lastDetection[a.lane] = a.time;
+            arrived++;
+        }
+
+        // interval changes
+        while(now >= intervalEnd)
+        {
+            if(interval == GREEN)
+            {
+                auto start = std::chrono::steady_clock::now();
+                controller.decide(I, now, current, next, nextGreenTime);
+                double latency = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+                decisions++;
+                totalLatency += latency;
+                maxLatency = std::max(maxLatency, latency);
+
+                // a yellow interval is needed if a green link turns red
+                bool needYellowInterval = false;
+                for(unsigned int link = 0; link < current.size(); link++)
+                    if(isGreen(current[link]) && next[link] == 'r')
+                        needYellowInterval = true;
+
+                // extend the current green interval. Like the TSC modules, the TL
+                // state is kept even if the next green interval has more green links
+                if(!needYellowInterval)
+                    intervalEnd += nextGreenTime;
+                else
+                {
+                    interval = YELLOW;
+                    intervalEnd += timing.yellowTime;
+                }
+            }
+            else if(interval == YELLOW)
+            {
+                interval = RED;
+                intervalEnd += timing.redTime;
+            }
+            else
+            {
+                interval = GREEN;
+                current = next;
+                intervalEnd += nextGreenTime;
+            }
+        }
+
+        // departures. During yellow and red only the links that stay green can move
+        for(unsigned int lane = 0; lane < I.queues.size(); lane++)
+        {
+            auto &queue = I.queues[lane];
+            if(queue.empty() || I.nextDeparture[lane] > now)
+                continue;
+
+            const queuedVeh_t &veh = queue.front();
+            bool green = (interval == GREEN) ? isGreen(current[veh.link]) : (isGreen(current[veh.link]) && isGreen(next[veh.link]));
+            if(!green)
+                continue;
+
+            double delay = now - veh.arrivalTime;
+            I.served++;
+            I.totalDelay += delay;
+            I.maxDelay = std::max(I.maxDelay, delay);
+
+            I.nextDeparture[lane] = now + veh.headway;
+            queue.pop_front();
+        }
+    }
+
+    benchResult_t result;
+
+    result.name = controller.name();
+    result.decisions = decisions;
+    result.meanLatency = decisions ? totalLatency / decisions : 0;
+    result.maxLatency = maxLatency;
+    result.arrived = arrived;
+    result.served = I.served;
+    result.throughput = I.served * 3600. / duration;
+    result.meanDelay = I.served ? I.totalDelay / I.served : 0;
+    result.maxDelay = I.maxDelay;
+    result.leftInQueue = I.vehCount();
+
+    return result;
+}
+
+
+std::vector<arrival_t> syntheticArrivals(double duration, double demandFactor, unsigned int seed)
+{
+    std::vector<laneDef_t> lanes = buildLanes();
+    std::mt19937 gen(seed);
+    std::vector<arrival_t> arrivals;
+
+    for(unsigned int lane = 0; lane < lanes.size(); lane++)
+    {
+        const laneDef_t &def = lanes[lane];
+        double flow = def.flow * demandFactor;
+        if(flow <= 0)
+            continue;
+
+        std::exponential_distribution<double> headway(flow / 3600.);
+        std::discrete_distribution<int> link(def.linkShare.begin(), def.linkShare.end());
+
+        std::vector<double> shares;
+        for(auto &m : def.mix)
+            shares.push_back(m.second);
+        std::discrete_distribution<int> type(shares.begin(), shares.end());
+
+        for(double t = headway(gen); t < duration; t += headway(gen))
+            arrivals.push_back({t, (int)lane, def.links[link(gen)], def.mix[type(gen)].first});
+    }
+
+    std::stable_sort(arrivals.begin(), arrivals.end(), [](const arrival_t &a, const arrival_t &b) { return a.time < b.time; });
+
+    return arrivals;
+}
+
+
+std::vector<arrival_t> readTrace(const std::string &fileName)
+{
+    std::ifstream file(fileName);
+    if(!file)
+        throw std::runtime_error("Cannot open trace file '" + fileName + "'");
+
+    Intersection I;
+    std::vector<arrival_t> arrivals;
+    std::vector<int> nextLink(I.lanes.size(), 0);
+
+    std::string line;
+    int lineNumber = 0;
+    while(std::getline(file, line))
+    {
+        lineNumber++;
+        if(line.empty() || line[0] == '#')
+            continue;
+
+        std::istringstream str(line);
+        arrival_t a;
+        std::string laneId;
+        if(!(str >> a.time >> laneId >> a.vehType))
+            throw std::runtime_error("Malformed arrival at line " + std::to_string(lineNumber) + " of '" + fileName + "'");
+
+        a.lane = I.laneIndex(laneId);
+        if(a.lane == -1)
+            throw std::runtime_error("Unknown lane '" + laneId + "' at line " + std::to_string(lineNumber) + " of '" + fileName + "'");
+
+        // without a link index, the links of the lane are used in turn
+        const std::vector<int> &links = I.lanes[a.lane].links;
+        if(!(str >> a.link))
+        {
+            a.link = links[nextLink[a.lane]];
+            nextLink[a.lane] = (nextLink[a.lane] + 1) % links.size();
+        }
+        else if(std::find(links.begin(), links.end(), a.link) == links.end())
+            throw std::runtime_error("Lane '" + laneId + "' does not use link " + std::to_string(a.link) + " (line " + std::to_string(lineNumber) + ")");
+
+        arrivals.push_back(a);
+    }
+
+    std::stable_sort(arrivals.begin(), arrivals.end(), [](const arrival_t &a, const arrival_t &b) { return a.time < b.time; });
+
+    return arrivals;
+}
+
+
+std::unique_ptr<Controller> makeController(const std::string &name)
+{
+    if(name == "Fixed")
+        return std::unique_ptr<Controller>(new Fixed());
+    else if(name == "Webster")
+        return std::unique_ptr<Controller>(new Webster());
+    else if(name == "TrafficActuated")
+        return std::unique_ptr<Controller>(new TrafficActuated());
+    else if(name == "LQF_NoStarv")
+        return std::unique_ptr<Controller>(new LQF_NoStarv());
+    else if(name == "LQF_MWM")
+        return std::unique_ptr<Controller>(new LQF_MWM());
+    else if(name == "OJF")
+        return std::unique_ptr<Controller>(new OJF());
+    else if(name == "LQF_MWM_Aging")
+        return std::unique_ptr<Controller>(new LQF_MWM_Aging());
+    else if(name == "FMSC")
+        return std::unique_ptr<Controller>(new FMSC());
+
+    throw std::runtime_error("Unknown controller '" + name + "'");
+}
+
+}
+
+
+int main(int argc, char *argv[])
+{
+    using namespace VENTOS;
+
+    double duration = 3600;
+    double demandFactor = 1.;
+    unsigned int seed = 1;
+    std::string traceFile = "";
+    std::string controllerList = "Fixed,Webster,TrafficActuated,LQF_NoStarv,OJF,LQF_MWM,LQF_MWM_Aging,FMSC";
+
+    for(int i = 1; i < argc; i++)
+    {
+        std::string opt = argv[i];
+        if(i + 1 >= argc)
+        {
+            fprintf(stderr, "usage: %s [-d duration] [-s seed] [-f demand factor] [-t trace file] [-c controller,...] \n", argv[0]);
+            return 1;
+        }
+
+        if(opt == "-d")
+            duration = atof(argv[++i]);
+        else if(opt == "-s")
+            seed = atoi(argv[++i]);
+        else if(opt == "-f")
+            demandFactor = atof(argv[++i]);
+        else if(opt == "-t")
+            traceFile = argv[++i];
+        else if(opt == "-c")
+            controllerList = argv[++i];
+        else
+        {
+            fprintf(stderr, "unknown option '%s' \n", opt.c_str());
+            return 1;
+        }
+    }
+
+    try
+    {
+        std::vector<std::unique_ptr<Controller>> controllers;
+        std::istringstream names(controllerList);
+        std::string name;
+        while(std::getline(names, name, ','))
+            controllers.push_back(makeController(name));
+
+        std::vector<arrival_t> arrivals = traceFile.empty() ? syntheticArrivals(duration, demandFactor, seed) : readTrace(traceFile);
+
+        if(traceFile.empty())
+            printf("synthetic arrivals: seed %u, demand factor %.2f, duration %.0f s \n\n", seed, demandFactor, duration);
+        else
+            printf("trace '%s', duration %.0f s \n\n", traceFile.c_str(), duration);
+
+        printf("%-16s", "controller");
+        printf("%-12s", "decisions");
+        printf("%-15s", "meanLatency");
+        printf("%-15s", "maxLatency");
+        printf("%-10s", "arrived");
+        printf("%-10s", "served");
+        printf("%-14s", "throughput");
+        printf("%-12s", "meanDelay");
+        printf("%-12s", "maxDelay");
+        printf("%-10s \n", "inQueue");
+
+        for(auto &controller : controllers)
+        {
+            controller->setTiming(timing_t());
+
+            benchResult_t r = run(*controller, arrivals, duration);
+
+            printf("%-16s", r.name.c_str());
+            printf("%-12ld", r.decisions);
+            printf("%-15.3f", r.meanLatency);
+            printf("%-15.3f", r.maxLatency);
+            printf("%-10ld", r.arrived);
+            printf("%-10ld", r.served);
+            printf("%-14.1f", r.throughput);
+            printf("%-12.2f", r.meanDelay);
+            printf("%-12.2f", r.maxDelay);
+            printf("%-10d \n", r.leftInQueue);
+        }
+    }
+    catch(std::exception &e)
+    {
+        fprintf(stderr, "%s \n", e.what());
+        return 1;
+    }
+
+    return 0;
+}